@@ -327,6 +327,8 @@ $(OBJDIR)/src/deark-dbuf.o: src/deark-dbuf.c src/deark-config.h \
  src/deark-private.h src/deark.h
 $(OBJDIR)/src/deark-font.o: src/deark-font.c src/deark-config.h \
  src/deark-private.h src/deark.h
+$(OBJDIR)/src/deark-hash.o: src/deark-hash.c src/deark-config.h \
+ src/deark-private.h src/deark.h
 $(OBJDIR)/src/deark-modules.o: src/deark-modules.c src/deark-config.h \
  src/deark-private.h src/deark.h src/deark-user.h src/deark-modules.h
 $(OBJDIR)/src/deark-png.o: src/deark-png.c src/deark-config.h \
@@ -772,6 +772,10 @@ done:
 	de_dbg_indent_restore(c, saved_indent_level);
 }
 
+static const struct de_module_sig amiga_adf_sigs[] = {
+	{ 0, 3, 0, "DOS" }
+};
+
 static int de_identify_amiga_adf(deark *c)
 {
 	int has_size;
@@ -793,4 +797,6 @@ void de_module_amiga_adf(deark *c, struct deark_module_info *mi)
 	mi->desc = "Amiga disk image";
 	mi->run_fn = de_run_amiga_adf;
 	mi->identify_fn = de_identify_amiga_adf;
+	mi->sigs = amiga_adf_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(amiga_adf_sigs);
 }
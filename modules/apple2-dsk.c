@@ -727,6 +727,10 @@ static void de_run_woz(deark *c, de_module_params *mparams)
 	do_run_wozmoof(c, mparams, FMT_WOZ);
 }
 
+static const struct de_module_sig woz_sigs[] = {
+	{ 0, 3, 0, "WOZ" }
+};
+
 static int de_identify_woz(deark *c)
 {
 	if(dbuf_memcmp(c->infile, 0, "WOZ", 3))
@@ -743,6 +747,8 @@ void de_module_woz(deark *c, struct deark_module_info *mi)
 	mi->desc2 = "metadata only";
 	mi->run_fn = de_run_woz;
 	mi->identify_fn = de_identify_woz;
+	mi->sigs = woz_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(woz_sigs);
 }
 
 static void de_run_moof(deark *c, de_module_params *mparams)
@@ -750,12 +756,9 @@ static void de_run_moof(deark *c, de_module_params *mparams)
 	do_run_wozmoof(c, mparams, FMT_MOOF);
 }
 
-static int de_identify_moof(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "MOOF\xff\x0a\x0d\x0a", 8))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig moof_sigs[] = {
+	{ 0, 8, 100, "MOOF\xff\x0a\x0d\x0a" }
+};
 
 void de_module_moof(deark *c, struct deark_module_info *mi)
 {
@@ -763,5 +766,6 @@ void de_module_moof(deark *c, struct deark_module_info *mi)
 	mi->desc = "MOOF floppy disk image";
 	mi->desc2 = "metadata only";
 	mi->run_fn = de_run_moof;
-	mi->identify_fn = de_identify_moof;
+	mi->sigs = moof_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(moof_sigs);
 }
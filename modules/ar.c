@@ -176,17 +176,15 @@ static void de_run_ar(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_ar(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "!<arch>\x0a", 8))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig ar_sigs[] = {
+	{ 0, 8, 100, "!<arch>\x0a" }
+};
 
 void de_module_ar(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "ar";
 	mi->desc = "ar archive";
 	mi->run_fn = de_run_ar;
-	mi->identify_fn = de_identify_ar;
+	mi->sigs = ar_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ar_sigs);
 }
@@ -416,19 +416,17 @@ done:
 	}
 }
 
-static int de_identify_arcfs(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "Archive\x00", 8))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig arcfs_sigs[] = {
+	{ 0, 8, 100, "Archive\x00" }
+};
 
 void de_module_arcfs(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "arcfs";
 	mi->desc = "ArcFS (RISC OS archive)";
 	mi->run_fn = de_run_arcfs;
-	mi->identify_fn = de_identify_arcfs;
+	mi->sigs = arcfs_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(arcfs_sigs);
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -534,17 +532,15 @@ static void de_run_squash(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_squash(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "SQSH", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig squash_sigs[] = {
+	{ 0, 4, 100, "SQSH" }
+};
 
 void de_module_squash(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "squash";
 	mi->desc = "Squash (RISC OS compressed file)";
 	mi->run_fn = de_run_squash;
-	mi->identify_fn = de_identify_squash;
+	mi->sigs = squash_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(squash_sigs);
 }
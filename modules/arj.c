@@ -228,20 +228,23 @@ struct method4_ctx {
 	struct de_bitreader bitrd;
 };
 
-static void method4_lz77buf_writebytecb(struct de_lz77buffer *rb, const u8 n)
+static void method4_lz77buf_writespancb(struct de_lz77buffer *rb, const u8 *buf, UI len)
 {
 	struct method4_ctx *cctx = (struct method4_ctx*)rb->userdata;
 
 	if(cctx->stop_flag) return;
 	if(cctx->dcmpro->len_known) {
-		if(cctx->nbytes_written >= cctx->dcmpro->expected_len) {
+		i64 nbytes_wanted = cctx->dcmpro->expected_len - cctx->nbytes_written;
+
+		if((i64)len > nbytes_wanted) {
 			cctx->stop_flag = 1;
-			return;
+			if(nbytes_wanted<=0) return;
+			len = (UI)nbytes_wanted;
 		}
 	}
 
-	dbuf_writebyte(cctx->dcmpro->f, n);
-	cctx->nbytes_written++;
+	dbuf_write(cctx->dcmpro->f, buf, (i64)len);
+	cctx->nbytes_written += (i64)len;
 }
 
 static UI method4_read_a_length_code(struct method4_ctx *cctx)
@@ -313,7 +316,7 @@ static void decompress_method_4(deark *c, lctx *d, struct member_data *md,
 
 	// The maximum offset that can be encoded is 15871, so a 16K history is enough.
 	ringbuf = de_lz77buffer_create(c, 16384);
-	ringbuf->writebyte_cb = method4_lz77buf_writebytecb;
+	ringbuf->write_span_cb = method4_lz77buf_writespancb;
 	ringbuf->userdata = (void*)cctx;
 
 	while(1) {
@@ -1055,20 +1055,15 @@ static void de_run_asf(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_asf(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0,
-		"\x30\x26\xb2\x75\x8e\x66\xcf\x11\xa6\xd9\x00\xaa\x00\x62\xce\x6c", 16))
-	{
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig asf_sigs[] = {
+	{ 0, 16, 100, "\x30\x26\xb2\x75\x8e\x66\xcf\x11\xa6\xd9\x00\xaa\x00\x62\xce\x6c" }
+};
 
 void de_module_asf(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "asf";
 	mi->desc = "ASF, WMV, WMA";
 	mi->run_fn = de_run_asf;
-	mi->identify_fn = de_identify_asf;
+	mi->sigs = asf_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(asf_sigs);
 }
@@ -973,12 +973,9 @@ done:
 	}
 }
 
-static int de_identify_pasti(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "RSY\0", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig pasti_sigs[] = {
+	{ 0, 4, 100, "RSY\0" }
+};
 
 static void de_help_pasti(deark *c)
 {
@@ -990,6 +987,7 @@ void de_module_pasti(deark *c, struct deark_module_info *mi)
 	mi->id = "pasti";
 	mi->desc = "Pasti - Atari ST floppy disk image";
 	mi->run_fn = de_run_pasti;
-	mi->identify_fn = de_identify_pasti;
+	mi->sigs = pasti_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(pasti_sigs);
 	mi->help_fn = de_help_pasti;
 }
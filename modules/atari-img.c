@@ -408,19 +408,17 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_prismpaint(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "PNT\x00", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig prismpaint_sigs[] = {
+	{ 0, 4, 100, "PNT\x00" }
+};
 
 void de_module_prismpaint(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "prismpaint";
 	mi->desc = "Atari Prism Paint .PNT, a.k.a. TruePaint .TPI";
 	mi->run_fn = de_run_prismpaint;
-	mi->identify_fn = de_identify_prismpaint;
+	mi->sigs = prismpaint_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(prismpaint_sigs);
 }
 
 // **************************************************************************
@@ -495,23 +493,18 @@ static void de_run_eggpaint(deark *c, de_module_params *mparams)
 	de_free(c, adata);
 }
 
-static int de_identify_eggpaint(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "TRUP", 4)) {
-		return 80;
-	}
-	if(!dbuf_memcmp(c->infile, 0, "tru?", 4)) {
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig eggpaint_sigs[] = {
+	{ 0, 4, 80, "TRUP" },
+	{ 0, 4, 100, "tru?" }
+};
 
 void de_module_eggpaint(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "eggpaint";
 	mi->desc = "Atari EggPaint .TRP";
 	mi->run_fn = de_run_eggpaint;
-	mi->identify_fn = de_identify_eggpaint;
+	mi->sigs = eggpaint_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(eggpaint_sigs);
 }
 
 // **************************************************************************
@@ -537,20 +530,17 @@ static void de_run_indypaint(deark *c, de_module_params *mparams)
 	de_free(c, adata);
 }
 
-static int de_identify_indypaint(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "Indy", 4)) {
-		return 70;
-	}
-	return 0;
-}
+static const struct de_module_sig indypaint_sigs[] = {
+	{ 0, 4, 70, "Indy" }
+};
 
 void de_module_indypaint(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "indypaint";
 	mi->desc = "Atari IndyPaint .TRU";
 	mi->run_fn = de_run_indypaint;
-	mi->identify_fn = de_identify_indypaint;
+	mi->sigs = indypaint_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(indypaint_sigs);
 }
 
 // **************************************************************************
@@ -1139,20 +1129,17 @@ done:
 	de_free(c, adata);
 }
 
-static int de_identify_neochrome_ani(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\xba\xbe\xeb\xea", 4)) {
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig neochrome_ani_sigs[] = {
+	{ 0, 4, 100, "\xba\xbe\xeb\xea" }
+};
 
 void de_module_neochrome_ani(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "neochrome_ani";
 	mi->desc = "NEOchrome Animation";
 	mi->run_fn = de_run_neochrome_ani;
-	mi->identify_fn = de_identify_neochrome_ani;
+	mi->sigs = neochrome_ani_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(neochrome_ani_sigs);
 	mi->flags |= DE_MODFLAG_NONWORKING;
 }
 
@@ -1214,13 +1201,9 @@ done:
 	de_free(c, adata);
 }
 
-static int de_identify_animatic(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 48, "\x27\x18\x28\x18", 4)) {
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig animatic_sigs[] = {
+	{ 48, 4, 100, "\x27\x18\x28\x18" }
+};
 
 static void de_help_animatic(deark *c)
 {
@@ -1232,7 +1215,8 @@ void de_module_animatic(deark *c, struct deark_module_info *mi)
 	mi->id = "animatic";
 	mi->desc = "Animatic Film";
 	mi->run_fn = de_run_animatic;
-	mi->identify_fn = de_identify_animatic;
+	mi->sigs = animatic_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(animatic_sigs);
 	mi->help_fn = de_help_animatic;
 }
 
@@ -1485,20 +1469,17 @@ static void de_run_coke(deark *c, de_module_params *mparams)
 	de_finfo_destroy(c, fi);
 }
 
-static int de_identify_coke(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, (const void*)"COKE format.", 12)) {
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig coke_sigs[] = {
+	{ 0, 12, 100, "COKE format." }
+};
 
 void de_module_coke(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "coke";
 	mi->desc = "Atari Falcon COKE image (.TG1)";
 	mi->run_fn = de_run_coke;
-	mi->identify_fn = de_identify_coke;
+	mi->sigs = coke_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(coke_sigs);
 }
 
 // **************************************************************************
@@ -1566,18 +1547,15 @@ done:
 	de_finfo_destroy(c, fi);
 }
 
-static int de_identify_videomaster(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, (const void*)"VMAS1", 5)) {
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig videomaster_sigs[] = {
+	{ 0, 5, 100, "VMAS1" }
+};
 
 void de_module_videomaster(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "videomaster";
 	mi->desc = "Video Master (.flm/.vid/.vsq)";
 	mi->run_fn = de_run_videomaster;
-	mi->identify_fn = de_identify_videomaster;
+	mi->sigs = videomaster_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(videomaster_sigs);
 }
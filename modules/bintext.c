@@ -381,12 +381,9 @@ done:
 	free_lctx(c, d);
 }
 
-static int de_identify_xbin(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "XBIN\x1a", 5))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig xbin_sigs[] = {
+	{ 0, 5, 100, "XBIN\x1a" }
+};
 
 static void de_help_xbin(deark *c)
 {
@@ -399,7 +396,8 @@ void de_module_xbin(deark *c, struct deark_module_info *mi)
 	mi->id = "xbin";
 	mi->desc = "XBIN character graphics";
 	mi->run_fn = de_run_xbin;
-	mi->identify_fn = de_identify_xbin;
+	mi->sigs = xbin_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(xbin_sigs);
 	mi->help_fn = de_help_xbin;
 }
 
@@ -670,20 +668,17 @@ static void de_run_icedraw(deark *c, de_module_params *mparams)
 	de_err(c, "iCEDraw format is not supported");
 }
 
-static int de_identify_icedraw(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x04\x31\x2e\x34", 4)) {
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig icedraw_sigs[] = {
+	{ 0, 4, 100, "\x04\x31\x2e\x34" }
+};
 
 void de_module_icedraw(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "icedraw";
 	mi->desc = "iCEDraw character graphics format";
 	mi->run_fn = de_run_icedraw;
-	mi->identify_fn = de_identify_icedraw;
+	mi->sigs = icedraw_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(icedraw_sigs);
 	mi->flags |= DE_MODFLAG_NONWORKING;
 }
 
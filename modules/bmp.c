@@ -1253,6 +1253,10 @@ done:
 	dbuf_close(outf);
 }
 
+static const struct de_module_sig picjpeg_sigs[] = {
+	{ 0, 2, 0, "BM" }
+};
+
 static int de_identify_picjpeg(deark *c)
 {
 	if(dbuf_memcmp(c->infile, 0, (const void*)"BM", 2)) return 0;
@@ -1267,6 +1271,8 @@ void de_module_picjpeg(deark *c, struct deark_module_info *mi)
 	mi->desc = "Pegasus JPEG, and KQP";
 	mi->run_fn = de_run_picjpeg;
 	mi->identify_fn = de_identify_picjpeg;
+	mi->sigs = picjpeg_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(picjpeg_sigs);
 	mi->id_alias[0] = "kqp";
 }
 
@@ -1583,6 +1589,10 @@ done:
 	dbuf_close(outf);
 }
 
+static const struct de_module_sig jigsaw_wk_sigs[] = {
+	{ 0, 2, 0, "JG" }
+};
+
 static int de_identify_jigsaw_wk(deark *c)
 {
 	i64 fsize;
@@ -1613,4 +1623,6 @@ void de_module_jigsaw_wk(deark *c, struct deark_module_info *mi)
 	mi->desc = "Jigsaw .jig";
 	mi->run_fn = de_run_jigsaw_wk;
 	mi->identify_fn = de_identify_jigsaw_wk;
+	mi->sigs = jigsaw_wk_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(jigsaw_wk_sigs);
 }
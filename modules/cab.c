@@ -400,18 +400,16 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_cab(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "MSCF", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig cab_sigs[] = {
+	{ 0, 4, 100, "MSCF" }
+};
 
 void de_module_cab(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "cab";
 	mi->desc = "Microsoft Cabinet (CAB)";
 	mi->run_fn = de_run_cab;
-	mi->identify_fn = de_identify_cab;
+	mi->sigs = cab_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(cab_sigs);
 	mi->flags |= DE_MODFLAG_WARNPARSEONLY;
 }
@@ -68,6 +68,10 @@ done:
 	de_free(c, mparams2);
 }
 
+static const struct de_module_sig cdr_wl_sigs[] = {
+	{ 0, 2, 0, "WL" }
+};
+
 static int de_identify_cdr_wl(deark *c)
 {
 	if(!dbuf_memcmp(c->infile, 0, "WL", 2)) {
@@ -95,6 +99,8 @@ void de_module_cdr_wl(deark *c, struct deark_module_info *mi)
 	mi->desc2 = "extract preview image";
 	mi->run_fn = de_run_cdr_wl;
 	mi->identify_fn = de_identify_cdr_wl;
+	mi->sigs = cdr_wl_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(cdr_wl_sigs);
 	mi->help_fn = de_help_cdr_wl;
 }
 
@@ -302,18 +308,17 @@ done:
 	de_dbg_indent_restore(c, saved_indent_level);
 }
 
-static int de_identify_corel_bmf(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "@CorelBMF\x0a\x0d", 11)) return 100;
-	return 0;
-}
+static const struct de_module_sig corel_bmf_sigs[] = {
+	{ 0, 11, 100, "@CorelBMF\x0a\x0d" }
+};
 
 void de_module_corel_bmf(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "corel_bmf";
 	mi->desc = "Corel Gallery BMF";
 	mi->run_fn = de_run_corel_bmf;
-	mi->identify_fn = de_identify_corel_bmf;
+	mi->sigs = corel_bmf_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(corel_bmf_sigs);
 }
 
 // **************************************************************************
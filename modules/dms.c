@@ -229,15 +229,18 @@ static int lzh_have_enough_output(struct lzh_ctx *cctx)
 	return 0;
 }
 
-static void lha5like_lz77buf_writebytecb(struct de_lz77buffer *rb, u8 n)
+static void lha5like_lz77buf_writespancb(struct de_lz77buffer *rb, const u8 *buf, UI len)
 {
 	struct lzh_ctx *cctx = (struct lzh_ctx*)rb->userdata;
 
-	if(lzh_have_enough_output(cctx)) {
-		return;
+	if(cctx->dcmpro->len_known) {
+		i64 nbytes_wanted = cctx->dcmpro->expected_len - cctx->nbytes_written;
+
+		if(nbytes_wanted<=0) return;
+		if((i64)len > nbytes_wanted) len = (UI)nbytes_wanted;
 	}
-	dbuf_writebyte(cctx->dcmpro->f, n);
-	cctx->nbytes_written++;
+	dbuf_write(cctx->dcmpro->f, buf, (i64)len);
+	cctx->nbytes_written += (i64)len;
 }
 
 static UI read_next_code_using_tree(struct lzh_ctx *cctx, struct lzh_tree_wrapper *tree)
@@ -352,7 +355,7 @@ static void decompress_dms_heavy(struct lzh_ctx *cctx, struct dmslzh_params *lzh
 	}
 
 	hvst->ringbuf->userdata = (void*)cctx;
-	hvst->ringbuf->writebyte_cb = lha5like_lz77buf_writebytecb;
+	hvst->ringbuf->write_span_cb = lha5like_lz77buf_writespancb;
 
 	if(!cctx->dcmpro->len_known) {
 		// I think we (may) have to know the output length, because zero-length Huffman
@@ -474,7 +477,7 @@ static void dmslzh_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 	decompress_dms_heavy(cctx, lzhp, hvst);
 
 	hvst->ringbuf->userdata = NULL;
-	hvst->ringbuf->writebyte_cb = NULL;
+	hvst->ringbuf->write_span_cb = NULL;
 	lzhp->heavy_state = hvst;
 	hvst = NULL;
 
@@ -729,15 +732,18 @@ done:
 	}
 }
 
-static void medium_lz77buf_writebytecb(struct de_lz77buffer *rb, u8 n)
+static void medium_lz77buf_writespancb(struct de_lz77buffer *rb, const u8 *buf, UI len)
 {
 	struct medium_ctx *mctx = (struct medium_ctx *)rb->userdata;
 
-	if(medium_have_enough_output(mctx)) {
-		return;
+	if(mctx->dcmpro->len_known) {
+		i64 nbytes_wanted = mctx->dcmpro->expected_len - mctx->nbytes_written;
+
+		if(nbytes_wanted<=0) return;
+		if((i64)len > nbytes_wanted) len = (UI)nbytes_wanted;
 	}
-	dbuf_writebyte(mctx->dcmpro->f, n);
-	mctx->nbytes_written++;
+	dbuf_write(mctx->dcmpro->f, buf, (i64)len);
+	mctx->nbytes_written += (i64)len;
 }
 
 static void mediumlz77_codec_command(struct de_dfilter_ctx *dfctx, int cmd, UI flags)
@@ -789,7 +795,7 @@ static void dmsmediumlz77_codec(struct de_dfilter_ctx *dfctx, void *codec_privat
 	de_lz77buffer_set_curpos(mctx->ringbuf, 0x3fbe);
 
 	mctx->ringbuf->userdata = (void*)mctx;
-	mctx->ringbuf->writebyte_cb = medium_lz77buf_writebytecb;
+	mctx->ringbuf->write_span_cb = medium_lz77buf_writespancb;
 }
 
 ///////////////// Codec for the LZ77 part of "Quick" decompression //////////////
@@ -897,7 +903,7 @@ static void dmsquicklz77_codec(struct de_dfilter_ctx *dfctx, void *codec_private
 	de_lz77buffer_set_curpos(mctx->ringbuf, 251);
 
 	mctx->ringbuf->userdata = (void*)mctx;
-	mctx->ringbuf->writebyte_cb = medium_lz77buf_writebytecb;
+	mctx->ringbuf->write_span_cb = medium_lz77buf_writespancb;
 }
 
 ///////////////// "Quick", "Medium", "Deep" decompression //////////////
@@ -1512,6 +1518,10 @@ done:
 	}
 }
 
+static const struct de_module_sig amiga_dms_sigs[] = {
+	{ 0, 4, 0, "DMS!" }
+};
+
 static int de_identify_amiga_dms(deark *c)
 {
 	i64 dcmpr_size;
@@ -1528,4 +1538,6 @@ void de_module_amiga_dms(deark *c, struct deark_module_info *mi)
 	mi->desc = "Amiga DMS disk image";
 	mi->run_fn = de_run_amiga_dms;
 	mi->identify_fn = de_identify_amiga_dms;
+	mi->sigs = amiga_dms_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(amiga_dms_sigs);
 }
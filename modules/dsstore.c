@@ -414,12 +414,9 @@ done:
 	}
 }
 
-static int de_identify_dsstore(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x00\x00\x00\x01" "Bud1", 8))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig dsstore_sigs[] = {
+	{ 0, 8, 100, "\x00\x00\x00\x01" "Bud1" }
+};
 
 static void de_help_dsstore(deark *c)
 {
@@ -431,6 +428,7 @@ void de_module_dsstore(deark *c, struct deark_module_info *mi)
 	mi->id = "dsstore";
 	mi->desc = "Mac Finder .DS_Store format";
 	mi->run_fn = de_run_dsstore;
-	mi->identify_fn = de_identify_dsstore;
+	mi->sigs = dsstore_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(dsstore_sigs);
 	mi->help_fn = de_help_dsstore;
 }
@@ -691,12 +691,9 @@ static void de_run_ebml(deark *c, de_module_params *mparams)
 	}
 }
 
-static int de_identify_ebml(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x1a\x45\xdf\xa3", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig ebml_sigs[] = {
+	{ 0, 4, 100, "\x1a\x45\xdf\xa3" }
+};
 
 static void de_help_ebml(deark *c)
 {
@@ -708,6 +705,7 @@ void de_module_ebml(deark *c, struct deark_module_info *mi)
 	mi->id = "ebml";
 	mi->desc = "EBML";
 	mi->run_fn = de_run_ebml;
-	mi->identify_fn = de_identify_ebml;
+	mi->sigs = ebml_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ebml_sigs);
 	mi->help_fn = de_help_ebml;
 }
@@ -48,13 +48,16 @@ static int do_gzip_read_member(deark *c, lctx *d, i64 pos1, i64 *member_size)
 	i64 n;
 	i64 foundpos;
 	i64 string_len;
-	i64 cmpr_data_len;
 	i64 mod_time_unix;
 	u32 crc_calculated;
 	de_ucstring *member_name = NULL;
 	int saved_indent_level;
 	int ret;
 	struct member_data *md = NULL;
+	struct de_dfilter_in_params dcmpri;
+	struct de_dfilter_out_params dcmpro;
+	struct de_dfilter_results dres;
+	struct de_deflate_params inflparams;
 	int retval = 0;
 
 	md = de_malloc(c, sizeof(struct member_data));
@@ -167,18 +170,27 @@ static int do_gzip_read_member(deark *c, lctx *d, i64 pos1, i64 *member_size)
 		de_finfo_destroy(c, fi);
 	}
 
-	dbuf_set_writelistener(d->output_file, de_writelistener_for_crc, (void*)d->crco);
 	de_crcobj_reset(d->crco);
 
-	ret = fmtutil_decompress_deflate(c->infile, pos, c->infile->len - pos, d->output_file,
-		0, &cmpr_data_len, 0);
+	de_dfilter_init_objects(c, &dcmpri, &dcmpro, &dres);
+	dcmpri.f = c->infile;
+	dcmpri.pos = pos;
+	dcmpri.len = c->infile->len - pos;
+	dcmpro.f = d->output_file;
+	de_zeromem(&inflparams, sizeof(struct de_deflate_params));
+	// Have the decompressor compute the CRC as it goes.
+	inflparams.crco_for_output = d->crco;
+	fmtutil_decompress_deflate_ex(c, &dcmpri, &dcmpro, &dres, &inflparams);
 	dbuf_flush(d->output_file);
 
 	crc_calculated = de_crcobj_getval(d->crco);
-	dbuf_set_writelistener(d->output_file, NULL, NULL);
 
-	if(!ret) goto done;
-	pos += cmpr_data_len;
+	if(dres.errcode) {
+		de_err(c, "%s", de_dfilter_get_errmsg(c, &dres));
+		goto done;
+	}
+	if(!dres.bytes_consumed_valid) goto done;
+	pos += dres.bytes_consumed;
 
 	de_dbg(c, "crc32 (calculated): 0x%08x", (unsigned int)crc_calculated);
 
@@ -891,6 +891,10 @@ done:
 	}
 }
 
+static const struct de_module_sig hfs_sigs[] = {
+	{ 1024, 2, 0, "BD" }
+};
+
 static int de_identify_hfs(deark *c)
 {
 	i64 drAlBlkSiz;
@@ -912,4 +916,6 @@ void de_module_hfs(deark *c, struct deark_module_info *mi)
 	mi->desc = "HFS filesystem image";
 	mi->run_fn = de_run_hfs;
 	mi->identify_fn = de_identify_hfs;
+	mi->sigs = hfs_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(hfs_sigs);
 }
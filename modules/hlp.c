@@ -1819,12 +1819,9 @@ static void de_run_hlp(deark *c, de_module_params *mparams)
 	}
 }
 
-static int de_identify_hlp(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x3f\x5f\x03\x00", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig hlp_sigs[] = {
+	{ 0, 4, 100, "\x3f\x5f\x03\x00" }
+};
 
 static void de_help_hlp(deark *c)
 {
@@ -1837,6 +1834,7 @@ void de_module_hlp(deark *c, struct deark_module_info *mi)
 	mi->id = "hlp";
 	mi->desc = "HLP";
 	mi->run_fn = de_run_hlp;
-	mi->identify_fn = de_identify_hlp;
+	mi->sigs = hlp_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(hlp_sigs);
 	mi->help_fn = de_help_hlp;
 }
@@ -870,17 +870,15 @@ static void de_run_iccprofile(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_iccprofile(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 36, "acsp", 4))
-		return 85;
-	return 0;
-}
+static const struct de_module_sig iccprofile_sigs[] = {
+	{ 36, 4, 85, "acsp" }
+};
 
 void de_module_iccprofile(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "iccprofile";
 	mi->desc = "ICC profile";
 	mi->run_fn = de_run_iccprofile;
-	mi->identify_fn = de_identify_iccprofile;
+	mi->sigs = iccprofile_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(iccprofile_sigs);
 }
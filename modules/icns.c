@@ -568,6 +568,10 @@ static void de_run_icns(deark *c, de_module_params *mparams)
 	}
 }
 
+static const struct de_module_sig icns_sigs[] = {
+	{ 0, 4, 0, "icns" }
+};
+
 static int de_identify_icns(deark *c)
 {
 	i64 fsize;
@@ -585,4 +589,6 @@ void de_module_icns(deark *c, struct deark_module_info *mi)
 	mi->desc = "Macintosh icon";
 	mi->run_fn = de_run_icns;
 	mi->identify_fn = de_identify_icns;
+	mi->sigs = icns_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(icns_sigs);
 }
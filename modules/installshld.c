@@ -369,13 +369,9 @@ done:
 	}
 }
 
-static int de_identify_is_instarch(deark *c)
-{
-	if(dbuf_memcmp(c->infile, 0, "\x2a\xab\x79\xd8\x00\x01", 6)) {
-		return 0;
-	}
-	return 100;
-}
+static const struct de_module_sig is_instarch_sigs[] = {
+	{ 0, 6, 100, "\x2a\xab\x79\xd8\x00\x01" }
+};
 
 void de_module_is_instarch(deark *c, struct deark_module_info *mi)
 {
@@ -383,7 +379,8 @@ void de_module_is_instarch(deark *c, struct deark_module_info *mi)
 	mi->id_alias[0] = "is_inst32i";
 	mi->desc = "InstallShield installer archive (_inst32i.ex_)";
 	mi->run_fn = de_run_is_instarch;
-	mi->identify_fn = de_identify_is_instarch;
+	mi->sigs = is_instarch_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(is_instarch_sigs);
 }
 
 // **************************************************************************
@@ -98,6 +98,16 @@ static i64 sector_dpos(lctx *d, i64 secnum)
 // Caution - If the "bbo" functions were to be changed to use the
 // little-endian bytes instead, it will break CD-i support.
 
+static i64 getu16bbo_direct(const u8 *m)
+{
+	return de_getu16be_direct(&m[2]);
+}
+
+static i64 getu32bbo_direct(const u8 *m)
+{
+	return de_getu32be_direct(&m[4]);
+}
+
 static i64 getu16bbo_p(dbuf *f, i64 *ppos)
 {
 	i64 val;
@@ -816,25 +826,32 @@ static int do_directory_record(deark *c, lctx *d, i64 pos1, struct dir_record *d
 	de_ucstring *tmps = NULL;
 	int retval = 0;
 	de_ext_encoding file_id_encoding;
+	const u8 *hdr;
+	u8 hdrbuf[33];
+
+	// The fixed-size part of the record
+	hdr = dbuf_get_span(c->infile, pos1, 33, hdrbuf);
 
-	dr->len_dir_rec = (i64)de_getbyte_p(&pos);
+	dr->len_dir_rec = (i64)hdr[0];
 	de_dbg(c, "dir rec len: %u", (unsigned int)dr->len_dir_rec);
 	if(dr->len_dir_rec<1) goto done;
 
-	dr->len_ext_attr_rec = (i64)de_getbyte_p(&pos);
+	dr->len_ext_attr_rec = (i64)hdr[1];
 	de_dbg(c, "ext attrib rec len: %u", (unsigned int)dr->len_ext_attr_rec);
 
-	dr->extent_blk = getu32bbo_p(c->infile, &pos);
+	dr->extent_blk = getu32bbo_direct(&hdr[2]);
 	de_dbg(c, "loc. of extent: %"I64_FMT" (block #%u)", sector_dpos(d, dr->extent_blk),
 		(unsigned int)dr->extent_blk);
-	dr->data_len = getu32bbo_p(c->infile, &pos);
+	dr->data_len = getu32bbo_direct(&hdr[10]);
 	de_dbg(c, "data length: %u", (unsigned int)dr->data_len);
+	pos += 18;
 
 	read_datetime7(c, d, pos, d->vol->is_hsf?6:7, &dr->recording_time);
 	dbg_timestamp(c, &dr->recording_time, "recording time");
 	pos += d->vol->is_hsf?6:7;
 
-	dr->file_flags = de_getbyte_p(&pos);
+	dr->file_flags = hdr[pos-pos1];
+	pos++;
 	tmps = ucstring_create(c);
 	if(dr->file_flags & 0x01) ucstring_append_flags_item(tmps, "hidden");
 	if(dr->file_flags & 0x02) {
@@ -860,7 +877,8 @@ static int do_directory_record(deark *c, lctx *d, i64 pos1, struct dir_record *d
 		pos++; // reserved
 	}
 	else {
-		b = de_getbyte_p(&pos);
+		b = hdr[pos-pos1];
+		pos++;
 		de_dbg(c, "file unit size: %u", (unsigned int)b);
 	}
 
@@ -869,16 +887,19 @@ static int do_directory_record(deark *c, lctx *d, i64 pos1, struct dir_record *d
 		pos++; // interleave skip factor
 	}
 	else {
-		b = de_getbyte_p(&pos);
+		b = hdr[pos-pos1];
+		pos++;
 		de_dbg(c, "interleave gap size: %u", (unsigned int)b);
 		if(b!=0) {
 			dr->is_specialfileformat = 1;
 		}
 	}
 
-	n = getu16bbo_p(c->infile, &pos);
+	n = getu16bbo_direct(&hdr[pos-pos1]);
+	pos += 4;
 	de_dbg(c, "volume sequence number: %u", (unsigned int)n);
-	dr->file_id_len = (i64)de_getbyte_p(&pos);
+	dr->file_id_len = (i64)hdr[pos-pos1];
+	pos++;
 
 	if(d->vol->is_cdi) {
 		dr->cdi_attribs = (UI)de_getu16be(pos1 + 37 + dr->file_id_len);
@@ -1550,10 +1571,11 @@ done:
 
 static int cdsig_at(dbuf *f, i64 pos)
 {
-	u8 buf[14];
+	u8 tmpbuf[14];
+	const u8 *buf;
 	u8 ty;
 
-	dbuf_read(f, buf, pos, sizeof(buf));
+	buf = dbuf_get_span(f, pos, sizeof(tmpbuf), tmpbuf);
 	if(!de_memcmp(&buf[1], g_sig_CD001, 5)) {
 		ty = buf[0];
 	}
@@ -567,17 +567,15 @@ static void de_run_j2c(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_j2c(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\xff\x4f\xff\x51", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig j2c_sigs[] = {
+	{ 0, 4, 100, "\xff\x4f\xff\x51" }
+};
 
 void de_module_j2c(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "j2c";
 	mi->desc = "JPEG 2000 codestream";
 	mi->run_fn = de_run_j2c;
-	mi->identify_fn = de_identify_j2c;
+	mi->sigs = j2c_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(j2c_sigs);
 }
@@ -414,17 +414,15 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_jbf(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "JASC BROWS FILE", 15))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig jbf_sigs[] = {
+	{ 0, 15, 100, "JASC BROWS FILE" }
+};
 
 void de_module_jbf(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "jbf";
 	mi->desc = "PaintShop Pro Browser Cache (pspbrwse.jbf)";
 	mi->run_fn = de_run_jbf;
-	mi->identify_fn = de_identify_jbf;
+	mi->sigs = jbf_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(jbf_sigs);
 }
@@ -210,6 +210,10 @@ done:
 	de_free(c, d);
 }
 
+static const struct de_module_sig jovianvi_sigs[] = {
+	{ 0, 2, 0, "VI" }
+};
+
 static int de_identify_jovianvi(deark *c)
 {
 	u8 t;
@@ -231,4 +235,6 @@ void de_module_jovianvi(deark *c, struct deark_module_info *mi)
 	mi->desc = "Jovian Logic VI";
 	mi->run_fn = de_run_jovianvi;
 	mi->identify_fn = de_identify_jovianvi;
+	mi->sigs = jovianvi_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(jovianvi_sigs);
 }
@@ -2211,13 +2211,9 @@ static void de_run_jpegscan(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_jpeg(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\xff\xd8\xff", 3)) {
-		return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig jpeg_sigs[] = {
+	{ 0, 3, 100, "\xff\xd8\xff" }
+};
 
 void de_module_jpeg(deark *c, struct deark_module_info *mi)
 {
@@ -2225,7 +2221,8 @@ void de_module_jpeg(deark *c, struct deark_module_info *mi)
 	mi->desc = "JPEG image";
 	mi->desc2 = "resources only";
 	mi->run_fn = de_run_jpeg;
-	mi->identify_fn = de_identify_jpeg;
+	mi->sigs = jpeg_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(jpeg_sigs);
 }
 
 void de_module_jpegscan(deark *c, struct deark_module_info *mi)
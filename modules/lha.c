@@ -2008,6 +2008,10 @@ done:
 	}
 }
 
+static const struct de_module_sig arx_sigs[] = {
+	{ 2, 5, 0, "-lh1-" }
+};
+
 static int de_identify_arx(deark *c)
 {
 	if(dbuf_memcmp(c->infile, 2, "-lh1-", 5)) return 0;
@@ -2022,6 +2026,8 @@ void de_module_arx(deark *c, struct deark_module_info *mi)
 	mi->desc = "ARX LHA-like archive";
 	mi->run_fn = de_run_arx;
 	mi->identify_fn = de_identify_arx;
+	mi->sigs = arx_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(arx_sigs);
 }
 
 
@@ -496,17 +496,15 @@ static void de_run_makichan(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_makichan(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "MAKI0", 5))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig makichan_sigs[] = {
+	{ 0, 5, 100, "MAKI0" }
+};
 
 void de_module_makichan(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "makichan";
 	mi->desc = "MAKIchan graphics";
 	mi->run_fn = de_run_makichan;
-	mi->identify_fn = de_identify_makichan;
+	mi->sigs = makichan_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(makichan_sigs);
 }
@@ -132,6 +132,10 @@ static void de_run_megapaint_pat(deark *c, de_module_params *mparams)
 	de_bitmap_destroy(mainimg);
 }
 
+static const struct de_module_sig megapaint_pat_sigs[] = {
+	{ 0, 4, 0, "\x07" "PAT" }
+};
+
 static int de_identify_megapaint_pat(deark *c)
 {
 	if(dbuf_memcmp(c->infile, 0, "\x07" "PAT", 4))
@@ -146,6 +150,8 @@ void de_module_megapaint_pat(deark *c, struct deark_module_info *mi)
 	mi->desc = "MegaPaint Patterns";
 	mi->run_fn = de_run_megapaint_pat;
 	mi->identify_fn = de_identify_megapaint_pat;
+	mi->sigs = megapaint_pat_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(megapaint_pat_sigs);
 }
 
 // **************************************************************************
@@ -181,6 +187,10 @@ static void de_run_megapaint_lib(deark *c, de_module_params *mparams)
 	}
 }
 
+static const struct de_module_sig megapaint_lib_sigs[] = {
+	{ 0, 4, 0, "\x07" "LIB" }
+};
+
 static int de_identify_megapaint_lib(deark *c)
 {
 	if(dbuf_memcmp(c->infile, 0, "\x07" "LIB", 4))
@@ -195,4 +205,6 @@ void de_module_megapaint_lib(deark *c, struct deark_module_info *mi)
 	mi->desc = "MegaPaint Symbol Library";
 	mi->run_fn = de_run_megapaint_lib;
 	mi->identify_fn = de_identify_megapaint_lib;
+	mi->sigs = megapaint_lib_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(megapaint_lib_sigs);
 }
@@ -18,6 +18,7 @@ DE_DECLARE_MODULE(de_module_hexdump);
 DE_DECLARE_MODULE(de_module_bytefreq);
 DE_DECLARE_MODULE(de_module_deflate);
 DE_DECLARE_MODULE(de_module_zlib);
+DE_DECLARE_MODULE(de_module_deflatebench);
 DE_DECLARE_MODULE(de_module_winzle);
 DE_DECLARE_MODULE(de_module_mrw);
 DE_DECLARE_MODULE(de_module_vgafont);
@@ -382,9 +383,7 @@ void de_module_cp437(deark *c, struct deark_module_info *mi)
 // **************************************************************************
 
 struct crcctx_struct {
-	struct de_crcobj *crco_32ieee;
-	struct de_crcobj *crco_16arc;
-	struct de_crcobj *crco_16xmodem;
+	struct de_digestset *ds;
 	u64 sum_of_bytes;
 	u64 sum_of_ui16le;
 	u64 sum_of_ui16be;
@@ -397,9 +396,7 @@ static int crc_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
 	struct crcctx_struct *crcctx = (struct crcctx_struct*)brctx->userdata;
 	i64 i;
 
-	de_crcobj_addbuf(crcctx->crco_32ieee, buf, buf_len);
-	de_crcobj_addbuf(crcctx->crco_16arc, buf, buf_len);
-	de_crcobj_addbuf(crcctx->crco_16xmodem, buf, buf_len);
+	de_digestset_addbuf(crcctx->ds, buf, buf_len);
 	// We could use crcobj for these checksums, but unfortunately that would
 	// limit them to 32 bits, instead of 64.
 	for(i=0; i<buf_len; i++) {
@@ -417,30 +414,100 @@ static int crc_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
 	return 1;
 }
 
+// Reports the speed of each crcobj type, using the input file as data
+// (repeated as needed).
+static void crc_benchmark(deark *c)
+{
+	static const struct {
+		UI crctype;
+		const char *name;
+	} types[] = {
+		{ DE_CRCOBJ_CRC32_IEEE, "CRC-32-IEEE" },
+		{ DE_CRCOBJ_ADLER32, "Adler-32" },
+		{ DE_CRCOBJ_CRC16_XMODEM, "CRC-16-XMODEM" },
+		{ DE_CRCOBJ_CRC16_ARC, "CRC-16-ARC" },
+		{ DE_CRCOBJ_CRC16_IBMSDLC, "CRC-16-IBM-SDLC" },
+		{ DE_CRCOBJ_SUM_BYTES, "Sum of bytes" },
+		{ DE_CRCOBJ_SUM_U16LE, "Sum of uint16-LE" },
+		{ DE_CRCOBJ_SUM_U16BE, "Sum of uint16-BE" }
+	};
+	const i64 total_bytes = 256*1048576;
+	i64 bufsize;
+	u8 *buf = NULL;
+	size_t k;
+
+	bufsize = de_min_int(c->infile->len, 1048576);
+	if(bufsize<1) {
+		de_err(c, "Benchmark requires a nonempty file");
+		return;
+	}
+	buf = de_malloc(c, bufsize);
+	de_read(buf, 0, bufsize);
+
+	for(k=0; k<DE_ARRAYCOUNT(types); k++) {
+		struct de_crcobj *crco;
+		i64 amt_done = 0;
+		i64 t0, t;
+
+		crco = de_crcobj_create(c, types[k].crctype);
+		t0 = de_get_monotonic_time_usec();
+		while(amt_done < total_bytes) {
+			de_crcobj_addbuf(crco, buf, bufsize);
+			amt_done += bufsize;
+		}
+		t = de_get_monotonic_time_usec() - t0;
+		if(t<1) t = 1;
+		de_msg(c, "%s: %"I64_FMT" MB/s (0x%08x)", types[k].name,
+			(amt_done*1000000/t)/1048576, (UI)de_crcobj_getval(crco));
+		de_crcobj_destroy(crco);
+	}
+
+	de_free(c, buf);
+}
+
 static void de_run_crc(deark *c, de_module_params *mparams)
 {
 	struct crcctx_struct crcctx;
+	char tmps[80];
+
+	if(de_get_ext_option_bool(c, "crc:selftest", 0)) {
+		de_crcobj_selftest(c);
+		return;
+	}
+	if(de_get_ext_option_bool(c, "crc:bench", 0)) {
+		crc_benchmark(c);
+		return;
+	}
 
 	de_zeromem(&crcctx, sizeof(struct crcctx_struct));
-	crcctx.crco_32ieee = de_crcobj_create(c, DE_CRCOBJ_CRC32_IEEE);
-	crcctx.crco_16arc = de_crcobj_create(c, DE_CRCOBJ_CRC16_ARC);
-	crcctx.crco_16xmodem = de_crcobj_create(c, DE_CRCOBJ_CRC16_XMODEM);
+	// All the CRCs and hashes are calculated in one pass.
+	crcctx.ds = de_digestset_create(c, DE_DIGEST_CRC32 | DE_DIGEST_CRC16ARC |
+		DE_DIGEST_CRC16XMODEM | DE_DIGEST_SHA1 | DE_DIGEST_SHA256);
 
 	dbuf_buffered_read(c->infile, 0, c->infile->len, crc_cbfn, (void*)&crcctx);
 
-	de_msg(c, "CRC-32-IEEE: 0x%08x",
-		(unsigned int)de_crcobj_getval(crcctx.crco_32ieee));
-	de_msg(c, "CRC-16-IBM/ARC: 0x%04x",
-		(unsigned int)de_crcobj_getval(crcctx.crco_16arc));
-	de_msg(c, "CRC-16-XMODEM: 0x%04x",
-		(unsigned int)de_crcobj_getval(crcctx.crco_16xmodem));
+	de_digestset_get_string(crcctx.ds, DE_DIGEST_CRC32, tmps, sizeof(tmps));
+	de_msg(c, "CRC-32-IEEE: 0x%s", tmps);
+	de_digestset_get_string(crcctx.ds, DE_DIGEST_CRC16ARC, tmps, sizeof(tmps));
+	de_msg(c, "CRC-16-IBM/ARC: 0x%s", tmps);
+	de_digestset_get_string(crcctx.ds, DE_DIGEST_CRC16XMODEM, tmps, sizeof(tmps));
+	de_msg(c, "CRC-16-XMODEM: 0x%s", tmps);
 	de_msg(c, "Sum of bytes: 0x%"U64_FMTx, crcctx.sum_of_bytes);
 	de_msg(c, "Sum of uint16-LE: 0x%"U64_FMTx, crcctx.sum_of_ui16le);
 	de_msg(c, "Sum of uint16-BE: 0x%"U64_FMTx, crcctx.sum_of_ui16be);
+	de_digestset_get_string(crcctx.ds, DE_DIGEST_SHA1, tmps, sizeof(tmps));
+	de_msg(c, "SHA-1: %s", tmps);
+	de_digestset_get_string(crcctx.ds, DE_DIGEST_SHA256, tmps, sizeof(tmps));
+	de_msg(c, "SHA-256: %s", tmps);
 
-	de_crcobj_destroy(crcctx.crco_32ieee);
-	de_crcobj_destroy(crcctx.crco_16arc);
-	de_crcobj_destroy(crcctx.crco_16xmodem);
+	de_digestset_destroy(crcctx.ds);
+}
+
+static void de_help_crc(deark *c)
+{
+	de_msg(c, "-opt crc:selftest : Instead of processing the file, test the CRC code");
+	de_msg(c, "-opt crc:bench : Instead of processing the file, measure the speed of "
+		"the CRC code, using the file as data");
 }
 
 void de_module_crc(deark *c, struct deark_module_info *mi)
@@ -449,6 +516,7 @@ void de_module_crc(deark *c, struct deark_module_info *mi)
 	mi->id_alias[0] = "crc32";
 	mi->desc = "Calculate various CRCs";
 	mi->run_fn = de_run_crc;
+	mi->help_fn = de_help_crc;
 	mi->flags |= DE_MODFLAG_NOEXTRACT;
 }
 
@@ -723,6 +791,104 @@ void de_module_zlib(deark *c, struct deark_module_info *mi)
 	mi->identify_fn = de_identify_zlib;
 }
 
+// **************************************************************************
+// deflatebench
+//
+// Decompress a zlib or raw Deflate file with each available Deflate
+// decoder, and report how fast each one is.
+// **************************************************************************
+
+static void de_run_deflatebench(deark *c, de_module_params *mparams)
+{
+	UI flags = 0;
+	UI idx;
+	int num_iterations;
+	const char *s;
+	u32 first_crc = 0;
+	struct de_crcobj *crco = NULL;
+	const struct fmtutil_codec_backend *be;
+
+	if(de_identify_zlib(c)) {
+		flags |= DE_DEFLATEFLAG_ISZLIB;
+	}
+	de_msg(c, "Input format: %s", (flags & DE_DEFLATEFLAG_ISZLIB)?"zlib":"raw Deflate");
+
+	num_iterations = 5;
+	s = de_get_ext_option(c, "deflatebench:n");
+	if(s) {
+		num_iterations = de_atoi(s);
+		if(num_iterations<1) num_iterations = 1;
+	}
+	crco = de_crcobj_create(c, DE_CRCOBJ_CRC32_IEEE);
+
+	for(idx=0; (be = fmtutil_get_codec_backend("deflate", idx)) != NULL; idx++) {
+		struct de_dfilter_in_params dcmpri;
+		struct de_dfilter_out_params dcmpro;
+		struct de_dfilter_results dres;
+		struct de_deflate_params deflparams;
+		dbuf *outf = NULL;
+		i64 best_time = 0;
+		u32 crc;
+		int k;
+
+		outf = dbuf_create_membuf(c, 0, 0);
+		for(k=0; k<num_iterations; k++) {
+			i64 t0, t;
+
+			dbuf_truncate(outf, 0);
+			de_dfilter_init_objects(c, &dcmpri, &dcmpro, &dres);
+			dcmpri.f = c->infile;
+			dcmpri.pos = 0;
+			dcmpri.len = c->infile->len;
+			dcmpro.f = outf;
+			de_zeromem(&deflparams, sizeof(struct de_deflate_params));
+			deflparams.flags = flags;
+
+			t0 = de_get_monotonic_time_usec();
+			be->codec_fn(c, &dcmpri, &dcmpro, &dres, (void*)&deflparams);
+			t = de_get_monotonic_time_usec() - t0;
+			if(dres.errcode) break;
+			if(k==0 || t<best_time) best_time = t;
+		}
+
+		if(dres.errcode) {
+			de_msg(c, "%s: %s", be->name, de_dfilter_get_errmsg(c, &dres));
+			goto next_backend;
+		}
+
+		de_crcobj_reset(crco);
+		de_crcobj_addslice(crco, outf, 0, outf->len);
+		crc = de_crcobj_getval(crco);
+		if(idx==0) {
+			first_crc = crc;
+		}
+		else if(crc != first_crc) {
+			de_warn(c, "%s: Output differs from that of %s", be->name,
+				fmtutil_get_codec_backend("deflate", 0)->name);
+		}
+
+		if(best_time<1) best_time = 1;
+		de_msg(c, "%-8s %"I64_FMT" -> %"I64_FMT" bytes, %.3f ms, %.1f MB/s "
+			"(compressed: %.1f MB/s)", be->name,
+			c->infile->len, outf->len, (double)best_time/1000.0,
+			(double)outf->len/(double)best_time,
+			(double)c->infile->len/(double)best_time);
+
+next_backend:
+		dbuf_close(outf);
+	}
+
+	de_crcobj_destroy(crco);
+}
+
+void de_module_deflatebench(deark *c, struct deark_module_info *mi)
+{
+	mi->id = "deflatebench";
+	mi->desc = "Benchmark the Deflate decoders";
+	mi->run_fn = de_run_deflatebench;
+	mi->flags |= DE_MODFLAG_NOEXTRACT;
+}
+
 // **************************************************************************
 // Winzle! puzzle image
 // **************************************************************************
@@ -801,12 +967,9 @@ static void de_run_mrw(deark *c, de_module_params *mparams)
 	do_mrw_seg_list(c, 8, mrw_seg_size);
 }
 
-static int de_identify_mrw(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x00\x4d\x52\x4d", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig mrw_sigs[] = {
+	{ 0, 4, 100, "\x00\x4d\x52\x4d" }
+};
 
 void de_module_mrw(deark *c, struct deark_module_info *mi)
 {
@@ -814,7 +977,8 @@ void de_module_mrw(deark *c, struct deark_module_info *mi)
 	mi->desc = "Minolta RAW";
 	mi->desc2 = "resources only";
 	mi->run_fn = de_run_mrw;
-	mi->identify_fn = de_identify_mrw;
+	mi->sigs = mrw_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(mrw_sigs);
 }
 
 // **************************************************************************
@@ -946,6 +1110,10 @@ done:
 	}
 }
 
+static const struct de_module_sig pcrfont_sigs[] = {
+	{ 0, 3, 0, "KPG" }
+};
+
 static int de_identify_pcrfont(deark *c)
 {
 	u8 h;
@@ -964,6 +1132,8 @@ void de_module_pcrfont(deark *c, struct deark_module_info *mi)
 	mi->desc = "PCR font";
 	mi->run_fn = de_run_pcrfont;
 	mi->identify_fn = de_identify_pcrfont;
+	mi->sigs = pcrfont_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(pcrfont_sigs);
 }
 
 // **************************************************************************
@@ -992,6 +1162,10 @@ static void de_run_zbr(deark *c, de_module_params *mparams)
 	dbuf_close(outf);
 }
 
+static const struct de_module_sig zbr_sigs[] = {
+	{ 0, 2, 0, "\x9a\x02" }
+};
+
 static int de_identify_zbr(deark *c)
 {
 	if(!dbuf_memcmp(c->infile, 0, "\x9a\x02", 2)) {
@@ -1008,6 +1182,8 @@ void de_module_zbr(deark *c, struct deark_module_info *mi)
 	mi->desc2 = "extract preview image";
 	mi->run_fn = de_run_zbr;
 	mi->identify_fn = de_identify_zbr;
+	mi->sigs = zbr_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(zbr_sigs);
 }
 
 // **************************************************************************
@@ -1044,19 +1220,17 @@ static void de_run_compress(deark *c, de_module_params *mparams)
 	dbuf_close(f);
 }
 
-static int de_identify_compress(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x1f\x9d", 2))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig compress_sigs[] = {
+	{ 0, 2, 100, "\x1f\x9d" }
+};
 
 void de_module_compress(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "compress";
 	mi->desc = "Compress (.Z)";
 	mi->run_fn = de_run_compress;
-	mi->identify_fn = de_identify_compress;
+	mi->sigs = compress_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(compress_sigs);
 }
 
 // **************************************************************************
@@ -1089,18 +1263,17 @@ static void de_run_hpi(deark *c, de_module_params *mparams)
 	}
 }
 
-static int de_identify_hpi(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x89\x48\x50\x49\x0d\x0a\x1a\x0a", 8)) return 100;
-	return 0;
-}
+static const struct de_module_sig hpi_sigs[] = {
+	{ 0, 8, 100, "\x89\x48\x50\x49\x0d\x0a\x1a\x0a" }
+};
 
 void de_module_hpi(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "hpi";
 	mi->desc = "Hemera Photo-Object image";
 	mi->run_fn = de_run_hpi;
-	mi->identify_fn = de_identify_hpi;
+	mi->sigs = hpi_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(hpi_sigs);
 }
 
 // **************************************************************************
@@ -1363,20 +1536,17 @@ static void de_run_npack(deark *c, de_module_params *mparams)
 	do_lzstac_internal(c, 5, c->infile->len-5, 0x2);
 }
 
-static int de_identify_npack(deark *c)
-{
-	if(dbuf_memcmp(c->infile, 0, (const void*)"MSTSM", 5)) {
-		return 0;
-	}
-	return 85;
-}
+static const struct de_module_sig npack_sigs[] = {
+	{ 0, 5, 85, "MSTSM" }
+};
 
 void de_module_npack(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "npack";
 	mi->desc = "NPack compressed file";
 	mi->run_fn = de_run_npack;
-	mi->identify_fn = de_identify_npack;
+	mi->sigs = npack_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(npack_sigs);
 }
 
 // **************************************************************************
@@ -1389,18 +1559,15 @@ static void de_run_lzs221(deark *c, de_module_params *mparams)
 	do_lzstac_internal(c, 4, c->infile->len-4, 0);
 }
 
-static int de_identify_lzs221(deark *c)
-{
-	if(dbuf_memcmp(c->infile, 0, (const void*)"sTaC", 4)) {
-		return 0;
-	}
-	return 85;
-}
+static const struct de_module_sig lzs221_sigs[] = {
+	{ 0, 4, 85, "sTaC" }
+};
 
 void de_module_lzs221(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "lzs221";
 	mi->desc = "LZS221 compressed file";
 	mi->run_fn = de_run_lzs221;
-	mi->identify_fn = de_identify_lzs221;
+	mi->sigs = lzs221_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(lzs221_sigs);
 }
@@ -591,19 +591,17 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_lss16(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x3d\xf3\x13\x14", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig lss16_sigs[] = {
+	{ 0, 4, 100, "\x3d\xf3\x13\x14" }
+};
 
 void de_module_lss16(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "lss16";
 	mi->desc = "SYSLINUX LSS16 image";
 	mi->run_fn = de_run_lss16;
-	mi->identify_fn = de_identify_lss16;
+	mi->sigs = lss16_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(lss16_sigs);
 }
 
 // **************************************************************************
@@ -727,6 +725,10 @@ done:
 	de_bitmap_destroy(img);
 }
 
+static const struct de_module_sig ybm_sigs[] = {
+	{ 0, 2, 0, "!!" }
+};
+
 static int de_identify_ybm(deark *c)
 {
 	i64 width, height;
@@ -748,6 +750,8 @@ void de_module_ybm(deark *c, struct deark_module_info *mi)
 	mi->desc = "Bennet Yee's face format, a.k.a. YBM";
 	mi->run_fn = de_run_ybm;
 	mi->identify_fn = de_identify_ybm;
+	mi->sigs = ybm_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ybm_sigs);
 }
 
 // **************************************************************************
@@ -785,19 +789,17 @@ done:
 	de_bitmap_destroy(img);
 }
 
-static int de_identify_olpc565(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "C565", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig olpc565_sigs[] = {
+	{ 0, 4, 100, "C565" }
+};
 
 void de_module_olpc565(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "olpc565";
 	mi->desc = "OLPC .565 firmware icon";
 	mi->run_fn = de_run_olpc565;
-	mi->identify_fn = de_identify_olpc565;
+	mi->sigs = olpc565_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(olpc565_sigs);
 }
 
 // **************************************************************************
@@ -840,19 +842,17 @@ done:
 	de_bitmap_destroy(img);
 }
 
-static int de_identify_iim(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "IS_IMAGE", 8))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig iim_sigs[] = {
+	{ 0, 8, 100, "IS_IMAGE" }
+};
 
 void de_module_iim(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "iim";
 	mi->desc = "InShape IIM";
 	mi->run_fn = de_run_iim;
-	mi->identify_fn = de_identify_iim;
+	mi->sigs = iim_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(iim_sigs);
 }
 
 // **************************************************************************
@@ -935,21 +935,18 @@ done:
 	de_bitmap_destroy(img);
 }
 
-static int de_identify_pm_xv(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "VIEW", 4))
-		return 15;
-	if(!dbuf_memcmp(c->infile, 0, "WEIV", 4))
-		return 15;
-	return 0;
-}
+static const struct de_module_sig pm_xv_sigs[] = {
+	{ 0, 4, 15, "VIEW" },
+	{ 0, 4, 15, "WEIV" }
+};
 
 void de_module_pm_xv(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "pm_xv";
 	mi->desc = "PM (XV)";
 	mi->run_fn = de_run_pm_xv;
-	mi->identify_fn = de_identify_pm_xv;
+	mi->sigs = pm_xv_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(pm_xv_sigs);
 }
 
 // **************************************************************************
@@ -1016,19 +1013,17 @@ done:
 	dbuf_close(unc_pixels);
 }
 
-static int de_identify_crg(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "CALAMUSCRG", 10))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig crg_sigs[] = {
+	{ 0, 10, 100, "CALAMUSCRG" }
+};
 
 void de_module_crg(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "crg";
 	mi->desc = "Calamus Raster Graphic";
 	mi->run_fn = de_run_crg;
-	mi->identify_fn = de_identify_crg;
+	mi->sigs = crg_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(crg_sigs);
 }
 
 // **************************************************************************
@@ -1064,19 +1059,17 @@ static void de_run_farbfeld(deark *c, de_module_params *mparams)
 	de_bitmap_destroy(img);
 }
 
-static int de_identify_farbfeld(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "farbfeld", 8))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig farbfeld_sigs[] = {
+	{ 0, 8, 100, "farbfeld" }
+};
 
 void de_module_farbfeld(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "farbfeld";
 	mi->desc = "farbfeld image";
 	mi->run_fn = de_run_farbfeld;
-	mi->identify_fn = de_identify_farbfeld;
+	mi->sigs = farbfeld_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(farbfeld_sigs);
 }
 
 // **************************************************************************
@@ -1155,19 +1148,17 @@ done:
 	de_bitmap_destroy(img);
 }
 
-static int de_identify_hsiraw(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "mhwanh", 6))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig hsiraw_sigs[] = {
+	{ 0, 6, 100, "mhwanh" }
+};
 
 void de_module_hsiraw(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "hsiraw";
 	mi->desc = "HSI Raw";
 	mi->run_fn = de_run_hsiraw;
-	mi->identify_fn = de_identify_hsiraw;
+	mi->sigs = hsiraw_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(hsiraw_sigs);
 }
 
 // **************************************************************************
@@ -1309,19 +1300,17 @@ done:
 	de_dbg_indent_restore(c, saved_indent_level);
 }
 
-static int de_identify_vitec(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x00\x5b\x07\x20", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig vitec_sigs[] = {
+	{ 0, 4, 100, "\x00\x5b\x07\x20" }
+};
 
 void de_module_vitec(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "vitec";
 	mi->desc = "VITec image format";
 	mi->run_fn = de_run_vitec;
-	mi->identify_fn = de_identify_vitec;
+	mi->sigs = vitec_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(vitec_sigs);
 }
 
 // **************************************************************************
@@ -1585,18 +1574,17 @@ static void de_run_deskmate_pnt(deark *c, de_module_params *mparams)
 	de_bitmap_destroy(img);
 }
 
-static int de_identify_deskmate_pnt(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x13" "PNT", 4)) return 100;
-	return 0;
-}
+static const struct de_module_sig deskmate_pnt_sigs[] = {
+	{ 0, 4, 100, "\x13" "PNT" }
+};
 
 void de_module_deskmate_pnt(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "deskmate_pnt";
 	mi->desc = "Tandy DeskMate Paint";
 	mi->run_fn = de_run_deskmate_pnt;
-	mi->identify_fn = de_identify_deskmate_pnt;
+	mi->sigs = deskmate_pnt_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(deskmate_pnt_sigs);
 }
 
 // **************************************************************************
@@ -2806,6 +2794,10 @@ done:
 	}
 }
 
+static const struct de_module_sig iconmgr_ica_sigs[] = {
+	{ 0, 2, 0, "IC" }
+};
+
 static int de_identify_iconmgr_ica(deark *c)
 {
 	u8 b;
@@ -2825,4 +2817,6 @@ void de_module_iconmgr_ica(deark *c, struct deark_module_info *mi)
 	mi->desc = "Icon Manager Archive (.ica)";
 	mi->run_fn = de_run_iconmgr_ica;
 	mi->identify_fn = de_identify_iconmgr_ica;
+	mi->sigs = iconmgr_ica_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(iconmgr_ica_sigs);
 }
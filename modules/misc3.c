@@ -1029,18 +1029,17 @@ static void de_run_pcxlib(deark *c, de_module_params *mparams)
 	do_pcxgxlib_main(c, mparams, FMT_PCXLIB);
 }
 
-static int de_identify_pcxlib(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "pcxLib\0", 7)) return 100;
-	return 0;
-}
+static const struct de_module_sig pcxlib_sigs[] = {
+	{ 0, 7, 100, "pcxLib\0" }
+};
 
 void de_module_pcxlib(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "pcxlib";
 	mi->desc = "PCX Library";
 	mi->run_fn = de_run_pcxlib;
-	mi->identify_fn = de_identify_pcxlib;
+	mi->sigs = pcxlib_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(pcxlib_sigs);
 }
 
 // **************************************************************************
@@ -1342,21 +1341,17 @@ done:
 }
 
 
-static int de_identify_cazip(deark *c)
-{
-	if(dbuf_memcmp(c->infile, 0, (const void*)"\x0d\x0a\x1a" "CAZIP", 8)) {
-		return 0;
-	}
-
-	return 100;
-}
+static const struct de_module_sig cazip_sigs[] = {
+	{ 0, 8, 100, "\x0d\x0a\x1a" "CAZIP" }
+};
 
 void de_module_cazip(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "cazip";
 	mi->desc = "CAZIP compressed file";
 	mi->run_fn = de_run_cazip;
-	mi->identify_fn = de_identify_cazip;
+	mi->sigs = cazip_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(cazip_sigs);
 }
 
 // **************************************************************************
@@ -2394,18 +2389,17 @@ done:
 	}
 }
 
-static int de_identify_hta(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\x89\x48\x54\x41\x0d\x0a\x1a\x0a", 8)) return 100;
-	return 0;
-}
+static const struct de_module_sig hta_sigs[] = {
+	{ 0, 8, 100, "\x89\x48\x54\x41\x0d\x0a\x1a\x0a" }
+};
 
 void de_module_hta(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "hta";
 	mi->desc = "Hemera thumbnails";
 	mi->run_fn = de_run_hta;
-	mi->identify_fn = de_identify_hta;
+	mi->sigs = hta_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(hta_sigs);
 }
 
 // **************************************************************************
@@ -698,6 +698,10 @@ static int ma_is_known_cmpr(unsigned int n)
 	return 1;
 }
 
+static const struct de_module_sig monkeys_audio_sigs[] = {
+	{ 0, 4, 0, "MAC " }
+};
+
 static int de_identify_monkeys_audio(deark *c)
 {
 	unsigned int n;
@@ -716,4 +720,6 @@ void de_module_monkeys_audio(deark *c, struct deark_module_info *mi)
 	mi->desc = "Monkey's Audio (.ape)";
 	mi->run_fn = de_run_monkeys_audio;
 	mi->identify_fn = de_identify_monkeys_audio;
+	mi->sigs = monkeys_audio_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(monkeys_audio_sigs);
 }
@@ -421,13 +421,18 @@ static int mslzh_have_enough_output(struct mslzh_context *lzhctx)
 	return 0;
 }
 
-static void mslzh_lz77buf_writebytecb(struct de_lz77buffer *rb, u8 n)
+static void mslzh_lz77buf_writespancb(struct de_lz77buffer *rb, const u8 *buf, UI len)
 {
 	struct mslzh_context *lzhctx = (struct mslzh_context*)rb->userdata;
 
-	if(mslzh_have_enough_output(lzhctx)) return;
-	dbuf_writebyte(lzhctx->dcmpro->f, n);
-	lzhctx->nbytes_written++;
+	if(lzhctx->dcmpro->len_known) {
+		i64 nbytes_wanted = lzhctx->dcmpro->expected_len - lzhctx->nbytes_written;
+
+		if(nbytes_wanted<=0) return;
+		if((i64)len > nbytes_wanted) len = (UI)nbytes_wanted;
+	}
+	dbuf_write(lzhctx->dcmpro->f, buf, (i64)len);
+	lzhctx->nbytes_written += (i64)len;
 }
 
 static void mslzh_decompress_main(struct mslzh_context *lzhctx)
@@ -542,7 +547,7 @@ static void do_decompress_LZHUFF(deark *c, struct de_dfilter_in_params *dcmpri,
 	}
 
 	lzhctx->ringbuf = de_lz77buffer_create(c, 4096);
-	lzhctx->ringbuf->writebyte_cb = mslzh_lz77buf_writebytecb;
+	lzhctx->ringbuf->write_span_cb = mslzh_lz77buf_writespancb;
 	lzhctx->ringbuf->userdata = (void*)lzhctx;
 	de_lz77buffer_clear(lzhctx->ringbuf, 0x20);
 
@@ -964,19 +969,16 @@ done:
 	}
 }
 
-static int de_identify_is_ibt(deark *c)
-{
+static const struct de_module_sig is_ibt_sigs[] = {
 	// TODO? Better identification
-	if(!dbuf_memcmp(c->infile, 0, (const void*)"setup.dl_\0setup.dll\0", 20)) {
-		return 90;
-	}
-	return 0;
-}
+	{ 0, 20, 90, "setup.dl_\0setup.dll\0" }
+};
 
 void de_module_is_ibt(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "is_ibt";
 	mi->desc = "InstallShield IBT archive";
 	mi->run_fn = de_run_is_ibt;
-	mi->identify_fn = de_identify_is_ibt;
+	mi->sigs = is_ibt_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(is_ibt_sigs);
 }
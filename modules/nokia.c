@@ -60,18 +60,17 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_nol(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "NOL", 3)) return 80;
-	return 0;
-}
+static const struct de_module_sig nol_sigs[] = {
+	{ 0, 3, 80, "NOL" }
+};
 
 void de_module_nol(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "nol";
 	mi->desc = "Nokia Operator Logo";
 	mi->run_fn = de_run_nol;
-	mi->identify_fn = de_identify_nol;
+	mi->sigs = nol_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(nol_sigs);
 }
 
 // **************************************************************************
@@ -96,18 +95,17 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_ngg(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "NGG", 3)) return 80;
-	return 0;
-}
+static const struct de_module_sig ngg_sigs[] = {
+	{ 0, 3, 80, "NGG" }
+};
 
 void de_module_ngg(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "ngg";
 	mi->desc = "Nokia Group Graphic";
 	mi->run_fn = de_run_ngg;
-	mi->identify_fn = de_identify_ngg;
+	mi->sigs = ngg_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ngg_sigs);
 }
 
 // **************************************************************************
@@ -153,18 +151,17 @@ static void de_run_npm(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_npm(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "NPM", 3)) return 80;
-	return 0;
-}
+static const struct de_module_sig npm_sigs[] = {
+	{ 0, 3, 80, "NPM" }
+};
 
 void de_module_npm(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "npm";
 	mi->desc = "Nokia Picture Message";
 	mi->run_fn = de_run_npm;
-	mi->identify_fn = de_identify_npm;
+	mi->sigs = npm_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(npm_sigs);
 }
 
 // **************************************************************************
@@ -200,18 +197,17 @@ static void de_run_nlm(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_nlm(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "NLM ", 4)) return 80;
-	return 0;
-}
+static const struct de_module_sig nlm_sigs[] = {
+	{ 0, 4, 80, "NLM " }
+};
 
 void de_module_nlm(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "nlm";
 	mi->desc = "Nokia Logo Manager bitmap";
 	mi->run_fn = de_run_nlm;
-	mi->identify_fn = de_identify_nlm;
+	mi->sigs = nlm_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(nlm_sigs);
 }
 
 // **************************************************************************
@@ -299,6 +295,10 @@ static void de_run_nsl(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
+static const struct de_module_sig nsl_sigs[] = {
+	{ 0, 4, 0, "FORM" }
+};
+
 static int de_identify_nsl(deark *c)
 {
 	i64 x;
@@ -323,4 +323,6 @@ void de_module_nsl(deark *c, struct deark_module_info *mi)
 	mi->desc = "Nokia Startup Logo";
 	mi->run_fn = de_run_nsl;
 	mi->identify_fn = de_identify_nsl;
+	mi->sigs = nsl_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(nsl_sigs);
 }
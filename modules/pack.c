@@ -166,6 +166,10 @@ done:
 	}
 }
 
+static const struct de_module_sig pack_sigs[] = {
+	{ 0, 2, 0, "\x1f\x1e" }
+};
+
 static int de_identify_pack(deark *c)
 {
 	if(!dbuf_memcmp(c->infile, 0, "\x1f\x1e", 2)) {
@@ -183,4 +187,6 @@ void de_module_pack(deark *c, struct deark_module_info *mi)
 	mi->desc = "Unix pack (.z)";
 	mi->run_fn = de_run_pack;
 	mi->identify_fn = de_identify_pack;
+	mi->sigs = pack_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(pack_sigs);
 }
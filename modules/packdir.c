@@ -310,6 +310,10 @@ done:
 	}
 }
 
+static const struct de_module_sig packdir_sigs[] = {
+	{ 0, 5, 0, "PACK\0" }
+};
+
 static int de_identify_packdir(deark *c)
 {
 	i64 n;
@@ -327,4 +331,6 @@ void de_module_packdir(deark *c, struct deark_module_info *mi)
 	mi->desc = "PackDir compressed archive format";
 	mi->run_fn = de_run_packdir;
 	mi->identify_fn = de_identify_packdir;
+	mi->sigs = packdir_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(packdir_sigs);
 }
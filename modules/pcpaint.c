@@ -1021,19 +1021,16 @@ done:
 	destroy_lctx(c, d);
 }
 
-static int de_identify_bsave_cmpr(deark *c)
-{
+static const struct de_module_sig bsave_cmpr_sigs[] = {
 	// This probably doesn't detect images that aren't 320x200, if such things exist.
-	if(dbuf_memcmp(c->infile, 0, (const u8*)"\xfd\0\xb8\0\0\0\0\0\x40\x02\0", 11)) {
-		return 0;
-	}
-	return 100;
-}
+	{ 0, 11, 100, "\xfd\0\xb8\0\0\0\0\0\x40\x02\0" }
+};
 
 void de_module_bsave_cmpr(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "bsave_cmpr";
 	mi->desc = "PCPaint compressed BSAVE";
 	mi->run_fn = de_run_bsave_cmpr;
-	mi->identify_fn = de_identify_bsave_cmpr;
+	mi->sigs = bsave_cmpr_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(bsave_cmpr_sigs);
 }
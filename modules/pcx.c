@@ -793,19 +793,17 @@ static void de_run_dcx(deark *c, de_module_params *mparams)
 	}
 }
 
-static int de_identify_dcx(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "\xb1\x68\xde\x3a", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig dcx_sigs[] = {
+	{ 0, 4, 100, "\xb1\x68\xde\x3a" }
+};
 
 void de_module_dcx(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "dcx";
 	mi->desc = "DCX (multi-image PCX)";
 	mi->run_fn = de_run_dcx;
-	mi->identify_fn = de_identify_dcx;
+	mi->sigs = dcx_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(dcx_sigs);
 }
 
 // **************************************************************************
@@ -196,12 +196,9 @@ done:
 	de_dbg_indent_restore(c, saved_indent_level);
 }
 
-static int de_identify_pkm(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "PKM\0", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig pkm_sigs[] = {
+	{ 0, 4, 100, "PKM\0" }
+};
 
 static void de_help_pkm(deark *c)
 {
@@ -213,6 +210,7 @@ void de_module_pkm(deark *c, struct deark_module_info *mi)
 	mi->id = "pkm";
 	mi->desc = "PKM (GrafX2)";
 	mi->run_fn = de_run_pkm;
-	mi->identify_fn = de_identify_pkm;
+	mi->sigs = pkm_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(pkm_sigs);
 	mi->help_fn = de_help_pkm;
 }
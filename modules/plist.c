@@ -463,17 +463,15 @@ done:
 	}
 }
 
-static int de_identify_plist(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "bplist00", 8))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig plist_sigs[] = {
+	{ 0, 8, 100, "bplist00" }
+};
 
 void de_module_plist(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "plist";
 	mi->desc = ".plist property list, binary format";
 	mi->run_fn = de_run_plist;
-	mi->identify_fn = de_identify_plist;
+	mi->sigs = plist_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(plist_sigs);
 }
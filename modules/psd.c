@@ -3673,6 +3673,7 @@ static void do_bitmap_packbits(deark *c, lctx *d, zztype *zz, const struct image
 {
 	dbuf *unc_pixels = NULL;
 	i64 cmpr_data_size = 0;
+	i64 unc_data_size;
 	i64 k;
 
 	// Data begins with a table of row byte counts.
@@ -3694,10 +3695,14 @@ static void do_bitmap_packbits(deark *c, lctx *d, zztype *zz, const struct image
 		goto done;
 	}
 
-	unc_pixels = dbuf_create_membuf(c, 1024, 0);
-	dbuf_enable_wbuffer(unc_pixels);
+	// All the channels are decompressed in one go, into a membuf that's
+	// (usually) already big enough.
+	// PackBits can't expand data by more than a factor of 64.
+	unc_data_size = iinfo->num_channels * iinfo->height *
+		((iinfo->width * iinfo->bits_per_channel + 7)/8);
+	unc_data_size = de_min_int(unc_data_size, cmpr_data_size*64);
+	unc_pixels = dbuf_create_membuf(c, de_max_int(unc_data_size, 1024), 0);
 	fmtutil_decompress_packbits(c->infile, zz->pos, cmpr_data_size, unc_pixels, NULL);
-	dbuf_flush(unc_pixels);
 	zz->pos += cmpr_data_size;
 	de_dbg_indent(c, 1);
 	de_dbg(c, "decompressed %"I64_FMT" bytes to %"I64_FMT"", cmpr_data_size, unc_pixels->len);
@@ -4223,6 +4228,11 @@ void de_module_psd(deark *c, struct deark_module_info *mi)
 	mi->identify_fn = de_identify_psd;
 }
 
+static const struct de_module_sig ps_action_sigs[] = {
+	{ 0, 6, 0, "\x00\x00\x00\x10\x00\x00" },
+	{ 0, 4, 0, "\x00\x00\x00\x0c" }
+};
+
 static int de_identify_ps_action(deark *c)
 {
 	int ver=0;
@@ -4245,8 +4255,14 @@ void de_module_ps_action(deark *c, struct deark_module_info *mi)
 	mi->desc = "Photoshop Action";
 	mi->run_fn = de_run_ps_action;
 	mi->identify_fn = de_identify_ps_action;
+	mi->sigs = ps_action_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ps_action_sigs);
 }
 
+static const struct de_module_sig ps_gradient_sigs[] = {
+	{ 0, 4, 0, "8BGR" }
+};
+
 static int de_identify_ps_gradient(deark *c)
 {
 	if(!dbuf_memcmp(c->infile, 0, "8BGR", 4)) {
@@ -4262,8 +4278,14 @@ void de_module_ps_gradient(deark *c, struct deark_module_info *mi)
 	mi->desc = "Photoshop Gradient";
 	mi->run_fn = de_run_ps_gradient;
 	mi->identify_fn = de_identify_ps_gradient;
+	mi->sigs = ps_gradient_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ps_gradient_sigs);
 }
 
+static const struct de_module_sig ps_styles_sigs[] = {
+	{ 2, 4, 0, "8BSL" }
+};
+
 static int de_identify_ps_styles(deark *c)
 {
 	if(!dbuf_memcmp(c->infile, 2, "8BSL", 4)) {
@@ -4279,6 +4301,8 @@ void de_module_ps_styles(deark *c, struct deark_module_info *mi)
 	mi->desc = "Photoshop Styles";
 	mi->run_fn = de_run_ps_styles;
 	mi->identify_fn = de_identify_ps_styles;
+	mi->sigs = ps_styles_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ps_styles_sigs);
 }
 
 static int de_identify_ps_brush(deark *c)
@@ -4300,6 +4324,10 @@ void de_module_ps_brush(deark *c, struct deark_module_info *mi)
 	mi->identify_fn = de_identify_ps_brush;
 }
 
+static const struct de_module_sig ps_csh_sigs[] = {
+	{ 0, 4, 0, "cush" }
+};
+
 static int de_identify_ps_csh(deark *c)
 {
 	if(!dbuf_memcmp(c->infile, 0, "cush", 4)) {
@@ -4315,8 +4343,14 @@ void de_module_ps_csh(deark *c, struct deark_module_info *mi)
 	mi->desc = "Photoshop Custom Shape";
 	mi->run_fn = de_run_ps_csh;
 	mi->identify_fn = de_identify_ps_csh;
+	mi->sigs = ps_csh_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ps_csh_sigs);
 }
 
+static const struct de_module_sig ps_pattern_sigs[] = {
+	{ 0, 4, 0, "8BPT" }
+};
+
 static int de_identify_ps_pattern(deark *c)
 {
 	if(!dbuf_memcmp(c->infile, 0, "8BPT", 4)) {
@@ -4332,4 +4366,6 @@ void de_module_ps_pattern(deark *c, struct deark_module_info *mi)
 	mi->desc = "Photoshop Pattern";
 	mi->run_fn = de_run_ps_pattern;
 	mi->identify_fn = de_identify_ps_pattern;
+	mi->sigs = ps_pattern_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(ps_pattern_sigs);
 }
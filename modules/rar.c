@@ -1091,16 +1091,51 @@ static int rar_get_fmtver(dbuf *f, i64 pos)
 	return 0;
 }
 
-static int rar_search_for_archive(deark *c, de_arch_lctx *d, i64 *pfoundpos)
+struct rar_search_ctx {
+	u8 found_new;
+	u8 found_old;
+	i64 pos_new;
+	i64 pos_old;
+};
+
+static int rar_search_cbfn(deark *c, void *userdata, UI id, i64 pos)
 {
-	int ret;
+	struct rar_search_ctx *sctx = (struct rar_search_ctx*)userdata;
 
-	// Search for the common prefix of g_rar4_sig & g_rar5_sig
-	ret = dbuf_search(c->infile, g_rar4_sig, 6, 0, c->infile->len, pfoundpos);
-	if(ret) return 1;
+	if(id==1) {
+		sctx->found_new = 1;
+		sctx->pos_new = pos;
+		return 0;
+	}
+	if(!sctx->found_old) {
+		sctx->found_old = 1;
+		sctx->pos_old = pos;
+	}
+	return 1;
+}
 
-	ret = dbuf_search(c->infile, g_rar_oldsig, 4, 0, c->infile->len, pfoundpos);
-	if(ret) return 1;
+static int rar_search_for_archive(deark *c, de_arch_lctx *d, i64 *pfoundpos)
+{
+	struct de_multisearch *ms;
+	struct rar_search_ctx sctx;
+
+	// Prefer a RAR 1.5+ signature anywhere in the file, over an old one.
+	// (We search for the common prefix of g_rar4_sig & g_rar5_sig.)
+	de_zeromem(&sctx, sizeof(struct rar_search_ctx));
+	ms = de_multisearch_create(c);
+	de_multisearch_add_needle(c, ms, g_rar4_sig, 6, 1);
+	de_multisearch_add_needle(c, ms, g_rar_oldsig, 4, 2);
+	dbuf_multisearch(c->infile, ms, 0, c->infile->len, rar_search_cbfn, (void*)&sctx);
+	de_multisearch_destroy(c, ms);
+
+	if(sctx.found_new) {
+		*pfoundpos = sctx.pos_new;
+		return 1;
+	}
+	if(sctx.found_old) {
+		*pfoundpos = sctx.pos_old;
+		return 1;
+	}
 	return 0;
 }
 
@@ -206,17 +206,15 @@ static void de_run_rm(deark *c, de_module_params *mparams)
 	de_free(c, d);
 }
 
-static int de_identify_rm(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, ".RMF\0", 5))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig rm_sigs[] = {
+	{ 0, 5, 100, ".RMF\0" }
+};
 
 void de_module_rm(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "rm";
 	mi->desc = "RealMedia";
 	mi->run_fn = de_run_rm;
-	mi->identify_fn = de_identify_rm;
+	mi->sigs = rm_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(rm_sigs);
 }
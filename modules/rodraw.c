@@ -181,21 +181,16 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_rodraw(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "Draw", 4)) {
-		if(!dbuf_memcmp(c->infile, 4, "\xc9\0\0\0\0\0\0\0", 8)) {
-			return 100;
-		}
-		return 49;
-	}
-	return 0;
-}
+static const struct de_module_sig rodraw_sigs[] = {
+	{ 0, 4, 49, "Draw" },
+	{ 0, 12, 100, "Draw\xc9\0\0\0\0\0\0\0" }
+};
 
 void de_module_rodraw(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "rodraw";
 	mi->desc = "RISC OS Draw, Acorn Draw";
 	mi->run_fn = de_run_rodraw;
-	mi->identify_fn = de_identify_rodraw;
+	mi->sigs = rodraw_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(rodraw_sigs);
 }
@@ -606,21 +606,16 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_sis(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 8, "\x19\x04\x00\x10", 4)) {
-		if(!dbuf_memcmp(c->infile, 4, "\x6d\x00\x00\x10", 4))
-			return 100;
-		if(!dbuf_memcmp(c->infile, 4, "\x12\x3a\x00\x10", 4))
-			return 100;
-	}
-	return 0;
-}
+static const struct de_module_sig sis_sigs[] = {
+	{ 4, 8, 100, "\x6d\x00\x00\x10\x19\x04\x00\x10" },
+	{ 4, 8, 100, "\x12\x3a\x00\x10\x19\x04\x00\x10" }
+};
 
 void de_module_sis(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "sis";
 	mi->desc = "SIS (EPOC/Symbian installation archive)";
 	mi->run_fn = de_run_sis;
-	mi->identify_fn = de_identify_sis;
+	mi->sigs = sis_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(sis_sigs);
 }
@@ -356,6 +356,10 @@ static void de_run_spectrum512c(deark *c, de_module_params *mparams)
 	do_run_spectrum512c_s_internal(c, mparams, 0);
 }
 
+static const struct de_module_sig spectrum512c_sigs[] = {
+	{ 0, 4, 0, "\x53\x50\x00\x00" }
+};
+
 static int de_identify_spectrum512c(deark *c)
 {
 	if(dbuf_memcmp(c->infile, 0, "\x53\x50\x00\x00", 4))
@@ -384,6 +388,8 @@ void de_module_spectrum512c(deark *c, struct deark_module_info *mi)
 	mi->desc = "Spectrum 512 Compressed";
 	mi->run_fn = de_run_spectrum512c;
 	mi->identify_fn = de_identify_spectrum512c;
+	mi->sigs = spectrum512c_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(spectrum512c_sigs);
 	mi->help_fn = de_help_spectrum512cs;
 }
 
@@ -392,6 +398,10 @@ static void de_run_spectrum512s(deark *c, de_module_params *mparams)
 	do_run_spectrum512c_s_internal(c, mparams, 1);
 }
 
+static const struct de_module_sig spectrum512s_sigs[] = {
+	{ 0, 4, 0, "\x53\x50\x00\x00" }
+};
+
 static int de_identify_spectrum512s(deark *c)
 {
 	if(dbuf_memcmp(c->infile, 0, "\x53\x50\x00\x00", 4))
@@ -411,5 +421,7 @@ void de_module_spectrum512s(deark *c, struct deark_module_info *mi)
 	mi->desc = "Spectrum 512 Smooshed";
 	mi->run_fn = de_run_spectrum512s;
 	mi->identify_fn = de_identify_spectrum512s;
+	mi->sigs = spectrum512s_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(spectrum512s_sigs);
 	mi->help_fn = de_help_spectrum512cs;
 }
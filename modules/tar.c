@@ -134,7 +134,8 @@ static int read_phys_member_header(deark *c, lctx *d,
 	de_ucstring *tmpstr = NULL;
 	int retval = 0;
 	int saved_indent_level;
-	u8 hdrblock[512];
+	const u8 *hdrblock;
+	u8 hdrbuf[512];
 
 	de_dbg_indent_save(c, &saved_indent_level);
 
@@ -143,7 +144,7 @@ static int read_phys_member_header(deark *c, lctx *d,
 
 	// Look ahead to try to figure out some things about the format of this member.
 
-	de_read(hdrblock, pos1, 512);
+	hdrblock = dbuf_get_span(c->infile, pos1, 512, hdrbuf);
 	calc_checksum(c, d, pmd, hdrblock);
 
 	if(pmd->checksum_calc==8*32 && de_is_all_zeroes(&hdrblock[148], 8)) {
@@ -217,7 +218,7 @@ static int read_phys_member_header(deark *c, lctx *d,
 		de_byte_to_printable_char(pmd->linkflag));
 	pos += 1;
 
-	if(de_getbyte(pos)!=0) {
+	if(hdrblock[pos-pos1]!=0) {
 		pmd->linkname = dbuf_read_string(c->infile, pos, 100, 100, DE_CONVFLAG_STOP_AT_NUL,
 			d->input_encoding);
 		de_dbg(c, "linkname: \"%s\"", ucstring_getpsz_d(pmd->linkname->str));
@@ -261,7 +262,7 @@ static int read_phys_member_header(deark *c, lctx *d,
 	// worth trying to detect them?
 	// And "star" files can have atime/ctime fields at offset 476.
 
-	if((pmd->fmt==TARFMT_POSIX || pmd->fmt==TARFMT_STAR) && (de_getbyte(pos)!=0)) {
+	if((pmd->fmt==TARFMT_POSIX || pmd->fmt==TARFMT_STAR) && (hdrblock[pos-pos1]!=0)) {
 		// This field might only be 131 bytes, instead of 155. Let's hope that
 		// it's NUL terminated in that case.
 		pmd->prefix = ucstring_create(c);
@@ -152,6 +152,10 @@ done:
 	de_free(c, d);
 }
 
+static const struct de_module_sig tim_sigs[] = {
+	{ 0, 4, 0, "\x10\x00\x00\x00" }
+};
+
 static int de_identify_tim(deark *c)
 {
 	i64 x;
@@ -173,4 +177,6 @@ void de_module_tim(deark *c, struct deark_module_info *mi)
 	mi->desc = "PlayStation graphics";
 	mi->run_fn = de_run_tim;
 	mi->identify_fn = de_identify_tim;
+	mi->sigs = tim_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(tim_sigs);
 }
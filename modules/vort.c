@@ -470,17 +470,15 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_vort(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 0, "VORT01", 6))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig vort_sigs[] = {
+	{ 0, 6, 100, "VORT01" }
+};
 
 void de_module_vort(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "vort";
 	mi->desc = "VORT ray tracer PIX image";
 	mi->run_fn = de_run_vort;
-	mi->identify_fn = de_identify_vort;
+	mi->sigs = vort_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(vort_sigs);
 }
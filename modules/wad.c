@@ -98,20 +98,16 @@ done:
 	de_free(c, d);
 }
 
-static int de_identify_wad(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 1, "WAD", 3)) {
-		u8 b0;
-		b0 = de_getbyte(0);
-		if(b0=='I' || b0=='P') return 80;
-	}
-	return 0;
-}
+static const struct de_module_sig wad_sigs[] = {
+	{ 0, 4, 80, "IWAD" },
+	{ 0, 4, 80, "PWAD" }
+};
 
 void de_module_wad(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "wad";
 	mi->desc = "Doom WAD";
 	mi->run_fn = de_run_wad;
-	mi->identify_fn = de_identify_wad;
+	mi->sigs = wad_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(wad_sigs);
 }
@@ -1311,7 +1311,7 @@ static void describe_general_purpose_bit_flags(deark *c, struct dir_entry_data *
 static int do_file_header(deark *c, lctx *d, struct member_data *md,
 	int is_central, i64 pos1, i64 *p_entry_size)
 {
-	i64 pos;
+	i64 pos; // Offset into hdr[]
 	u32 sig;
 	i64 fn_len, extra_len, comment_len;
 	int utf8_flag;
@@ -1321,14 +1321,15 @@ static int do_file_header(deark *c, lctx *d, struct member_data *md,
 	struct dir_entry_data *dd; // Points to either md->central or md->local
 	de_ucstring *descr = NULL;
 	struct de_timestamp dos_timestamp;
+	const u8 *hdr;
+	u8 hdrbuf[46];
 	char timestamp_buf[64];
 
-	pos = pos1;
 	descr = ucstring_create(c);
 	if(is_central) {
 		dd = &md->central_dir_entry_data;
 		fixed_header_size = 46;
-		de_dbg(c, "central dir entry at %"I64_FMT, pos);
+		de_dbg(c, "central dir entry at %"I64_FMT, pos1);
 	}
 	else {
 		dd = &md->local_dir_entry_data;
@@ -1337,11 +1338,17 @@ static int do_file_header(deark *c, lctx *d, struct member_data *md,
 			de_err(c, "Member file not in this ZIP file");
 			return 0;
 		}
-		de_dbg(c, "local file header at %"I64_FMT, pos);
+		de_dbg(c, "local file header at %"I64_FMT, pos1);
 	}
 	de_dbg_indent(c, 1);
 
-	sig = (u32)de_getu32be_p(&pos);
+	// Read the fixed-size part of the header all at once, preferably without
+	// copying it.
+	hdr = dbuf_get_span(c->infile, pos1, fixed_header_size, hdrbuf);
+	pos = 0;
+
+	sig = (u32)de_getu32be_direct(&hdr[pos]);
+	pos += 4;
 	if(is_central && sig!=(d->is_resof?CODE_PK14:CODE_PK12)) {
 		de_err(c, "Central dir file header not found at %"I64_FMT, pos1);
 		goto done;
@@ -1352,7 +1359,8 @@ static int do_file_header(deark *c, lctx *d, struct member_data *md,
 	}
 
 	if(is_central) {
-		md->ver_made_by = (UI)de_getu16le_p(&pos);
+		md->ver_made_by = (UI)de_getu16le_direct(&hdr[pos]);
+		pos += 2;
 		md->ver_made_by_hi = (UI)((md->ver_made_by&0xff00)>>8);
 		md->ver_made_by_lo = (UI)(md->ver_made_by&0x00ff);
 		de_dbg(c, "version made by: platform=%u (%s), ZIP spec=%u.%u",
@@ -1360,15 +1368,18 @@ static int do_file_header(deark *c, lctx *d, struct member_data *md,
 			(UI)(md->ver_made_by_lo/10), (UI)(md->ver_made_by_lo%10));
 	}
 
-	dd->ver_needed = (UI)de_getu16le_p(&pos);
+	dd->ver_needed = (UI)de_getu16le_direct(&hdr[pos]);
+	pos += 2;
 	dd->ver_needed_hi = (UI)((dd->ver_needed&0xff00)>>8);
 	dd->ver_needed_lo = (UI)(dd->ver_needed&0x00ff);
 	de_dbg(c, "version needed to extract: platform=%u (%s), ZIP spec=%u.%u",
 		dd->ver_needed_hi, get_platform_name(dd->ver_needed_hi),
 		(UI)(dd->ver_needed_lo/10), (UI)(dd->ver_needed_lo%10));
 
-	dd->bit_flags = (UI)de_getu16le_p(&pos);
-	dd->cmpr_meth = (int)de_getu16le_p(&pos);
+	dd->bit_flags = (UI)de_getu16le_direct(&hdr[pos]);
+	pos += 2;
+	dd->cmpr_meth = (int)de_getu16le_direct(&hdr[pos]);
+	pos += 2;
 	dd->cmi = get_cmpr_meth_info(dd->cmpr_meth);
 
 	utf8_flag = (dd->bit_flags & 0x800)?1:0;
@@ -1379,45 +1390,55 @@ static int do_file_header(deark *c, lctx *d, struct member_data *md,
 	de_dbg(c, "cmpr method: %d (%s)", dd->cmpr_meth,
 		(dd->cmi ? dd->cmi->name : "?"));
 
-	mod_time_raw = de_getu16le_p(&pos);
-	mod_date_raw = de_getu16le_p(&pos);
+	mod_time_raw = de_getu16le_direct(&hdr[pos]);
+	mod_date_raw = de_getu16le_direct(&hdr[pos+2]);
+	pos += 4;
 	de_dos_datetime_to_timestamp(&dos_timestamp, mod_date_raw, mod_time_raw);
 	dos_timestamp.tzcode = DE_TZCODE_LOCAL;
 	de_dbg_timestamp_to_string(c, &dos_timestamp, timestamp_buf, sizeof(timestamp_buf), 0);
 	de_dbg(c, "mod time: %s", timestamp_buf);
 	apply_timestamp(c, d, md, DE_TIMESTAMPIDX_MODIFY, &dos_timestamp, 10);
 
-	dd->crc_reported = (u32)de_getu32le_p(&pos);
+	dd->crc_reported = (u32)de_getu32le_direct(&hdr[pos]);
+	pos += 4;
 	de_dbg(c, "crc (reported): 0x%08x", (UI)dd->crc_reported);
 
-	dd->cmpr_size = de_getu32le_p(&pos);
+	dd->cmpr_size = de_getu32le_direct(&hdr[pos]);
+	pos += 4;
 	de_dbg(c, "cmpr size: %" I64_FMT, dd->cmpr_size);
-	dd->uncmpr_size = de_getu32le_p(&pos);
+	dd->uncmpr_size = de_getu32le_direct(&hdr[pos]);
+	pos += 4;
 	de_dbg(c, "uncmpr size: %" I64_FMT, dd->uncmpr_size);
 
-	fn_len = de_getu16le_p(&pos);
-	extra_len = de_getu16le_p(&pos);
+	fn_len = de_getu16le_direct(&hdr[pos]);
+	pos += 2;
+	extra_len = de_getu16le_direct(&hdr[pos]);
+	pos += 2;
 	if(is_central) {
-		comment_len = de_getu16le_p(&pos);
+		comment_len = de_getu16le_direct(&hdr[pos]);
+		pos += 2;
 	}
 	else {
 		comment_len = 0;
 	}
 
 	if(!is_central) {
-		md->file_data_pos = pos + fn_len + extra_len;
+		md->file_data_pos = pos1 + fixed_header_size + fn_len + extra_len;
 	}
 
 	if(is_central) {
-		md->disk_number_start = de_getu16le_p(&pos);
+		md->disk_number_start = de_getu16le_direct(&hdr[pos]);
+		pos += 2;
 
-		md->attr_i = (UI)de_getu16le_p(&pos);
+		md->attr_i = (UI)de_getu16le_direct(&hdr[pos]);
+		pos += 2;
 		ucstring_empty(descr);
 		describe_internal_attr(c, md, descr);
 		de_dbg(c, "internal file attributes: 0x%04x (%s)", md->attr_i,
 			ucstring_getpsz(descr));
 
-		md->attr_e = (UI)de_getu32le_p(&pos);
+		md->attr_e = (UI)de_getu32le_direct(&hdr[pos]);
+		pos += 4;
 		de_dbg(c, "external file attributes: 0x%08x", md->attr_e);
 		de_dbg_indent(c, 1);
 
@@ -1446,7 +1467,8 @@ static int do_file_header(deark *c, lctx *d, struct member_data *md,
 
 		de_dbg_indent(c, -1);
 
-		md->offset_of_local_header = de_getu32le_p(&pos);
+		md->offset_of_local_header = de_getu32le_direct(&hdr[pos]);
+		pos += 4;
 		de_dbg(c, "offset of local header: %"I64_FMT", disk: %d", md->offset_of_local_header,
 			(int)md->disk_number_start);
 	}
@@ -693,12 +693,9 @@ done:
 	de_dbg_indent_restore(c, saved_indent_level);
 }
 
-static int de_identify_zoo(deark *c)
-{
-	if(!dbuf_memcmp(c->infile, 20, "\xdc\xa7\xc4\xfd", 4))
-		return 100;
-	return 0;
-}
+static const struct de_module_sig zoo_sigs[] = {
+	{ 20, 4, 100, "\xdc\xa7\xc4\xfd" }
+};
 
 static void de_help_zoo(deark *c)
 {
@@ -710,7 +707,8 @@ void de_module_zoo(deark *c, struct deark_module_info *mi)
 	mi->id = "zoo";
 	mi->desc = "Zoo compressed archive format";
 	mi->run_fn = de_run_zoo;
-	mi->identify_fn = de_identify_zoo;
+	mi->sigs = zoo_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(zoo_sigs);
 	mi->help_fn = de_help_zoo;
 }
 
@@ -909,16 +907,15 @@ done:
 	de_free(c, zctx);
 }
 
-static int de_identify_zoo_z(deark *c)
-{
-	if(dbuf_memcmp(c->infile, 0, "\xfe\x07\x01", 3)) return 0;
-	return 80;
-}
+static const struct de_module_sig zoo_z_sigs[] = {
+	{ 0, 3, 80, "\xfe\x07\x01" }
+};
 
 void de_module_zoo_z(deark *c, struct deark_module_info *mi)
 {
 	mi->id = "zoo_z";
 	mi->desc = "Zoo Z format";
 	mi->run_fn = de_run_zoo_z;
-	mi->identify_fn = de_identify_zoo_z;
+	mi->sigs = zoo_z_sigs;
+	mi->num_sigs = (int)DE_ARRAYCOUNT(zoo_z_sigs);
 }
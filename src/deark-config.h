@@ -36,6 +36,10 @@
 #define DE_USE_WINDOWS_INTTYPES 1
 #endif
 
+#ifndef DE_USE_MMAP
+#define DE_USE_MMAP 1
+#endif
+
 #endif
 
 #ifdef DE_UNIX
@@ -54,10 +58,42 @@
 #define DE_USE_LSTAT 1
 #endif
 
+#ifndef DE_USE_MMAP
+#ifdef DE_BUILDFLAG_AMIGA
+#define DE_USE_MMAP 0
+#else
+#define DE_USE_MMAP 1
+#endif
+#endif
+
+#ifndef DE_USE_COPY_FILE_RANGE
+#ifdef __linux__
+#define DE_USE_COPY_FILE_RANGE 1
+#else
+#define DE_USE_COPY_FILE_RANGE 0
+#endif
+#endif
+
 #ifndef DE_USE_WINDOWS_INTTYPES
 #define DE_USE_WINDOWS_INTTYPES 0
 #endif
 
+// Threads are only used by the optional threaded mode of multi-stage
+// decompression. Enabling this requires linking with -pthread.
+#ifndef DE_USE_THREADS
+#define DE_USE_THREADS 0
+#endif
+
+#endif
+
+// Use CPU-specific CRC-32 code (PCLMULQDQ on x86-64, or the ARMv8 CRC32
+// instructions), if the CPU supports it. There is always a portable fallback.
+#ifndef DE_USE_CRC32_ACCEL
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define DE_USE_CRC32_ACCEL 1
+#else
+#define DE_USE_CRC32_ACCEL 0
+#endif
 #endif
 
 // Post-system-header platform-specific things can optionally go in a
@@ -14,12 +14,189 @@
 #define DE_MAX_MEMBUF_SIZE 2000000000
 #define DE_RCACHE_SIZE 262144
 #define DE_WBUFFER_SIZE 512
+#define DE_OBUF_INITIAL_SIZE 16384
+#define DE_ZEROCOPY_MIN_SIZE 65536
 // Support at least this many virtual bytes before or after the actual file.
 #define DE_ALLOWED_VIRTUAL_BYTES 16384
 
+// Settings for the block cache used by DBUF_TYPE_IFILE, when the file isn't
+// memory-mapped.
+#define DE_BCACHE_BLKSIZE 65536
+#define DE_BCACHE_NUMWAYS 4
+// Reads larger than this bypass the block cache.
+#define DE_BCACHE_MAX_CACHED_READ (2*DE_BCACHE_BLKSIZE)
+
+struct de_bcache_blk {
+	i64 blknum; // -1 if this slot is unused
+	i64 nbytes; // Number of valid bytes in data[]
+	u64 last_used;
+	u8 *data; // Allocated on first use
+};
+
+// An N-way set-associative cache of DE_BCACHE_BLKSIZE-byte blocks, with LRU
+// replacement within each set.
+struct de_blockcache {
+	UI nsets;
+	UI nblks; // = nsets*DE_BCACHE_NUMWAYS
+	u64 usage_counter;
+	u64 num_hits;
+	u64 num_misses;
+	struct de_bcache_blk *mru_blk; // Most recently used, or NULL
+	struct de_bcache_blk *blks; // array[nblks]
+};
+
+static void bcache_create(dbuf *f)
+{
+	deark *c = f->c;
+	struct de_blockcache *bc;
+	i64 nsets;
+	UI k;
+
+	if(!f->fp) return;
+	if(f->bcache) return;
+	if(c->iocache_size<=0) return;
+	// Only worth it if the file is larger than the rcache.
+	if(f->len <= f->rcache_bytes_used) return;
+
+	nsets = de_pad_to_n(c->iocache_size, DE_BCACHE_BLKSIZE*DE_BCACHE_NUMWAYS) /
+		(DE_BCACHE_BLKSIZE*DE_BCACHE_NUMWAYS);
+	if(nsets<1) nsets = 1;
+	if(nsets>1024) nsets = 1024;
+
+	bc = de_malloc(c, sizeof(struct de_blockcache));
+	bc->nsets = (UI)nsets;
+	bc->nblks = bc->nsets * DE_BCACHE_NUMWAYS;
+	bc->blks = de_mallocarray(c, (i64)bc->nblks, sizeof(struct de_bcache_blk));
+	for(k=0; k<bc->nblks; k++) {
+		bc->blks[k].blknum = -1;
+	}
+	f->bcache = bc;
+}
+
+static void bcache_destroy(dbuf *f)
+{
+	deark *c = f->c;
+	struct de_blockcache *bc = f->bcache;
+	UI k;
+
+	if(!bc) return;
+	de_dbg2(c, "read cache for %s: %"U64_FMT" hits, %"U64_FMT" misses",
+		(f->name ? f->name : "input file"), bc->num_hits, bc->num_misses);
+	for(k=0; k<bc->nblks; k++) {
+		de_free(c, bc->blks[k].data);
+	}
+	de_free(c, bc->blks);
+	de_free(c, bc);
+	f->bcache = NULL;
+}
+
+static i64 ifile_read_lowlevel(dbuf *f, u8 *buf, i64 pos, i64 len)
+{
+	i64 bytes_read;
+
+	// For performance reasons, don't call fseek if we're already at the
+	// right position.
+	if(!f->file_pos_known || f->file_pos!=pos) {
+		de_fseek(f->fp, pos, SEEK_SET);
+	}
+
+	bytes_read = fread(buf, 1, (size_t)len, f->fp);
+
+	f->file_pos = pos + bytes_read;
+	f->file_pos_known = 1;
+	return bytes_read;
+}
+
+// Returns the cache block containing file block #blknum, reading it from the
+// file if necessary.
+static struct de_bcache_blk *bcache_get_blk(dbuf *f, i64 blknum)
+{
+	struct de_blockcache *bc = f->bcache;
+	struct de_bcache_blk *set;
+	struct de_bcache_blk *victim;
+	i64 nbytes_to_read;
+	UI k;
+
+	bc->usage_counter++;
+
+	if(bc->mru_blk && bc->mru_blk->blknum==blknum) {
+		bc->num_hits++;
+		bc->mru_blk->last_used = bc->usage_counter;
+		return bc->mru_blk;
+	}
+
+	set = &bc->blks[(UI)(blknum % (i64)bc->nsets) * DE_BCACHE_NUMWAYS];
+	victim = &set[0];
+	for(k=0; k<DE_BCACHE_NUMWAYS; k++) {
+		if(set[k].blknum==blknum) {
+			bc->num_hits++;
+			set[k].last_used = bc->usage_counter;
+			bc->mru_blk = &set[k];
+			return &set[k];
+		}
+		if(set[k].last_used < victim->last_used) {
+			victim = &set[k];
+		}
+	}
+
+	// Not in the cache. Replace the least-recently-used block in this set.
+	bc->num_misses++;
+	if(!victim->data) {
+		victim->data = de_malloc(f->c, DE_BCACHE_BLKSIZE);
+	}
+	nbytes_to_read = f->len - blknum*DE_BCACHE_BLKSIZE;
+	if(nbytes_to_read>DE_BCACHE_BLKSIZE) nbytes_to_read = DE_BCACHE_BLKSIZE;
+	victim->blknum = blknum;
+	victim->nbytes = ifile_read_lowlevel(f, victim->data, blknum*DE_BCACHE_BLKSIZE,
+		nbytes_to_read);
+	victim->last_used = bc->usage_counter;
+	bc->mru_blk = victim;
+	return victim;
+}
+
+// Caller must have validated pos and len.
+static i64 bcache_read(dbuf *f, u8 *buf, i64 pos, i64 len)
+{
+	i64 bytes_read = 0;
+
+	while(bytes_read < len) {
+		struct de_bcache_blk *blk;
+		i64 offs_in_blk;
+		i64 n;
+
+		blk = bcache_get_blk(f, pos/DE_BCACHE_BLKSIZE);
+		offs_in_blk = pos%DE_BCACHE_BLKSIZE;
+		n = blk->nbytes - offs_in_blk;
+		if(n > len-bytes_read) n = len-bytes_read;
+		if(n<=0) break; // Unexpected end of file
+		de_memcpy(&buf[bytes_read], &blk->data[offs_in_blk], (size_t)n);
+		bytes_read += n;
+		pos += n;
+	}
+	return bytes_read;
+}
+
+// Try to memory-map the whole file, and use the mapping as the rcache.
+// Returns 0 if not possible.
+static int populate_rcache_mmap(dbuf *f)
+{
+	const u8 *mem = NULL;
+
+	if(f->c->disable_mmap) return 0;
+	f->mmapinfo = de_mmap_file_for_read(f->c, f->fp, f->len, &mem);
+	if(!f->mmapinfo) return 0;
+
+	// The mapping is read-only. We never write to the rcache after it has
+	// been populated, so this cast is safe.
+	f->rcache = (u8*)mem;
+	f->rcache_bytes_used = f->len;
+	f->file_pos_known = 0;
+	return 1;
+}
+
 // Fill the cache that remembers the first part of the file.
-// TODO: We should probably use memory-mapped files instead when possible,
-// but this is simple and portable, and does most of what we need.
+// If possible, we memory-map the entire file, so that every read is served
+// from the cache. Otherwise, we read the first DE_RCACHE_SIZE bytes.
 static void populate_rcache(dbuf *f)
 {
 	i64 bytes_to_read;
@@ -27,6 +204,11 @@ static void populate_rcache(dbuf *f)
 
 	if(f->btype!=DBUF_TYPE_IFILE) return;
 
+	if(f->len > DE_RCACHE_SIZE) {
+		// (Small files aren't worth mapping.)
+		if(populate_rcache_mmap(f)) return;
+	}
+
 	bytes_to_read = DE_RCACHE_SIZE;
 	if(f->len < bytes_to_read) {
 		bytes_to_read = f->len;
@@ -39,11 +221,44 @@ static void populate_rcache(dbuf *f)
 	f->file_pos_known = 0;
 }
 
-// Read all data from stdin (or a named pipe) into memory.
+// Copy everything we've read so far from a pipe to a new temporary file.
+// Returns the file, or NULL on failure.
+static FILE *start_spilling_pipe_data(dbuf *f)
+{
+	deark *c = f->c;
+	FILE *spill_fp;
+	size_t ret;
+
+	spill_fp = de_fopen_tmpfile(c);
+	if(!spill_fp) {
+		de_warn(c, "Failed to create temporary file. Reading all input into memory.");
+		return NULL;
+	}
+	de_dbg2(c, "input exceeds %"I64_FMT" bytes; using temporary file", f->rcache_bytes_used);
+
+	ret = fwrite(f->rcache, 1, (size_t)f->rcache_bytes_used, spill_fp);
+	if(ret != (size_t)f->rcache_bytes_used) {
+		de_err(c, "Failed to write to temporary file");
+		de_fatalerror(c);
+	}
+	return spill_fp;
+}
+
+// Read all data from stdin (or a named pipe).
+// Up to c->input_mem_limit bytes are kept in memory (the rcache). If there's
+// more than that, the data is also copied to a temporary file, and after that
+// the dbuf can be read in the same way as an ordinary input file (f->fp will
+// be the temporary file).
 static void populate_rcache_from_pipe(dbuf *f)
 {
+	deark *c = f->c;
 	FILE *fp;
+	FILE *spill_fp = NULL;
+	u8 *spillbuf = NULL;
 	i64 cache_bytes_alloc = 0;
+	i64 max_cache_size;
+	i64 total_len = 0;
+#define DE_SPILLBUF_SIZE 65536
 
 	if(f->btype==DBUF_TYPE_STDIN) {
 		fp = stdin;
@@ -55,33 +270,76 @@ static void populate_rcache_from_pipe(dbuf *f)
 		return;
 	}
 
+	max_cache_size = c->input_mem_limit;
+	if(max_cache_size < DE_RCACHE_SIZE) max_cache_size = DE_RCACHE_SIZE;
+
 	f->rcache_bytes_used = 0;
 
 	while(1) {
 		i64 bytes_to_read, bytes_read;
 
-		if(f->rcache_bytes_used >= cache_bytes_alloc) {
+		if(!spill_fp && f->rcache_bytes_used >= cache_bytes_alloc) {
 			i64 old_cache_size, new_cache_size;
 
-			// Cache is full. Increase its size.
-			old_cache_size = cache_bytes_alloc;
-			new_cache_size = old_cache_size*2;
-			if(new_cache_size<DE_RCACHE_SIZE) new_cache_size = DE_RCACHE_SIZE;
-			f->rcache = de_realloc(f->c, f->rcache, old_cache_size, new_cache_size);
-			cache_bytes_alloc = new_cache_size;
+			if(cache_bytes_alloc >= max_cache_size) {
+				// Cache is full, and can't get any larger.
+				spill_fp = start_spilling_pipe_data(f);
+				if(spill_fp) {
+					spillbuf = de_malloc(c, DE_SPILLBUF_SIZE);
+				}
+				else {
+					// Give up on the memory limit.
+					max_cache_size = DE_MAX_MEMBUF_SIZE;
+				}
+			}
+
+			if(!spill_fp) {
+				// Cache is full. Increase its size.
+				old_cache_size = cache_bytes_alloc;
+				new_cache_size = old_cache_size*2;
+				if(new_cache_size<DE_RCACHE_SIZE) new_cache_size = DE_RCACHE_SIZE;
+				if(new_cache_size>max_cache_size) new_cache_size = max_cache_size;
+				f->rcache = de_realloc(c, f->rcache, old_cache_size, new_cache_size);
+				cache_bytes_alloc = new_cache_size;
+			}
 		}
 
-		// Try to read as many bytes as it would take to fill the cache.
-		bytes_to_read = cache_bytes_alloc - f->rcache_bytes_used;
-		if(bytes_to_read<1) break; // Shouldn't happen
+		if(spill_fp) {
+			bytes_to_read = DE_SPILLBUF_SIZE;
+			bytes_read = fread(spillbuf, 1, (size_t)bytes_to_read, fp);
+			if(bytes_read<1 || bytes_read>bytes_to_read) break;
+			if(fwrite(spillbuf, 1, (size_t)bytes_read, spill_fp) != (size_t)bytes_read) {
+				de_err(c, "Failed to write to temporary file");
+				de_fatalerror(c);
+				break;
+			}
+			total_len += bytes_read;
+		}
+		else {
+			// Try to read as many bytes as it would take to fill the cache.
+			bytes_to_read = cache_bytes_alloc - f->rcache_bytes_used;
+			if(bytes_to_read<1) break; // Shouldn't happen
 
-		bytes_read = fread(&f->rcache[f->rcache_bytes_used], 1, (size_t)bytes_to_read, fp);
-		if(bytes_read<1 || bytes_read>bytes_to_read) break;
-		f->rcache_bytes_used += bytes_read;
+			bytes_read = fread(&f->rcache[f->rcache_bytes_used], 1, (size_t)bytes_to_read, fp);
+			if(bytes_read<1 || bytes_read>bytes_to_read) break;
+			f->rcache_bytes_used += bytes_read;
+			total_len = f->rcache_bytes_used;
+		}
 		if(feof(fp) || ferror(fp)) break;
 	}
 
-	f->len = f->rcache_bytes_used;
+	f->len = total_len;
+
+	if(spill_fp) {
+		// From now on, read from the temporary file instead of the pipe.
+		if(f->btype==DBUF_TYPE_FIFO) {
+			de_fclose(f->fp);
+		}
+		f->fp = spill_fp;
+		f->file_pos_known = 0;
+		de_free(c, spillbuf);
+		de_dbg2(c, "total input size: %"I64_FMT, f->len);
+	}
 }
 
 // Use if we read a 'offset' field representing an absolute file position.
@@ -168,21 +426,19 @@ void dbuf_read(dbuf *f, u8 *buf, i64 pos, i64 len)
 
 	switch(f->btype) {
 	case DBUF_TYPE_IFILE:
+	case DBUF_TYPE_STDIN: // (If we get here, the data was spilled to a file.)
+	case DBUF_TYPE_FIFO:
 		if(!f->fp) {
 			de_internal_err_fatal(c, "File not open");
 			goto done_read;
 		}
 
-		// For performance reasons, don't call fseek if we're already at the
-		// right position.
-		if(!f->file_pos_known || f->file_pos!=pos) {
-			de_fseek(f->fp, pos, SEEK_SET);
+		if(f->bcache && bytes_to_read<=DE_BCACHE_MAX_CACHED_READ) {
+			bytes_read = bcache_read(f, buf, pos, bytes_to_read);
+		}
+		else {
+			bytes_read = ifile_read_lowlevel(f, buf, pos, bytes_to_read);
 		}
-
-		bytes_read = fread(buf, 1, (size_t)bytes_to_read, f->fp);
-
-		f->file_pos = pos + bytes_read;
-		f->file_pos_known = 1;
 		break;
 
 	case DBUF_TYPE_IDBUF:
@@ -232,6 +488,15 @@ u8 dbuf_getbyte(dbuf *f, i64 pos)
 
 	if(pos<0 || pos>=f->len) return 0x00;
 
+	if(f->btype==DBUF_TYPE_IDBUF) {
+		// Subfiles are normally flattened (see dbuf_open_input_subfile()),
+		// so this usually takes us straight to the root dbuf, and lets us
+		// use its fast paths.
+		pos += f->offset_into_parent_dbuf;
+		f = f->parent_dbuf;
+		if(pos<0 || pos>=f->len) return 0x00;
+	}
+
 	if(pos<f->rcache_bytes_used) {
 		return f->rcache[pos];
 	}
@@ -728,23 +993,109 @@ static int copy_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
 	return 1;
 }
 
-void dbuf_copy(dbuf *inf, i64 input_offset, i64 input_len, dbuf *outf)
+// Physically write to an output file, bypassing the obuf.
+static void ofile_write_lowlevel(dbuf *f, const u8 *m, i64 len)
 {
-	u8 tmpbuf[256];
+	if(f->c->debug_level>=4) {
+		de_dbgx(f->c, 4, "writing %"I64_FMT" bytes to %s", len, f->name);
+	}
+	fwrite(m, 1, (size_t)len, f->fp);
+	f->c->num_output_write_calls++;
+}
+
+static void obuf_flush(dbuf *f)
+{
+	if(f->obuf_bytes_used<1) return;
+	ofile_write_lowlevel(f, f->obuf, f->obuf_bytes_used);
+	f->obuf_bytes_used = 0;
+}
 
-	// Fast paths, if the data to copy is all in memory
+// Write to a managed output file, through the obuf.
+static void ofile_write(dbuf *f, const u8 *m, i64 len)
+{
+	if(!f->obuf) {
+		ofile_write_lowlevel(f, m, len);
+		return;
+	}
 
-	if(inf->rcache &&
-		(input_offset>=0) && (input_offset+input_len<=inf->rcache_bytes_used))
-	{
-		dbuf_write(outf, &inf->rcache[input_offset], input_len);
+	if(f->obuf_bytes_used + len > f->obuf_alloc) {
+		// If the file is getting large, use a larger buffer.
+		if(f->obuf_alloc < f->c->obuf_max_size && f->len >= f->obuf_alloc) {
+			i64 new_alloc;
+
+			new_alloc = de_min_int(f->obuf_alloc*2, f->c->obuf_max_size);
+			f->obuf = de_realloc(f->c, f->obuf, f->obuf_alloc, new_alloc);
+			f->obuf_alloc = new_alloc;
+		}
+	}
+
+	if(f->obuf_bytes_used + len > f->obuf_alloc) {
+		obuf_flush(f);
+	}
+
+	if(len >= f->obuf_alloc) {
+		// Big writes go straight to the file.
+		ofile_write_lowlevel(f, m, len);
 		return;
 	}
 
-	if(inf->btype==DBUF_TYPE_MEMBUF &&
-		(input_offset>=0) && (input_offset+input_len<=inf->len))
-	{
-		dbuf_write(outf, &inf->membuf_buf[input_offset], input_len);
+	de_memcpy(&f->obuf[f->obuf_bytes_used], m, (size_t)len);
+	f->obuf_bytes_used += len;
+}
+
+// Copy as much as possible of the given data from inf to outf directly,
+// inside the operating system, if they are both ordinary files.
+// Returns the number of bytes copied.
+static i64 dbuf_copy_zerocopy(dbuf *inf, i64 input_offset, i64 input_len, dbuf *outf)
+{
+	deark *c = outf->c;
+	i64 nbytes_copied;
+
+	if(c->disable_zerocopy) return 0;
+	if(input_len < DE_ZEROCOPY_MIN_SIZE) return 0;
+	if(outf->btype!=DBUF_TYPE_OFILE || !outf->is_managed || !outf->fp) return 0;
+	// Listeners need to see the data.
+	if(outf->writelistener_cb || outf->digests_for_oinfo) return 0;
+	if(outf->len + outf->wbuffer_bytes_used + input_len > outf->max_len_hard) return 0;
+
+	while(1) {
+		if(input_offset<0 || input_offset+input_len > inf->len) return 0;
+		if(inf->btype!=DBUF_TYPE_IDBUF) break;
+		input_offset += inf->offset_into_parent_dbuf;
+		inf = inf->parent_dbuf;
+	}
+	if(inf->btype!=DBUF_TYPE_IFILE || !inf->fp) return 0;
+
+	dbuf_flush(outf);
+	obuf_flush(outf);
+	fflush(outf->fp);
+
+	nbytes_copied = de_copy_file_data(c, inf->fp, input_offset, outf->fp, input_len);
+	if(nbytes_copied<1) return 0;
+	c->num_output_write_calls++;
+	if(c->debug_level>=4) {
+		de_dbgx(c, 4, "copied %"I64_FMT" bytes to %s directly", nbytes_copied, outf->name);
+	}
+	outf->len += nbytes_copied;
+	return nbytes_copied;
+}
+
+void dbuf_copy(dbuf *inf, i64 input_offset, i64 input_len, dbuf *outf)
+{
+	u8 tmpbuf[256];
+	const u8 *mem;
+	i64 n;
+
+	n = dbuf_copy_zerocopy(inf, input_offset, input_len, outf);
+	if(n>0) {
+		if(n>=input_len) return;
+		input_offset += n;
+		input_len -= n;
+	}
+
+	// Fast path, if the data to copy is all in memory
+	if(dbuf_get_span_direct(inf, input_offset, input_len, &mem)) {
+		dbuf_write(outf, mem, input_len);
 		return;
 	}
 
@@ -996,13 +1347,11 @@ static int dbufmemcmp_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
 int dbuf_memcmp(dbuf *f, i64 pos, const void *s, size_t n)
 {
 	u8 buf1[128];
+	const u8 *mem;
 
-	if(f->rcache &&
-		pos >= 0 &&
-		pos + (i64)n <= f->rcache_bytes_used)
-	{
-		// Fastest path: Compare directly to cache.
-		return de_memcmp(s, &f->rcache[pos], n);
+	if(dbuf_get_span_direct(f, pos, (i64)n, &mem)) {
+		// Fastest path: Compare directly to memory.
+		return de_memcmp(s, mem, n);
 	}
 
 	if(n<=sizeof(buf1)) {
@@ -1144,6 +1493,15 @@ void dbuf_disable_wbuffer(dbuf *f)
 	f->wbuffer = NULL;
 }
 
+// Returns nonzero if an obuf was created.
+static int obuf_create(dbuf *f)
+{
+	if(f->c->obuf_max_size<=0) return 0;
+	f->obuf_alloc = de_min_int(DE_OBUF_INITIAL_SIZE, f->c->obuf_max_size);
+	f->obuf = de_malloc(f->c, f->obuf_alloc);
+	return 1;
+}
+
 dbuf *dbuf_create_output_file(deark *c, const char *ext1, de_finfo *fi,
 	unsigned int createflags)
 {
@@ -1320,7 +1678,7 @@ dbuf *dbuf_create_output_file(deark *c, const char *ext1, de_finfo *fi,
 	}
 
 	if(c->enable_oinfo) {
-		f->crco_for_oinfo = de_crcobj_create(c, DE_CRCOBJ_CRC32_IEEE);
+		f->digests_for_oinfo = de_digestset_create(c, c->oinfo_digests);
 	}
 
 	if(c->list_mode) {
@@ -1364,6 +1722,7 @@ dbuf *dbuf_create_output_file(deark *c, const char *ext1, de_finfo *fi,
 		f->btype = DBUF_TYPE_STDOUT;
 		// TODO: Should we increase f->max_len_hard?
 		f->fp = stdout;
+		obuf_create(f);
 	}
 	else {
 		de_info(c, "Writing %s", f->name);
@@ -1376,6 +1735,11 @@ dbuf *dbuf_create_output_file(deark *c, const char *ext1, de_finfo *fi,
 			f->btype = DBUF_TYPE_NULL;
 			c->serious_error_flag = 1;
 		}
+		else if(obuf_create(f)) {
+			// We do our own buffering, so stdio's buffer would just mean
+			// an extra copy.
+			setvbuf(f->fp, NULL, _IONBF, 0);
+		}
 	}
 
 done:
@@ -1454,8 +1818,8 @@ static void dbuf_write_unbuffered(dbuf *f, const u8 *m, i64 len)
 		do_on_dbuf_size_exceeded(f);
 	}
 
-	if(f->crco_for_oinfo) {
-		de_crcobj_addbuf(f->crco_for_oinfo, m, len);
+	if(f->digests_for_oinfo) {
+		de_digestset_addbuf(f->digests_for_oinfo, m, len);
 	}
 	if(f->writelistener_cb) {
 		f->writelistener_cb(f, f->userdata_for_writelistener, m, len);
@@ -1465,10 +1829,7 @@ static void dbuf_write_unbuffered(dbuf *f, const u8 *m, i64 len)
 	case DBUF_TYPE_OFILE:
 	case DBUF_TYPE_STDOUT:
 		if(!f->fp) return;
-		if(f->c->debug_level>=4) {
-			de_dbgx(f->c, 4, "writing %"I64_FMT" bytes to %s", len, f->name);
-		}
-		fwrite(m, 1, (size_t)len, f->fp);
+		ofile_write(f, m, len);
 		f->len += len;
 		return;
 	case DBUF_TYPE_MEMBUF:
@@ -1790,8 +2151,12 @@ void dbuf_flush_lowlevel(dbuf *f)
 {
 	dbuf_flush(f);
 	if(f->btype==DBUF_TYPE_OFILE) {
+		obuf_flush(f);
 		fflush(f->fp);
 	}
+	else if(f->btype==DBUF_TYPE_STDOUT) {
+		obuf_flush(f);
+	}
 }
 
 dbuf *dbuf_open_input_file(deark *c, const char *fn)
@@ -1828,6 +2193,10 @@ dbuf *dbuf_open_input_file(deark *c, const char *fn)
 		populate_rcache(f);
 	}
 
+	if(!f->mmapinfo) {
+		bcache_create(f);
+	}
+
 	return f;
 }
 
@@ -1842,10 +2211,12 @@ dbuf *dbuf_open_input_stdin(deark *c)
 	f->rcache_policy = DE_RCACHE_POLICY_NONE;
 
 	populate_rcache_from_pipe(f);
+	bcache_create(f);
 
 	return f;
 }
 
+// Note: The parent dbuf must not be closed before the subfile is.
 dbuf *dbuf_open_input_subfile(dbuf *parent, i64 offset, i64 size)
 {
 	dbuf *f;
@@ -1857,6 +2228,19 @@ dbuf *dbuf_open_input_subfile(dbuf *parent, i64 offset, i64 size)
 	f->parent_dbuf = parent;
 	f->offset_into_parent_dbuf = offset;
 	f->len = size;
+
+	// If the parent is itself a subfile, and we are entirely within it, refer
+	// directly to the parent's parent instead. That way, reading from deeply
+	// nested subfiles costs no more than reading from a top-level one.
+	// (If we're not entirely within the parent, we can't do this, because
+	// the out-of-range bytes have to read as 0.)
+	while(f->parent_dbuf->btype==DBUF_TYPE_IDBUF &&
+		f->offset_into_parent_dbuf>=0 &&
+		f->offset_into_parent_dbuf+f->len <= f->parent_dbuf->len)
+	{
+		f->offset_into_parent_dbuf += f->parent_dbuf->offset_into_parent_dbuf;
+		f->parent_dbuf = f->parent_dbuf->parent_dbuf;
+	}
 	return f;
 }
 
@@ -1887,6 +2271,37 @@ void de_writelistener_for_crc(dbuf *f, void *userdata, const u8 *buf, i64 buf_le
 	de_crcobj_addbuf(crco, buf, buf_len);
 }
 
+// Prints the "-opt oinfo" line. CRC-32 always comes first, in the original
+// format, followed by any other requested digests.
+static void print_oinfo(dbuf *f)
+{
+	deark *c = f->c;
+	char crcbuf[16];
+	char extra[256];
+	size_t extra_len = 0;
+	UI which;
+
+	de_strlcpy(crcbuf, "00000000", sizeof(crcbuf));
+	extra[0] = '\0';
+	if(f->digests_for_oinfo) {
+		de_digestset_get_string(f->digests_for_oinfo, DE_DIGEST_CRC32, crcbuf,
+			sizeof(crcbuf));
+
+		for(which=DE_DIGEST_CRC16ARC; which<=DE_DIGEST_SHA256; which<<=1) {
+			char digeststr[80];
+
+			if(!(c->oinfo_digests & which)) continue;
+			de_digestset_get_string(f->digests_for_oinfo, which, digeststr, sizeof(digeststr));
+			de_snprintf(&extra[extra_len], sizeof(extra)-extra_len, " %s=%s",
+				de_digest_get_name(which), digeststr);
+			extra_len = de_strlen(extra);
+		}
+	}
+
+	de_msg(c, "Output file info: ID=%d CRC=%s size=%"I64_FMT"%s", f->file_id,
+		crcbuf, f->len, extra);
+}
+
 void dbuf_close(dbuf *f)
 {
 	deark *c;
@@ -1894,15 +2309,10 @@ void dbuf_close(dbuf *f)
 	c = f->c;
 
 	if(f->wbuffer_bytes_used!=0) dbuf_flush(f);
+	if(f->obuf_bytes_used!=0) obuf_flush(f);
 
 	if(c->enable_oinfo && f->is_managed) {
-		u32 crc = 0;
-
-		if(f->crco_for_oinfo) {
-			crc = de_crcobj_getval(f->crco_for_oinfo);
-		}
-		de_msg(c, "Output file info: ID=%d CRC=%08x size=%"I64_FMT, f->file_id,
-			crc, f->len);
+		print_oinfo(f);
 	}
 
 	if(f->btype==DBUF_TYPE_OFILE || f->btype==DBUF_TYPE_STDOUT) {
@@ -1936,6 +2346,13 @@ void dbuf_close(dbuf *f)
 		de_fclose(f->fp);
 		f->fp = NULL;
 		break;
+	case DBUF_TYPE_STDIN:
+		// f->fp is not stdin. It's a temporary file, if anything.
+		if(f->fp) {
+			de_fclose(f->fp);
+			f->fp = NULL;
+		}
+		break;
 	case DBUF_TYPE_STDOUT:
 		if(f->name && f->is_managed) {
 			de_dbg3(c, "finished writing %s to stdout", f->name);
@@ -1948,7 +2365,6 @@ void dbuf_close(dbuf *f)
 	case DBUF_TYPE_MEMBUF:
 	case DBUF_TYPE_IDBUF:
 	case DBUF_TYPE_ODBUF:
-	case DBUF_TYPE_STDIN:
 	case DBUF_TYPE_CUSTOM:
 	case DBUF_TYPE_NULL:
 		break;
@@ -1956,11 +2372,18 @@ void dbuf_close(dbuf *f)
 		de_internal_err_nonfatal(c, "Don't know how to close this type of file (%d)", f->btype);
 	}
 
+	bcache_destroy(f);
 	de_free(c, f->membuf_buf);
 	de_free(c, f->name);
+	if(f->mmapinfo) {
+		de_munmap_file(c, f->mmapinfo);
+		f->mmapinfo = NULL;
+		f->rcache = NULL;
+	}
 	de_free(c, f->rcache);
 	de_free(c, f->wbuffer);
-	if(f->crco_for_oinfo) de_crcobj_destroy(f->crco_for_oinfo);
+	de_free(c, f->obuf);
+	de_digestset_destroy(f->digests_for_oinfo);
 	if(f->fi_copy) de_finfo_destroy(c, f->fi_copy);
 	de_free(c, f);
 
@@ -1991,28 +2414,128 @@ const u8 *dbuf_get_membuf_direct_ptr(dbuf *f)
 	return f->membuf_buf;
 }
 
+// If the bytes pos through pos+len-1 of f are all resident in memory (e.g. in
+// the rcache, a memory-mapped file, or a membuf, possibly through one or more
+// layers of subfile dbufs), sets *pptr to point to them, and returns 1.
+// Otherwise returns 0, and sets *pptr to NULL.
+// The memory is owned by the dbuf, is read-only, and remains valid until the
+// dbuf (or any dbuf it is a subfile of) is written to or closed.
+int dbuf_get_span_direct(dbuf *f, i64 pos, i64 len, const u8 **pptr)
+{
+	*pptr = NULL;
+
+	while(1) {
+		if(len<1 || pos<0 || pos+len > f->len) return 0;
+
+		if(f->rcache && pos+len <= f->rcache_bytes_used) {
+			*pptr = &f->rcache[pos];
+			return 1;
+		}
+		if(f->btype==DBUF_TYPE_MEMBUF) {
+			*pptr = &f->membuf_buf[pos];
+			return 1;
+		}
+		if(f->btype!=DBUF_TYPE_IDBUF) break;
+
+		pos += f->offset_into_parent_dbuf;
+		f = f->parent_dbuf;
+	}
+	return 0;
+}
+
+// Returns a pointer to a read-only copy of the len bytes at pos.
+// If possible, this points directly to the dbuf's memory (see
+// dbuf_get_span_direct()). Otherwise, the bytes are read into tmpbuf, which
+// must have room for at least len bytes, and tmpbuf is returned.
+// As with dbuf_read(), bytes that are out of range are read as 0.
+const u8 *dbuf_get_span(dbuf *f, i64 pos, i64 len, u8 *tmpbuf)
+{
+	const u8 *ptr;
+
+	if(dbuf_get_span_direct(f, pos, len, &ptr)) {
+		return ptr;
+	}
+	dbuf_read(f, tmpbuf, pos, len);
+	return tmpbuf;
+}
+
+struct search_byte_ctx {
+	u8 b;
+	int foundflag;
+	i64 foundpos_rel;
+};
+
+static int search_byte_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
+	i64 buf_len)
+{
+	struct search_byte_ctx *sbctx = (struct search_byte_ctx*)brctx->userdata;
+	const u8 *p;
+
+	p = memchr(buf, (int)sbctx->b, (size_t)buf_len);
+	if(p) {
+		sbctx->foundpos_rel = brctx->offset + (i64)(p-buf);
+		sbctx->foundflag = 1;
+		return 0;
+	}
+	return 1;
+}
+
 // Search a section of a dbuf for a given byte.
 // 'haystack_len' is the number of bytes to search.
 // Returns 0 if not found.
 // If found, sets *foundpos to the position in the file where it was found
 // (not relative to startpos).
+// As with dbuf_getbyte(), bytes outside the file are considered to be 0x00.
 int dbuf_search_byte(dbuf *f, const u8 b, i64 startpos,
 	i64 haystack_len, i64 *foundpos)
 {
-	i64 i;
+	struct search_byte_ctx sbctx;
+	i64 endpos;
+
+	if(haystack_len<1) return 0;
+	endpos = startpos + haystack_len;
 
-	for(i=0; i<haystack_len; i++) {
-		if(b == dbuf_getbyte(f, startpos+i)) {
-			*foundpos = startpos+i;
+	if(startpos<0) {
+		if(b==0x00) {
+			*foundpos = startpos;
 			return 1;
 		}
+		startpos = 0;
+	}
+
+	if(startpos < f->len) {
+		de_zeromem(&sbctx, sizeof(struct search_byte_ctx));
+		sbctx.b = b;
+		(void)dbuf_buffered_read(f, startpos, de_min_int(endpos, f->len)-startpos,
+			search_byte_cbfn, (void*)&sbctx);
+		if(sbctx.foundflag) {
+			*foundpos = startpos + sbctx.foundpos_rel;
+			return 1;
+		}
+	}
+
+	if(b==0x00 && endpos > f->len) {
+		*foundpos = de_max_int(startpos, f->len);
+		return 1;
 	}
 	return 0;
 }
 
+// A rough guess at how common byte value b is in typical files.
+// Higher is more common.
+static int byte_commonness(u8 b)
+{
+	if(b==0x00) return 5;
+	if(b==0xff) return 4;
+	if(b<0x20 || b==' ' || (b>='0' && b<='9') || (b>='a' && b<='z')) return 3;
+	if(b<0x7f) return 1;
+	return 0;
+}
+
 struct search_ctx {
 	const u8 *needle;
 	i64 needle_len;
+	i64 rare_idx; // Index into needle of the byte we look for first
 	int foundflag;
 	i64 foundpos_rel;
 };
@@ -2023,18 +2546,28 @@ static int search_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
 	struct search_ctx *sctx = (struct search_ctx*)brctx->userdata;
 	i64 i;
 	i64 num_starting_positions_to_check;
+	u8 rare_byte;
 
 	if(buf_len < sctx->needle_len) return 0;
 	num_starting_positions_to_check = buf_len + 1 - sctx->needle_len;
+	rare_byte = sctx->needle[sctx->rare_idx];
 
-	for(i=0; i<num_starting_positions_to_check; i++) {
-		if(sctx->needle[0]==buf[i] &&
-			!de_memcmp(sctx->needle, &buf[i], (size_t)sctx->needle_len))
-		{
+	i = 0;
+	while(i<num_starting_positions_to_check) {
+		const u8 *p;
+
+		// Find the next candidate position, then check the whole needle.
+		p = memchr(&buf[i+sctx->rare_idx], (int)rare_byte,
+			(size_t)(num_starting_positions_to_check-i));
+		if(!p) break;
+		i = (i64)(p-buf) - sctx->rare_idx;
+
+		if(!de_memcmp(sctx->needle, &buf[i], (size_t)sctx->needle_len)) {
 			sctx->foundpos_rel = brctx->offset+i;
 			sctx->foundflag = 1;
 			return 0;
 		}
+		i++;
 	}
 
 	if(brctx->eof_flag) return 0;
@@ -2044,7 +2577,6 @@ static int search_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
 
 // Search a section of a dbuf for a given byte sequence.
 //
-// This function is inefficient, but it's good enough for Deark's needs.
 // Maximum 'needle_len' is DE_BUFFERED_READ_MIN_BLKSIZE bytes, but it's expected to
 // be quite short. If it gets close to the maximum, the search could get very
 // inefficient.
@@ -2054,11 +2586,13 @@ static int search_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
 // Returns 0 if not found.
 // If found, sets *foundpos to the position in the file where it was found
 // (not relative to startpos).
+// To search for several byte sequences at once, see dbuf_multisearch().
 int dbuf_search(dbuf *f, const u8 *needle, i64 needle_len,
 	i64 startpos, i64 haystack_len, i64 *foundpos)
 {
 	int retval = 0;
 	struct search_ctx sctx;
+	i64 i;
 
 	*foundpos = 0;
 
@@ -2090,6 +2624,11 @@ int dbuf_search(dbuf *f, const u8 *needle, i64 needle_len,
 	de_zeromem(&sctx, sizeof(struct search_ctx));
 	sctx.needle = needle;
 	sctx.needle_len = needle_len;
+	for(i=1; i<needle_len; i++) {
+		if(byte_commonness(needle[i]) < byte_commonness(needle[sctx.rare_idx])) {
+			sctx.rare_idx = i;
+		}
+	}
 	(void)dbuf_buffered_read(f, startpos, haystack_len, search_cbfn, (void*)&sctx);
 	if(sctx.foundflag) {
 		*foundpos = startpos + sctx.foundpos_rel;
@@ -2100,6 +2639,266 @@ done:
 	return retval;
 }
 
+// Multi-needle search, using the Aho-Corasick algorithm.
+// Usage: de_multisearch_create(), de_multisearch_add_needle() (any number of
+// times), dbuf_multisearch() (any number of times), de_multisearch_destroy().
+
+struct de_multisearch_needle {
+	u8 *bytes;
+	i64 len;
+	UI id;
+	i32 next_same_state; // Next needle that ends at the same state, or -1
+};
+
+struct de_multisearch {
+	i64 num_needles;
+	i64 needles_alloc;
+	struct de_multisearch_needle *needles;
+
+	// The automaton. Built when first needed.
+	u8 is_built;
+	i64 num_states;
+	i32 *trans; // [num_states*256] The full state transition table
+	i32 *first_needle; // [num_states] First needle that ends here, or -1
+	i32 *dict_link; // [num_states] Next state (by suffix) with a needle, or -1
+	u8 root_has_trans[256]; // Does byte b take us out of the root state?
+};
+
+struct de_multisearch *de_multisearch_create(deark *c)
+{
+	return de_malloc(c, sizeof(struct de_multisearch));
+}
+
+// 'id' is an arbitrary number that will be passed to the callback function.
+// Needles may not be added after the first search.
+void de_multisearch_add_needle(deark *c, struct de_multisearch *ms,
+	const u8 *needle, i64 needle_len, UI id)
+{
+	struct de_multisearch_needle *nd;
+
+	if(ms->is_built) {
+		de_internal_err_nonfatal(c, "Search already started");
+		return;
+	}
+	if(needle_len<1) return;
+
+	if(ms->num_needles >= ms->needles_alloc) {
+		i64 new_alloc;
+
+		new_alloc = ms->needles_alloc ? ms->needles_alloc*2 : 8;
+		ms->needles = de_reallocarray(c, ms->needles, ms->needles_alloc,
+			sizeof(struct de_multisearch_needle), new_alloc);
+		ms->needles_alloc = new_alloc;
+	}
+
+	nd = &ms->needles[ms->num_needles++];
+	nd->bytes = de_malloc(c, needle_len);
+	de_memcpy(nd->bytes, needle, (size_t)needle_len);
+	nd->len = needle_len;
+	nd->id = id;
+	nd->next_same_state = -1;
+}
+
+static void multisearch_build(deark *c, struct de_multisearch *ms)
+{
+	i64 max_states;
+	i64 k;
+	i32 *fail = NULL;
+	i32 *queue = NULL;
+	i64 q_head, q_tail;
+	UI b;
+
+	ms->is_built = 1;
+
+	max_states = 1;
+	for(k=0; k<ms->num_needles; k++) {
+		max_states += ms->needles[k].len;
+	}
+
+	ms->trans = de_mallocarray(c, max_states*256, sizeof(i32));
+	ms->first_needle = de_mallocarray(c, max_states, sizeof(i32));
+	ms->dict_link = de_mallocarray(c, max_states, sizeof(i32));
+	fail = de_mallocarray(c, max_states, sizeof(i32));
+	queue = de_mallocarray(c, max_states, sizeof(i32));
+
+	for(k=0; k<max_states*256; k++) {
+		ms->trans[k] = -1;
+	}
+	for(k=0; k<max_states; k++) {
+		ms->first_needle[k] = -1;
+		ms->dict_link[k] = -1;
+	}
+	ms->num_states = 1;
+
+	// Make the trie
+	for(k=0; k<ms->num_needles; k++) {
+		struct de_multisearch_needle *nd = &ms->needles[k];
+		i32 s = 0;
+		i64 i;
+
+		for(i=0; i<nd->len; i++) {
+			i32 *t = &ms->trans[s*256 + nd->bytes[i]];
+
+			if(*t<0) {
+				*t = (i32)ms->num_states++;
+			}
+			s = *t;
+		}
+		nd->next_same_state = ms->first_needle[s];
+		ms->first_needle[s] = (i32)k;
+	}
+
+	// Breadth-first traversal, to set the failure links, and to turn the trie
+	// into a complete transition table.
+	q_head = 0;
+	q_tail = 0;
+	for(b=0; b<256; b++) {
+		i32 t = ms->trans[b];
+
+		if(t<0) {
+			ms->trans[b] = 0;
+		}
+		else {
+			ms->root_has_trans[b] = 1;
+			fail[t] = 0;
+			queue[q_tail++] = t;
+		}
+	}
+
+	while(q_head < q_tail) {
+		i32 s = queue[q_head++];
+
+		for(b=0; b<256; b++) {
+			i32 *t = &ms->trans[s*256 + b];
+
+			if(*t<0) {
+				*t = ms->trans[fail[s]*256 + b];
+			}
+			else {
+				i32 f = ms->trans[fail[s]*256 + b];
+
+				fail[*t] = f;
+				ms->dict_link[*t] = (ms->first_needle[f]>=0) ? f : ms->dict_link[f];
+				queue[q_tail++] = *t;
+			}
+		}
+	}
+
+	de_free(c, fail);
+	de_free(c, queue);
+}
+
+struct multisearch_ctx {
+	struct de_multisearch *ms;
+	de_multisearch_cbfn cbfn;
+	void *userdata;
+	i64 startpos;
+	i32 state;
+	u8 stop_flag;
+};
+
+// Returns 0 if the caller wants to stop.
+static int multisearch_report(deark *c, struct multisearch_ctx *msctx, i32 s,
+	i64 endpos)
+{
+	struct de_multisearch *ms = msctx->ms;
+
+	if(ms->first_needle[s]<0) {
+		s = ms->dict_link[s];
+	}
+	while(s>=0) {
+		i32 n;
+
+		for(n=ms->first_needle[s]; n>=0; n=ms->needles[n].next_same_state) {
+			if(!msctx->cbfn(c, msctx->userdata, ms->needles[n].id,
+				endpos - ms->needles[n].len))
+			{
+				return 0;
+			}
+		}
+		s = ms->dict_link[s];
+	}
+	return 1;
+}
+
+static int multisearch_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
+	i64 buf_len)
+{
+	struct multisearch_ctx *msctx = (struct multisearch_ctx*)brctx->userdata;
+	struct de_multisearch *ms = msctx->ms;
+	i32 s = msctx->state;
+	i64 i = 0;
+
+	while(i<buf_len) {
+		if(s==0) {
+			// Skip quickly past bytes that can't start a needle.
+			while(i<buf_len && !ms->root_has_trans[buf[i]]) i++;
+			if(i>=buf_len) break;
+		}
+
+		s = ms->trans[s*256 + buf[i]];
+		i++;
+		if(ms->first_needle[s]>=0 || ms->dict_link[s]>=0) {
+			if(!multisearch_report(brctx->c, msctx, s,
+				msctx->startpos + brctx->offset + i))
+			{
+				msctx->stop_flag = 1;
+				return 0;
+			}
+		}
+	}
+
+	msctx->state = s;
+	return 1;
+}
+
+// Search a section of a dbuf for all occurrences of all the needles in ms.
+// For each match, cbfn is called with the needle's id, and the position in
+// the file where the match starts. Matches are reported in order of where
+// they end. cbfn should return 0 to stop the search.
+// Returns 0 if the search was stopped by the callback.
+int dbuf_multisearch(dbuf *f, struct de_multisearch *ms, i64 startpos,
+	i64 haystack_len, de_multisearch_cbfn cbfn, void *userdata)
+{
+	struct multisearch_ctx msctx;
+
+	if(!ms->is_built) {
+		multisearch_build(f->c, ms);
+	}
+	if(startpos<0) {
+		haystack_len += startpos;
+		startpos = 0;
+	}
+	if(haystack_len > f->len - startpos) {
+		haystack_len = f->len - startpos;
+	}
+	if(haystack_len<1 || ms->num_needles<1) return 1;
+
+	de_zeromem(&msctx, sizeof(struct multisearch_ctx));
+	msctx.ms = ms;
+	msctx.cbfn = cbfn;
+	msctx.userdata = userdata;
+	msctx.startpos = startpos;
+	(void)dbuf_buffered_read(f, startpos, haystack_len, multisearch_cbfn,
+		(void*)&msctx);
+	return msctx.stop_flag ? 0 : 1;
+}
+
+void de_multisearch_destroy(deark *c, struct de_multisearch *ms)
+{
+	i64 k;
+
+	if(!ms) return;
+	for(k=0; k<ms->num_needles; k++) {
+		de_free(c, ms->needles[k].bytes);
+	}
+	de_free(c, ms->needles);
+	de_free(c, ms->trans);
+	de_free(c, ms->first_needle);
+	de_free(c, ms->dict_link);
+	de_free(c, ms);
+}
+
 // Search for the aligned pair of 0x00 bytes that marks the end of a UTF-16 string.
 // Endianness doesn't matter, because we're only looking for 0x00 0x00.
 // The returned 'bytes_consumed' is in bytes, and includes the 2 bytes for the NUL
@@ -2389,6 +3188,7 @@ int dbuf_buffered_read(dbuf *f, i64 pos1, i64 len,
 	de_buffered_read_cbfn cbfn, void *userdata)
 {
 	struct de_bufferedreadctx brctx;
+	const u8 *mem;
 
 	brctx.c = f->c;
 	brctx.userdata = userdata;
@@ -2405,14 +3205,12 @@ int dbuf_buffered_read(dbuf *f, i64 pos1, i64 len,
 		return buffered_read_zero_len(&brctx, cbfn);
 	}
 
-	// Use an optimized routine if all the data we need to read is already in memory.
-	if(f->rcache && (pos1>=0) && (pos1+len<=f->rcache_bytes_used)) {
-		return buffered_read_from_mem(&brctx, f, f->rcache, pos1, len, cbfn);
-	}
-
-	// Not an "optimization", since we promise this behavior for MEMBUFs.
-	if(f->btype==DBUF_TYPE_MEMBUF && (pos1>=0) && (pos1+len<=f->len)) {
-		return buffered_read_from_mem(&brctx, f, f->membuf_buf, pos1, len, cbfn);
+	// Use an optimized routine if all the data we need to read is already in
+	// memory (this includes subfiles of such dbufs).
+	// This is not just an "optimization", since we promise this behavior for
+	// MEMBUFs.
+	if(dbuf_get_span_direct(f, pos1, len, &mem)) {
+		return buffered_read_from_mem(&brctx, f, mem, 0, len, cbfn);
 	}
 
 	// The general case:
@@ -2636,23 +3434,31 @@ void de_bitbuf_lowlevel_add_byte(struct de_bitbuf_lowlevel *bbll, u8 n)
 	bbll->nbits_in_bitbuf += 8;
 }
 
-u64 de_bitbuf_lowlevel_get_bits(struct de_bitbuf_lowlevel *bbll, UI nbits)
+// Caller must make sure there are at least nbits bits in the buffer.
+static u64 bitbuf_get_bits_msb(struct de_bitbuf_lowlevel *bbll, UI nbits)
+{
+	bbll->nbits_in_bitbuf -= nbits;
+	return (bbll->bit_buf >> bbll->nbits_in_bitbuf) & (((u64)1 << nbits)-1);
+}
+
+// Caller must make sure there are at least nbits bits in the buffer.
+static u64 bitbuf_get_bits_lsb(struct de_bitbuf_lowlevel *bbll, UI nbits)
 {
 	u64 n;
-	u64 mask;
 
+	n = bbll->bit_buf & (((u64)1 << nbits)-1);
+	bbll->bit_buf >>= nbits;
+	bbll->nbits_in_bitbuf -= nbits;
+	return n;
+}
+
+u64 de_bitbuf_lowlevel_get_bits(struct de_bitbuf_lowlevel *bbll, UI nbits)
+{
 	if(nbits > bbll->nbits_in_bitbuf) return 0;
-	mask = ((u64)1 << nbits)-1;
 	if(bbll->is_lsb==0) {
-		bbll->nbits_in_bitbuf -= nbits;
-		n = (bbll->bit_buf >> bbll->nbits_in_bitbuf) & mask;
-	}
-	else {
-		n = bbll->bit_buf & mask;
-		bbll->bit_buf >>= nbits;
-		bbll->nbits_in_bitbuf -= nbits;
+		return bitbuf_get_bits_msb(bbll, nbits);
 	}
-	return n;
+	return bitbuf_get_bits_lsb(bbll, nbits);
 }
 
 void de_bitbuf_lowlevel_empty(struct de_bitbuf_lowlevel *bbll)
@@ -2661,6 +3467,70 @@ void de_bitbuf_lowlevel_empty(struct de_bitbuf_lowlevel *bbll)
 	bbll->nbits_in_bitbuf = 0;
 }
 
+// Add the smallest number of whole bytes to the bitbuf that will make it
+// contain at least nbits bits, if the bytes are resident in memory and not
+// too close to the end of the data. They are read all at once, with no
+// per-byte bounds checking.
+// Returns 0 (and does nothing) if that's not possible.
+static int bitreader_refill_fast(struct de_bitreader *bitrd, UI nbits)
+{
+	struct de_bitbuf_lowlevel *bbll = &bitrd->bbll;
+	UI nbytes;
+	UI nbytes_bits;
+	const u8 *mem;
+	u64 w;
+
+	if(bitrd->curpos+8 > bitrd->endpos) return 0;
+	if(!dbuf_get_span_direct(bitrd->f, bitrd->curpos, 8, &mem)) return 0;
+
+	nbytes = (nbits - bbll->nbits_in_bitbuf + 7)/8;
+	nbytes_bits = nbytes*8;
+
+	// Load a whole word, and use the part we need.
+	if(bbll->is_lsb==0) {
+		w = de_getu64be_direct(mem);
+		if(nbytes_bits<64) {
+			bbll->bit_buf = (bbll->bit_buf << nbytes_bits) | (w >> (64-nbytes_bits));
+		}
+		else {
+			bbll->bit_buf = w;
+		}
+	}
+	else {
+		w = de_getu64le_direct(mem);
+		if(nbytes_bits<64) {
+			w &= ((u64)1 << nbytes_bits)-1;
+		}
+		bbll->bit_buf |= w << bbll->nbits_in_bitbuf;
+	}
+	bbll->nbits_in_bitbuf += nbytes_bits;
+	bitrd->curpos += (i64)nbytes;
+	return 1;
+}
+
+// Add the smallest number of whole bytes to the bitbuf that will make it
+// contain at least nbits bits. (Reading no more bytes than needed is
+// important, because callers may use ->curpos directly.)
+// Sets eof_flag on failure.
+static void bitreader_refill(struct de_bitreader *bitrd, UI nbits)
+{
+	struct de_bitbuf_lowlevel *bbll = &bitrd->bbll;
+
+	if(bitreader_refill_fast(bitrd, nbits)) return;
+
+	// Near the end of the data, or it's not in memory. Read one byte at a time.
+	while(bbll->nbits_in_bitbuf < nbits) {
+		u8 b;
+
+		if(bitrd->curpos >= bitrd->endpos) {
+			bitrd->eof_flag = 1;
+			return;
+		}
+		b = dbuf_getbyte_p(bitrd->f, &bitrd->curpos);
+		de_bitbuf_lowlevel_add_byte(bbll, b);
+	}
+}
+
 u64 de_bitreader_getbits(struct de_bitreader *bitrd, UI nbits)
 {
 	if(bitrd->eof_flag) return 0;
@@ -2674,18 +3544,75 @@ u64 de_bitreader_getbits(struct de_bitreader *bitrd, UI nbits)
 		return 0;
 	}
 
-	while(bitrd->bbll.nbits_in_bitbuf < nbits) {
-		u8 b;
+	if(bitrd->bbll.nbits_in_bitbuf < nbits) {
+		bitreader_refill(bitrd, nbits);
+		if(bitrd->eof_flag) return 0;
+	}
 
-		if(bitrd->curpos >= bitrd->endpos) {
-			bitrd->eof_flag = 1;
-			return 0;
-		}
-		b = dbuf_getbyte_p(bitrd->f, &bitrd->curpos);
-		de_bitbuf_lowlevel_add_byte(&bitrd->bbll, b);
+	if(bitrd->bbll.is_lsb==0) {
+		return bitbuf_get_bits_msb(&bitrd->bbll, nbits);
+	}
+	return bitbuf_get_bits_lsb(&bitrd->bbll, nbits);
+}
+
+// Look at the next nbits bits, without consuming them, if that can be done
+// cheaply. This may load more bytes than will eventually be needed, so it
+// must be followed by de_bitreader_skip_peeked_bits(), which corrects for that.
+// Returns 0 if not possible (e.g. near the end of the data), in which case
+// nothing is changed, and the caller should use de_bitreader_getbits().
+// On success, the first bit is the most significant bit of *pval if the
+// bitreader is MSB-first, or the least significant bit if it's LSB-first.
+int de_bitreader_peekbits(struct de_bitreader *bitrd, UI nbits, u64 *pval)
+{
+	struct de_bitbuf_lowlevel *bbll = &bitrd->bbll;
+
+	if(bitrd->eof_flag || nbits<1 || nbits>57) return 0;
+	if(bbll->nbits_in_bitbuf < nbits) {
+		if(!bitreader_refill_fast(bitrd, nbits)) return 0;
+	}
+
+	if(bbll->is_lsb==0) {
+		*pval = (bbll->bit_buf >> (bbll->nbits_in_bitbuf-nbits)) & (((u64)1 << nbits)-1);
+	}
+	else {
+		*pval = bbll->bit_buf & (((u64)1 << nbits)-1);
 	}
+	return 1;
+}
 
-	return de_bitbuf_lowlevel_get_bits(&bitrd->bbll, nbits);
+// Consume nbits bits that were seen by de_bitreader_peekbits(), and un-read
+// any whole bytes that it loaded unnecessarily, so that the state is the
+// same as if de_bitreader_getbits(bitrd, nbits) had been called.
+// orig_nbits_in_bitbuf = the value of bitrd->bbll.nbits_in_bitbuf before
+// calling de_bitreader_peekbits().
+void de_bitreader_skip_peeked_bits(struct de_bitreader *bitrd, UI nbits,
+	UI orig_nbits_in_bitbuf)
+{
+	struct de_bitbuf_lowlevel *bbll = &bitrd->bbll;
+	UI nbytes_loaded;
+	UI nbytes_needed;
+	UI nbytes_to_unread;
+
+	nbytes_loaded = (bbll->nbits_in_bitbuf - orig_nbits_in_bitbuf)/8;
+	nbytes_needed = (nbits>orig_nbits_in_bitbuf) ? (nbits-orig_nbits_in_bitbuf+7)/8 : 0;
+
+	if(bbll->is_lsb==0) {
+		(void)bitbuf_get_bits_msb(bbll, nbits);
+	}
+	else {
+		(void)bitbuf_get_bits_lsb(bbll, nbits);
+	}
+
+	if(nbytes_loaded <= nbytes_needed) return;
+	nbytes_to_unread = nbytes_loaded - nbytes_needed;
+	bitrd->curpos -= (i64)nbytes_to_unread;
+	bbll->nbits_in_bitbuf -= nbytes_to_unread*8;
+	if(bbll->is_lsb==0) {
+		bbll->bit_buf >>= nbytes_to_unread*8;
+	}
+	else {
+		bbll->bit_buf &= ((u64)1 << bbll->nbits_in_bitbuf)-1;
+	}
 }
 
 // Empty the bitbuffer, and set ->curpos to the position of the next byte with
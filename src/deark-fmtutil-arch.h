@@ -17,6 +17,7 @@ typedef void (*de_arch_decompressor_cbfn)(struct de_arch_member_data *md);
 struct de_arch_member_data {
 	deark *c;
 	de_arch_lctx *d;
+	struct de_arena *arena; // For things that last until the md is destroyed
 	i64 member_idx;
 	i64 member_hdr_pos;
 	i64 member_hdr_size;
@@ -74,6 +75,8 @@ struct de_arch_localctx_struct {
 	int private1;
 	UI archive_flags;
 	struct de_arch_member_data *cur_md;
+
+	struct de_arena *spare_arena; // Internal use
 };
 
 struct de_arch_member_data *de_arch_create_md(deark *c, de_arch_lctx *d);
@@ -90,6 +90,15 @@ typedef void (*de_codectype1_type)(deark *c, struct de_dfilter_in_params *dcmpri
 	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
 	void *codec_private_params);
 
+// A compression method can have more than one decoder ("backend"). The one to
+// use can be selected with "-opt cmpr:<method>=<backend name>|auto".
+struct fmtutil_codec_backend {
+	const char *name;
+	de_codectype1_type codec_fn;
+};
+const struct fmtutil_codec_backend *fmtutil_get_codec_backend(const char *method, UI idx);
+const struct fmtutil_codec_backend *fmtutil_select_codec_backend(deark *c, const char *method);
+
 void fmtutil_decompress_uncompressed(deark *c, struct de_dfilter_in_params *dcmpri,
 	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres, UI flags);
 
@@ -99,12 +108,17 @@ void fmtutil_decompress_uncompressed(deark *c, struct de_dfilter_in_params *dcmp
 struct de_deflate_params {
 	unsigned int flags;
 	struct de_lz77buffer *ringbuf_to_use; // (Uses the data only, not the callback)
+	// If set, the decompressed data is also added to this CRC object.
+	struct de_crcobj *crco_for_output;
 };
 int fmtutil_decompress_deflate(dbuf *inf, i64 inputstart, i64 inputsize, dbuf *outf,
 	i64 maxuncmprsize, i64 *bytes_consumed, unsigned int flags);
 void fmtutil_decompress_deflate_ex(deark *c, struct de_dfilter_in_params *dcmpri,
 	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
 	struct de_deflate_params *params);
+void fmtutil_deflate_codectype1_native(deark *c, struct de_dfilter_in_params *dcmpri,
+	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
+	void *codec_private_params);
 void fmtutil_deflate_codectype1_miniz(deark *c, struct de_dfilter_in_params *dcmpri,
 	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
 	void *codec_private_params);
@@ -268,6 +282,24 @@ struct de_dcmpr_two_layer_params {
 };
 void de_dfilter_decompress_two_layer(deark *c, struct de_dcmpr_two_layer_params *tlp);
 
+struct de_dfilter_stage_params {
+	de_codectype1_type codec_type1; // Allowed for the first stage only
+	dfilter_codec_type codec_pushable; // Set either this or codec_type1
+	void *codec_private_params;
+	// Information about this stage's output. Ignored for the last stage.
+	u8 out_len_known;
+	i64 out_expected_len;
+};
+struct de_dcmpr_pipeline_params {
+	UI num_stages;
+	// stages[0] is the first one used during decompression.
+	const struct de_dfilter_stage_params *stages; // array[num_stages]
+	struct de_dfilter_in_params *dcmpri;
+	struct de_dfilter_out_params *dcmpro;
+	struct de_dfilter_results *dres;
+};
+void de_dfilter_decompress_pipeline(deark *c, struct de_dcmpr_pipeline_params *pp);
+
 void fmtutil_decompress_zip_shrink(deark *c, struct de_dfilter_in_params *dcmpri,
 	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
 	void *params);
@@ -670,10 +702,15 @@ int fmtutil_huffman_make_canonical_code(deark *c, struct fmtutil_huffman_codeboo
 	struct fmtutil_huffman_code_builder *builder, UI flags, const char *title);
 
 typedef void (*fmtutil_lz77buffer_cb_type)(struct de_lz77buffer *rb, u8 n);
+typedef void (*fmtutil_lz77buffer_span_cb_type)(struct de_lz77buffer *rb,
+	const u8 *buf, UI len);
 
 struct de_lz77buffer {
 	void *userdata;
 	fmtutil_lz77buffer_cb_type writebyte_cb;
+	// If set, this is used instead of writebyte_cb. It receives up to
+	// bufsize bytes at a time.
+	fmtutil_lz77buffer_span_cb_type write_span_cb;
 	UI curpos; // Must be kept valid at all times (0...bufsize-1)
 	UI mask;
 	UI bufsize; // Required to be a power of 2
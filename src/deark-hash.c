@@ -0,0 +1,385 @@
+// This file is part of Deark.
+// Copyright (C) 2026 Jason Summers
+// See the file COPYING for terms of use.
+
+// deark-hash.c: SHA-1, SHA-256, and the "digestset" object, which calculates
+// several CRCs and hashes in one pass over the data.
+
+#define DE_NOT_IN_MODULE
+#include "deark-config.h"
+#include "deark-private.h"
+
+struct de_sha_ctx {
+	u32 h[8];
+	u64 total_len; // in bytes
+	UI buf_used;
+	u8 buf[64];
+};
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32-(n))))
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32-(n))))
+
+static u32 sha_getu32be(const u8 *m)
+{
+	return ((u32)m[0]<<24) | ((u32)m[1]<<16) | ((u32)m[2]<<8) | (u32)m[3];
+}
+
+static void sha1_init(struct de_sha_ctx *sc)
+{
+	de_zeromem(sc, sizeof(struct de_sha_ctx));
+	sc->h[0] = 0x67452301U;
+	sc->h[1] = 0xefcdab89U;
+	sc->h[2] = 0x98badcfeU;
+	sc->h[3] = 0x10325476U;
+	sc->h[4] = 0xc3d2e1f0U;
+}
+
+static void sha1_block(struct de_sha_ctx *sc, const u8 *blk)
+{
+	u32 w[80];
+	u32 a, b, cc, d, e, f, k, tmp;
+	UI i;
+
+	for(i=0; i<16; i++) {
+		w[i] = sha_getu32be(&blk[i*4]);
+	}
+	for(i=16; i<80; i++) {
+		w[i] = ROTL32(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+	}
+
+	a = sc->h[0]; b = sc->h[1]; cc = sc->h[2]; d = sc->h[3]; e = sc->h[4];
+
+	for(i=0; i<80; i++) {
+		if(i<20) {
+			f = (b & cc) | (~b & d);
+			k = 0x5a827999U;
+		}
+		else if(i<40) {
+			f = b ^ cc ^ d;
+			k = 0x6ed9eba1U;
+		}
+		else if(i<60) {
+			f = (b & cc) | (b & d) | (cc & d);
+			k = 0x8f1bbcdcU;
+		}
+		else {
+			f = b ^ cc ^ d;
+			k = 0xca62c1d6U;
+		}
+		tmp = ROTL32(a, 5) + f + e + k + w[i];
+		e = d;
+		d = cc;
+		cc = ROTL32(b, 30);
+		b = a;
+		a = tmp;
+	}
+
+	sc->h[0] += a; sc->h[1] += b; sc->h[2] += cc; sc->h[3] += d; sc->h[4] += e;
+}
+
+static const u32 sha256_k[64] = {
+	0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU, 0x59f111f1U,
+	0x923f82a4U, 0xab1c5ed5U, 0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U,
+	0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U, 0xc19bf174U, 0xe49b69c1U, 0xefbe4786U,
+	0x0fc19dc6U, 0x240ca1ccU, 0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU,
+	0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U, 0xc6e00bf3U, 0xd5a79147U,
+	0x06ca6351U, 0x14292967U, 0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU, 0x53380d13U,
+	0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U, 0xa2bfe8a1U, 0xa81a664bU,
+	0xc24b8b70U, 0xc76c51a3U, 0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U,
+	0x19a4c116U, 0x1e376c08U, 0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU,
+	0x5b9cca4fU, 0x682e6ff3U, 0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U,
+	0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U
+};
+
+static void sha256_init(struct de_sha_ctx *sc)
+{
+	de_zeromem(sc, sizeof(struct de_sha_ctx));
+	sc->h[0] = 0x6a09e667U;
+	sc->h[1] = 0xbb67ae85U;
+	sc->h[2] = 0x3c6ef372U;
+	sc->h[3] = 0xa54ff53aU;
+	sc->h[4] = 0x510e527fU;
+	sc->h[5] = 0x9b05688cU;
+	sc->h[6] = 0x1f83d9abU;
+	sc->h[7] = 0x5be0cd19U;
+}
+
+static void sha256_block(struct de_sha_ctx *sc, const u8 *blk)
+{
+	u32 w[64];
+	u32 a, b, cc, d, e, f, g, h, t1, t2;
+	UI i;
+
+	for(i=0; i<16; i++) {
+		w[i] = sha_getu32be(&blk[i*4]);
+	}
+	for(i=16; i<64; i++) {
+		u32 s0, s1;
+
+		s0 = ROTR32(w[i-15], 7) ^ ROTR32(w[i-15], 18) ^ (w[i-15] >> 3);
+		s1 = ROTR32(w[i-2], 17) ^ ROTR32(w[i-2], 19) ^ (w[i-2] >> 10);
+		w[i] = w[i-16] + s0 + w[i-7] + s1;
+	}
+
+	a = sc->h[0]; b = sc->h[1]; cc = sc->h[2]; d = sc->h[3];
+	e = sc->h[4]; f = sc->h[5]; g = sc->h[6]; h = sc->h[7];
+
+	for(i=0; i<64; i++) {
+		t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) +
+			((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+		t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) +
+			((a & b) ^ (a & cc) ^ (b & cc));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = cc;
+		cc = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	sc->h[0] += a; sc->h[1] += b; sc->h[2] += cc; sc->h[3] += d;
+	sc->h[4] += e; sc->h[5] += f; sc->h[6] += g; sc->h[7] += h;
+}
+
+typedef void (*sha_block_fn_type)(struct de_sha_ctx *sc, const u8 *blk);
+
+static void sha_addbuf(struct de_sha_ctx *sc, sha_block_fn_type blockfn,
+	const u8 *buf, i64 buf_len)
+{
+	if(buf_len<1) return;
+	sc->total_len += (u64)buf_len;
+
+	if(sc->buf_used>0) {
+		UI n = (UI)de_min_int(64-(i64)sc->buf_used, buf_len);
+
+		de_memcpy(&sc->buf[sc->buf_used], buf, n);
+		sc->buf_used += n;
+		buf += n;
+		buf_len -= n;
+		if(sc->buf_used<64) return;
+		blockfn(sc, sc->buf);
+		sc->buf_used = 0;
+	}
+
+	while(buf_len>=64) {
+		blockfn(sc, buf);
+		buf += 64;
+		buf_len -= 64;
+	}
+
+	if(buf_len>0) {
+		de_memcpy(sc->buf, buf, (size_t)buf_len);
+		sc->buf_used = (UI)buf_len;
+	}
+}
+
+// Writes nwords*4 bytes to digest. Does not change sc, so it can be
+// called more than once.
+static void sha_finish(const struct de_sha_ctx *sc1, sha_block_fn_type blockfn,
+	UI nwords, u8 *digest)
+{
+	struct de_sha_ctx sc;
+	u64 nbits;
+	UI i;
+
+	sc = *sc1;
+	nbits = sc.total_len * 8;
+
+	sc.buf[sc.buf_used++] = 0x80;
+	if(sc.buf_used > 56) {
+		de_zeromem(&sc.buf[sc.buf_used], 64-(size_t)sc.buf_used);
+		blockfn(&sc, sc.buf);
+		sc.buf_used = 0;
+	}
+	de_zeromem(&sc.buf[sc.buf_used], 56-(size_t)sc.buf_used);
+	for(i=0; i<8; i++) {
+		sc.buf[56+i] = (u8)(nbits >> (56-8*i));
+	}
+	blockfn(&sc, sc.buf);
+
+	for(i=0; i<nwords; i++) {
+		digest[i*4  ] = (u8)(sc.h[i] >> 24);
+		digest[i*4+1] = (u8)(sc.h[i] >> 16);
+		digest[i*4+2] = (u8)(sc.h[i] >> 8);
+		digest[i*4+3] = (u8)sc.h[i];
+	}
+}
+
+// The digestset processes data in blocks of this size. Each block is run
+// through every algorithm before moving on to the next block, so the data
+// only has to be brought into the cache once.
+#define DE_DIGESTSET_BLKSIZE 8192
+
+struct de_digestset {
+	deark *c;
+	UI flags;
+	i64 total_len;
+	struct de_crcobj *crco_32;
+	struct de_crcobj *crco_16arc;
+	struct de_crcobj *crco_16xmodem;
+	struct de_sha_ctx sha1;
+	struct de_sha_ctx sha256;
+};
+
+// flags: DE_DIGEST_* flags, for the algorithms to calculate.
+struct de_digestset *de_digestset_create(deark *c, UI flags)
+{
+	struct de_digestset *ds;
+
+	ds = de_malloc(c, sizeof(struct de_digestset));
+	ds->c = c;
+	ds->flags = flags;
+	if(flags & DE_DIGEST_CRC32) {
+		ds->crco_32 = de_crcobj_create(c, DE_CRCOBJ_CRC32_IEEE);
+	}
+	if(flags & DE_DIGEST_CRC16ARC) {
+		ds->crco_16arc = de_crcobj_create(c, DE_CRCOBJ_CRC16_ARC);
+	}
+	if(flags & DE_DIGEST_CRC16XMODEM) {
+		ds->crco_16xmodem = de_crcobj_create(c, DE_CRCOBJ_CRC16_XMODEM);
+	}
+	sha1_init(&ds->sha1);
+	sha256_init(&ds->sha256);
+	return ds;
+}
+
+void de_digestset_destroy(struct de_digestset *ds)
+{
+	if(!ds) return;
+	de_crcobj_destroy(ds->crco_32);
+	de_crcobj_destroy(ds->crco_16arc);
+	de_crcobj_destroy(ds->crco_16xmodem);
+	de_free(ds->c, ds);
+}
+
+void de_digestset_addbuf(struct de_digestset *ds, const u8 *buf, i64 buf_len)
+{
+	while(buf_len>0) {
+		i64 n = de_min_int(buf_len, DE_DIGESTSET_BLKSIZE);
+
+		if(ds->crco_32) de_crcobj_addbuf(ds->crco_32, buf, n);
+		if(ds->crco_16arc) de_crcobj_addbuf(ds->crco_16arc, buf, n);
+		if(ds->crco_16xmodem) de_crcobj_addbuf(ds->crco_16xmodem, buf, n);
+		if(ds->flags & DE_DIGEST_SHA1) sha_addbuf(&ds->sha1, sha1_block, buf, n);
+		if(ds->flags & DE_DIGEST_SHA256) sha_addbuf(&ds->sha256, sha256_block, buf, n);
+		ds->total_len += n;
+		buf += n;
+		buf_len -= n;
+	}
+}
+
+static int digestset_addslice_cbfn(struct de_bufferedreadctx *brctx, const u8 *buf,
+	i64 buf_len)
+{
+	de_digestset_addbuf((struct de_digestset*)brctx->userdata, buf, buf_len);
+	return 1;
+}
+
+void de_digestset_addslice(struct de_digestset *ds, dbuf *f, i64 pos, i64 len)
+{
+	dbuf_buffered_read(f, pos, len, digestset_addslice_cbfn, (void*)ds);
+}
+
+// A writelistener callback function that updates a digestset.
+// To use, set userdata to your 'struct de_digestset *' object.
+void de_writelistener_for_digestset(dbuf *f, void *userdata, const u8 *buf, i64 buf_len)
+{
+	de_digestset_addbuf((struct de_digestset*)userdata, buf, buf_len);
+}
+
+// Writes the result of one algorithm (a single DE_DIGEST_* flag) to buf, as
+// a string of lowercase hex digits. Writes an empty string if the algorithm
+// is not enabled.
+// The digestset can still be used afterward.
+void de_digestset_get_string(struct de_digestset *ds, UI which, char *buf, size_t buflen)
+{
+	u8 digest[32];
+	UI nbytes = 0;
+	UI i;
+
+	if(buflen<1) return;
+	buf[0] = '\0';
+	if(!(ds->flags & which)) return;
+
+	switch(which) {
+	case DE_DIGEST_CRC32:
+		de_snprintf(buf, buflen, "%08x", (UI)de_crcobj_getval(ds->crco_32));
+		return;
+	case DE_DIGEST_CRC16ARC:
+		de_snprintf(buf, buflen, "%04x", (UI)de_crcobj_getval(ds->crco_16arc));
+		return;
+	case DE_DIGEST_CRC16XMODEM:
+		de_snprintf(buf, buflen, "%04x", (UI)de_crcobj_getval(ds->crco_16xmodem));
+		return;
+	case DE_DIGEST_SHA1:
+		sha_finish(&ds->sha1, sha1_block, 5, digest);
+		nbytes = 20;
+		break;
+	case DE_DIGEST_SHA256:
+		sha_finish(&ds->sha256, sha256_block, 8, digest);
+		nbytes = 32;
+		break;
+	default:
+		return;
+	}
+
+	for(i=0; i<nbytes && (size_t)i*2+2<buflen; i++) {
+		buf[i*2] = de_get_hexchar(digest[i]>>4);
+		buf[i*2+1] = de_get_hexchar(digest[i]&0x0f);
+		buf[i*2+2] = '\0';
+	}
+}
+
+static const struct {
+	UI flag;
+	const char *name;
+} digest_names[] = {
+	{ DE_DIGEST_CRC32, "crc32" },
+	{ DE_DIGEST_CRC16ARC, "crc16" },
+	{ DE_DIGEST_CRC16XMODEM, "crc16xmodem" },
+	{ DE_DIGEST_SHA1, "sha1" },
+	{ DE_DIGEST_SHA256, "sha256" }
+};
+
+// Returns a short name like "sha1", for one DE_DIGEST_* flag.
+const char *de_digest_get_name(UI which)
+{
+	size_t i;
+
+	for(i=0; i<DE_ARRAYCOUNT(digest_names); i++) {
+		if(digest_names[i].flag==which) return digest_names[i].name;
+	}
+	return "?";
+}
+
+// Parses a comma-separated list of algorithm names, such as "crc32,sha1".
+// Returns the DE_DIGEST_* flags. Unknown names are reported, and ignored.
+UI de_parse_digest_list(deark *c, const char *s)
+{
+	UI flags = 0;
+
+	while(s && *s) {
+		const char *endp;
+		size_t len;
+		size_t i;
+		int found = 0;
+
+		endp = de_strchr(s, ',');
+		len = endp ? (size_t)(endp-s) : de_strlen(s);
+		for(i=0; i<DE_ARRAYCOUNT(digest_names); i++) {
+			if(de_strlen(digest_names[i].name)==len &&
+				!de_strncmp(s, digest_names[i].name, len))
+			{
+				flags |= digest_names[i].flag;
+				found = 1;
+			}
+		}
+		if(!found && len>0) {
+			de_warn(c, "Unknown digest algorithm \"%.*s\"", (int)len, s);
+		}
+		s = endp ? endp+1 : NULL;
+	}
+	return flags;
+}
@@ -15,13 +15,17 @@
 
 static void register_a_module(deark *c, de_module_getinfo_fn infofunc)
 {
-	infofunc(c, &c->module_info[c->num_modules++]);
+	infofunc(c, &c->module_info[c->num_modules]);
+	de_sigindex_add_module(c, c->num_modules);
+	c->num_modules++;
 }
 
 static void disable_module(deark *c, struct deark_module_info *mi)
 {
 	mi->identify_fn = NULL;
 	mi->run_fn = NULL;
+	mi->sigs = NULL;
+	mi->num_sigs = 0;
 }
 
 // Caller supplies mod_set[c->num_modules].
@@ -327,6 +327,7 @@ DE_MODULE(de_module_crc)
 DE_MODULE(de_module_datetime)
 DE_MODULE(de_module_hexdump)
 DE_MODULE(de_module_bytefreq)
+DE_MODULE(de_module_deflatebench)
 DE_MODULE(de_module_plaintext)
 DE_MODULE(de_module_cp437)
 DE_MODULE(de_module_copy)
@@ -73,6 +73,8 @@ typedef struct dbuf_struct dbuf;
 struct de_finfo_struct;
 typedef struct de_finfo_struct de_finfo;
 struct de_crcobj;
+struct de_blockcache;
+struct de_sigindex;
 
 struct de_module_params_struct;
 typedef struct de_module_params_struct de_module_params;
@@ -86,6 +88,17 @@ typedef int (*de_module_identify_fn)(deark *c);
 
 typedef void (*de_module_help_fn)(deark *c);
 
+// A static signature: 'len' bytes at offset 'pos' of the input file.
+// Signatures are collected into an index when the modules are registered, so
+// that autodetection can skip modules whose signatures cannot match.
+#define DE_MAX_MODULE_SIG_LEN 64
+struct de_module_sig {
+	u32 pos;
+	u8 len;
+	u8 confidence; // Used only if the module has no identify_fn
+	const char *bytes;
+};
+
 struct deark_module_info {
 	const char *id;
 	const char *desc;
@@ -104,6 +117,12 @@ struct deark_module_info {
 	u32 unique_id; // or 0. Rarely used.
 #define DE_MAX_MODULE_ALIASES 2
 	const char *id_alias[DE_MAX_MODULE_ALIASES];
+	// Optional signatures. If the module has no identify_fn, its confidence
+	// is that of the best matching signature. Otherwise, identify_fn is only
+	// called if at least one of the signatures matches, so the signatures
+	// must cover every file that identify_fn could accept.
+	const struct de_module_sig *sigs;
+	int num_sigs;
 };
 typedef void (*de_module_getinfo_fn)(deark *c, struct deark_module_info *mi);
 
@@ -122,6 +141,7 @@ struct de_ucstring_struct {
 	i64 len; // len and alloc are measured in characters, not bytes
 	i64 alloc;
 	char *tmp_string;
+	struct de_arena *arena; // If set, our memory belongs to this arena
 };
 
 struct de_timestamp {
@@ -175,6 +195,12 @@ struct dbuf_struct {
 	i64 wbuffer_bytes_used;
 	u8 *wbuffer;
 
+	// Low-level buffer for managed output files, below the wbuffer and the
+	// writelistener. It only reduces the number of physical writes.
+	i64 obuf_bytes_used;
+	i64 obuf_alloc;
+	u8 *obuf;
+
 	struct dbuf_struct *parent_dbuf; // used for DBUF_TYPE_DBUF
 	i64 offset_into_parent_dbuf; // used for DBUF_TYPE_DBUF
 
@@ -186,7 +212,7 @@ struct dbuf_struct {
 	i64 membuf_alloc;
 	u8 *membuf_buf;
 
-	struct de_crcobj *crco_for_oinfo;
+	struct de_digestset *digests_for_oinfo;
 
 	void *userdata_for_writelistener;
 	de_writelistener_cb_type writelistener_cb;
@@ -200,6 +226,11 @@ struct dbuf_struct {
 	int rcache_policy;
 	i64 rcache_bytes_used;
 	u8 *rcache; // first 'cache_bytes_used' bytes of the file
+	// If set, rcache is a read-only memory-mapping of the whole file, not
+	// something we allocated.
+	struct de_mmapinfo *mmapinfo;
+	// Used for DBUF_TYPE_IFILE, for data not in the rcache.
+	struct de_blockcache *bcache;
 
 	// Things copied from the de_finfo object at file creation
 	de_finfo *fi_copy;
@@ -247,6 +278,7 @@ struct de_finfo_struct {
 	int hotspot_x, hotspot_y; // Measured from upper-left pixel (after handling 'flipped')
 	u32 riscos_attribs;
 	u32 load_addr, exec_addr;
+	struct de_arena *arena; // If set, the finfo struct belongs to this arena
 };
 
 struct deark_bitmap_struct {
@@ -367,6 +399,7 @@ struct deark_struct {
 	int num_files_extracted;
 
 	i64 total_output_size;
+	i64 num_output_write_calls; // Statistic: Physical writes to output files
 	int error_count;
 	u8 serious_error_flag;
 
@@ -390,6 +423,7 @@ struct deark_struct {
 	u8 list_mode;
 	u8 list_mode_include_file_id;
 	u8 enable_oinfo;
+	UI oinfo_digests; // DE_DIGEST_* flags
 	int first_output_file; // first file = 0
 	int max_output_files;
 	u8 user_set_max_output_files;
@@ -416,6 +450,7 @@ struct deark_struct {
 	struct de_timestamp reproducible_timestamp;
 	int can_decode_fltpt;
 	int host_is_le;
+	int crc32_impl; // -1 if not yet detected
 	u8 identify_only;
 	u8 modhelp_req;
 	de_encoding input_encoding;
@@ -426,11 +461,20 @@ struct deark_struct {
 	de_fatalerrorfn_type fatalerrorfn;
 	const char *dprefix;
 
-	u8 deflate_decoder_id;
+	u8 codec_backend_sel[8]; // Used by fmtutil_select_codec_backend()
 	u8 tmpflag1;
 	u8 tmpflag2;
 	u8 enable_wbuffer_test;
 	u8 disable_wbuffer;
+	u8 disable_mmap;
+	u8 disable_zerocopy;
+	u8 dfilter_threads;
+	u8 objpool_disabled; // Nonzero while other threads might use c
+	struct de_objpool *objpool;
+	struct de_arena *module_arena; // Private to de_run_module(); use de_get_module_arena()
+	i64 iocache_size; // Size of the input file block cache, in bytes
+	i64 input_mem_limit; // Max bytes of piped input to keep in memory
+	i64 obuf_max_size; // Max size of output file buffers; 0 = disabled
 	u8 pngcprlevel_valid;
 	unsigned int pngcmprlevel;
 	void *zip_data;
@@ -453,6 +497,8 @@ struct deark_struct {
 
 	int num_modules;
 	struct deark_module_info *module_info; // Pointer to an array
+	struct de_sigindex *sigindex;
+	u8 detect_verify;
 
 #define DE_MAX_EXT_OPTIONS 16
 	int num_ext_options;
@@ -465,6 +511,33 @@ void de_internal_err_fatal(deark *c, const char *fmt, ...)
 void de_internal_err_nonfatal(deark *c, const char *fmt, ...)
   de_gnuc_attribute ((format (printf, 2, 3)));
 
+// A per-run pool of objects (mostly decompressor state) that would otherwise
+// be freed and then recreated soon after, e.g. for every member of an archive.
+#define DE_OBJPOOL_INFLATE_OUTBUF   1
+#define DE_OBJPOOL_INFLATE_INBUF    2
+#define DE_OBJPOOL_LZW_TABLE        3
+#define DE_OBJPOOL_LZW_TABLE2       4
+#define DE_OBJPOOL_LZW_BUF          5
+#define DE_OBJPOOL_LZ77BUFFER       6
+#define DE_OBJPOOL_HUFFMAN_DECODER  7
+struct de_objpool;
+typedef void (*de_objpool_destroy_fn)(deark *c, void *obj);
+void *de_objpool_get(deark *c, UI objtype, i64 size);
+void de_objpool_put(deark *c, UI objtype, i64 size, void *obj,
+	de_objpool_destroy_fn destroy_fn);
+void de_objpool_destroy(deark *c);
+#define DE_POOLFLAG_NOZERO 0x1
+void *de_pool_malloc(deark *c, UI objtype, i64 size, UI flags);
+void de_pool_free(deark *c, UI objtype, i64 size, void *m);
+
+struct de_arena;
+struct de_arena *de_arena_create(deark *c, i64 blksize);
+void *de_arena_malloc(struct de_arena *a, i64 n);
+void *de_arena_realloc(struct de_arena *a, void *m, i64 oldsize, i64 newsize);
+void de_arena_reset(struct de_arena *a);
+void de_arena_destroy(struct de_arena *a);
+struct de_arena *de_get_module_arena(deark *c);
+
 deark *de_create_internal(void);
 int de_run_module(deark *c, struct deark_module_info *mi, de_module_params *mparams,
 	enum de_moddisp_enum moddisp);
@@ -475,6 +548,9 @@ int de_run_module_by_id_on_slice2(deark *c, const char *id, const char *codes,
 	dbuf *f, i64 pos, i64 len);
 int de_get_module_idx_by_id(deark *c, const char *module_id);
 struct deark_module_info *de_get_module_by_id(deark *c, const char *module_id);
+void de_sigindex_add_module(deark *c, int module_idx);
+const int *de_sigindex_scan(deark *c);
+void de_sigindex_destroy(deark *c);
 
 void de_strlcpy(char *dst, const char *src, size_t dstlen);
 char *de_strchr(const char *s, int c);
@@ -527,6 +603,23 @@ int de_fseek(FILE *fp, i64 offs, int whence);
 i64 de_ftell(FILE *fp);
 int de_fclose(FILE *fp);
 void de_update_file_attribs(dbuf *f, u8 preserve_file_times);
+FILE *de_fopen_tmpfile(deark *c);
+i64 de_copy_file_data(deark *c, FILE *infp, i64 inpos, FILE *outfp, i64 len);
+struct de_mmapinfo;
+struct de_mmapinfo *de_mmap_file_for_read(deark *c, FILE *fp, i64 len,
+	const u8 **pmem);
+void de_munmap_file(deark *c, struct de_mmapinfo *mmi);
+typedef void (*de_thread_fn_type)(void *userdata);
+struct de_threadinfo;
+struct de_threadinfo *de_thread_create(deark *c, de_thread_fn_type fn, void *userdata);
+void de_thread_join(deark *c, struct de_threadinfo *ti);
+struct de_syncobj;
+struct de_syncobj *de_syncobj_create(deark *c);
+void de_syncobj_destroy(deark *c, struct de_syncobj *so);
+void de_syncobj_lock(struct de_syncobj *so);
+void de_syncobj_unlock(struct de_syncobj *so);
+void de_syncobj_wait(struct de_syncobj *so);
+void de_syncobj_broadcast(struct de_syncobj *so);
 
 void de_declare_fmt(deark *c, const char *fmtname);
 void de_declare_fmtf(deark *c, const char *fmt, ...)
@@ -710,6 +803,7 @@ void dbuf_enable_wbuffer(dbuf *f);
 void dbuf_disable_wbuffer(dbuf *f);
 void dbuf_set_writelistener(dbuf *f, de_writelistener_cb_type fn, void *userdata);
 void de_writelistener_for_crc(dbuf *f, void *userdata, const u8 *buf, i64 buf_len);
+void de_writelistener_for_digestset(dbuf *f, void *userdata, const u8 *buf, i64 buf_len);
 
 void dbuf_write(dbuf *f, const u8 *m, i64 len);
 void dbuf_write_at(dbuf *f, i64 pos, const u8 *m, i64 len);
@@ -783,10 +877,20 @@ void dbuf_empty(dbuf *f);
 i64 dbuf_get_length(dbuf *f);
 void dbuf_set_length_limit(dbuf *f, i64 max_len);
 const u8 *dbuf_get_membuf_direct_ptr(dbuf *f);
+int dbuf_get_span_direct(dbuf *f, i64 pos, i64 len, const u8 **pptr);
+const u8 *dbuf_get_span(dbuf *f, i64 pos, i64 len, u8 *tmpbuf);
 int dbuf_search_byte(dbuf *f, const u8 b, i64 startpos, i64 haystack_len,
 	i64 *foundpos);
 int dbuf_search(dbuf *f, const u8 *needle, i64 needle_len, i64 startpos,
 	i64 haystack_len, i64 *foundpos);
+struct de_multisearch;
+struct de_multisearch *de_multisearch_create(deark *c);
+void de_multisearch_add_needle(deark *c, struct de_multisearch *ms,
+	const u8 *needle, i64 needle_len, UI id);
+void de_multisearch_destroy(deark *c, struct de_multisearch *ms);
+typedef int (*de_multisearch_cbfn)(deark *c, void *userdata, UI id, i64 pos);
+int dbuf_multisearch(dbuf *f, struct de_multisearch *ms, i64 startpos,
+	i64 haystack_len, de_multisearch_cbfn cbfn, void *userdata);
 int dbuf_get_utf16_NULterm_len(dbuf *f, i64 pos1, i64 bytes_avail,
 	i64 *bytes_consumed);
 int dbuf_find_line(dbuf *f, i64 pos1, i64 *pcontent_len, i64 *ptotal_len);
@@ -840,6 +944,9 @@ struct de_bitreader {
 	struct de_bitbuf_lowlevel bbll;
 };
 u64 de_bitreader_getbits(struct de_bitreader *bitrd, UI nbits);
+int de_bitreader_peekbits(struct de_bitreader *bitrd, UI nbits, u64 *pval);
+void de_bitreader_skip_peeked_bits(struct de_bitreader *bitrd, UI nbits,
+	UI orig_nbits_in_bitbuf);
 void de_bitreader_skip_to_byte_boundary(struct de_bitreader *bitrd);
 char *de_bitbuf_describe_curpos(struct de_bitbuf_lowlevel *bbll, i64 pos,
 	char *buf, size_t buf_len);
@@ -1003,6 +1110,8 @@ void de_copy_std_palette(int pal_id, int pal_subid, i64 starting_idx, i64 count,
 
 const u8 *de_get_8x8ascii_font_ptr(void);
 const u8 *de_get_vga_cp437_font_ptr(void);
+const u32 *de_get_crc32_slice8_tables_ptr(void);
+const u16 *de_get_crc16_slice4_tables_ptr(UI crctype);
 
 void de_color_to_css(de_color color, char *buf, int buflen);
 
@@ -1039,6 +1148,7 @@ void de_bytes_to_printable_sz(const u8 *src, i64 src_len,
 	char *dst, i64 dst_len, unsigned int conv_flags, de_ext_encoding src_ee);
 
 de_finfo *de_finfo_create(deark *c);
+de_finfo *de_finfo_create_in_arena(deark *c, struct de_arena *a);
 void de_finfo_destroy(deark *c, de_finfo *fi);
 
 #define DE_SNFLAG_FULLPATH 0x01
@@ -1048,6 +1158,7 @@ void de_finfo_set_name_from_sz(deark *c, de_finfo *fi, const char *name1, unsign
 	de_ext_encoding ee);
 
 de_ucstring *ucstring_create(deark *c);
+de_ucstring *ucstring_create_in_arena(deark *c, struct de_arena *a);
 de_ucstring *ucstring_clone(const de_ucstring *src);
 void ucstring_destroy(de_ucstring *s);
 void ucstring_empty(de_ucstring *s);
@@ -1145,7 +1256,24 @@ u32 de_crcobj_getval(struct de_crcobj *crco);
 void de_crcobj_addbuf(struct de_crcobj *crco, const u8 *buf, i64 buf_len);
 void de_crcobj_addrun(struct de_crcobj *crco, u8 v, i64 len);
 void de_crcobj_addzeroes(struct de_crcobj *crco, i64 len);
+void de_crcobj_combine(struct de_crcobj *crco, u32 crc2, i64 len2);
 void de_crcobj_addslice(struct de_crcobj *crco, dbuf *f, i64 pos, i64 len);
+int de_crcobj_selftest(deark *c);
+
+// digestset: Calculates several CRCs and hashes in a single pass.
+#define DE_DIGEST_CRC32        0x01
+#define DE_DIGEST_CRC16ARC     0x02
+#define DE_DIGEST_CRC16XMODEM  0x04
+#define DE_DIGEST_SHA1         0x08
+#define DE_DIGEST_SHA256       0x10
+struct de_digestset;
+struct de_digestset *de_digestset_create(deark *c, UI flags);
+void de_digestset_destroy(struct de_digestset *ds);
+void de_digestset_addbuf(struct de_digestset *ds, const u8 *buf, i64 buf_len);
+void de_digestset_addslice(struct de_digestset *ds, dbuf *f, i64 pos, i64 len);
+void de_digestset_get_string(struct de_digestset *ds, UI which, char *buf, size_t buflen);
+const char *de_digest_get_name(UI which);
+UI de_parse_digest_list(deark *c, const char *s);
 u32 de_calccrc_oneshot(dbuf *f, i64 pos, i64 len, UI type_and_flags);
 
 ///////////////////////////////////////////
@@ -1285,4 +1413,5 @@ char *de_dbg_timestamp_to_string(deark *c, const struct de_timestamp *ts,
 	char *buf, size_t buf_len, unsigned int flags);
 void de_gmtime(const struct de_timestamp *ts, struct de_struct_tm *tm2);
 void de_current_time_to_timestamp(struct de_timestamp *ts);
+i64 de_get_monotonic_time_usec(void);
 void de_cached_current_time_to_timestamp(deark *c, struct de_timestamp *ts);
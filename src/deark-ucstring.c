@@ -18,6 +18,18 @@ de_ucstring *ucstring_create(deark *c)
 	return s;
 }
 
+// Create a string whose memory all comes from arena 'a'. Destroying it is
+// optional, and does nothing; its memory is released with the arena.
+// Suitable for temporary strings that won't grow very large.
+de_ucstring *ucstring_create_in_arena(deark *c, struct de_arena *a)
+{
+	de_ucstring *s;
+	s = de_arena_malloc(a, sizeof(de_ucstring));
+	s->c = c;
+	s->arena = a;
+	return s;
+}
+
 void ucstring_empty(de_ucstring *s)
 {
 	ucstring_truncate(s, 0);
@@ -35,7 +47,7 @@ void ucstring_truncate(de_ucstring *s, i64 newlen)
 	if(s->tmp_string) {
 		// There's no requirement to free tmp_string here, but it's no
 		// longer needed, and maybe it's nice to have a way to do it.
-		de_free(s->c, s->tmp_string);
+		if(!s->arena) de_free(s->c, s->tmp_string);
 		s->tmp_string = NULL;
 	}
 }
@@ -113,7 +125,7 @@ de_ucstring *ucstring_clone(const de_ucstring *src)
 void ucstring_destroy(de_ucstring *s)
 {
 	deark *c;
-	if(s) {
+	if(s && !s->arena) {
 		c = s->c;
 		de_free(c, s->str);
 		de_free(c, s->tmp_string);
@@ -144,7 +156,13 @@ void ucstring_append_char(de_ucstring *s, de_rune ch)
 	if(new_len > s->alloc) {
 		new_alloc = s->alloc * 2;
 		if(new_alloc<32) new_alloc=32;
-		s->str = de_reallocarray(s->c, s->str, s->alloc, sizeof(i32), new_alloc);
+		if(s->arena) {
+			s->str = de_arena_realloc(s->arena, s->str, s->alloc*(i64)sizeof(de_rune),
+				new_alloc*(i64)sizeof(de_rune));
+		}
+		else {
+			s->str = de_reallocarray(s->c, s->str, s->alloc, sizeof(i32), new_alloc);
+		}
 		s->alloc = new_alloc;
 	}
 
@@ -583,9 +601,14 @@ static const char *ucstring_getpsz_internal(de_ucstring *s,
 		allocsize = s->len * 4 + 1 + 100;
 	}
 
-	if(s->tmp_string)
-		de_free(s->c, s->tmp_string);
-	s->tmp_string = de_malloc(s->c, allocsize);
+	if(s->arena) {
+		s->tmp_string = de_arena_malloc(s->arena, allocsize);
+	}
+	else {
+		if(s->tmp_string)
+			de_free(s->c, s->tmp_string);
+		s->tmp_string = de_malloc(s->c, allocsize);
+	}
 
 	ucstring_to_sz(s, s->tmp_string, (size_t)allocsize, DE_CONVFLAG_MAKE_PRINTABLE, DE_ENCODING_UTF8);
 
@@ -9,12 +9,26 @@
 
 #ifdef DE_UNIX
 
+#if DE_USE_COPY_FILE_RANGE && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // for copy_file_range()
+#endif
+
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <utime.h>
 #include <errno.h>
+#if DE_USE_MMAP
+#include <sys/mman.h>
+#endif
+#if DE_USE_COPY_FILE_RANGE
+#include <sys/sendfile.h>
+#endif
+#if DE_USE_THREADS
+#include <pthread.h>
+#endif
 
 // This file is overloaded, in that it contains functions intended to only
 // be used internally, as well as functions intended only for the
@@ -192,6 +206,231 @@ int de_fclose(FILE *fp)
 	return fclose(fp);
 }
 
+// Create a new temporary file, opened for update, that will be deleted
+// automatically when it is closed.
+// Returns NULL on failure.
+FILE *de_fopen_tmpfile(deark *c)
+{
+	return tmpfile();
+}
+
+// Try to copy len bytes, starting at position inpos of infp, to the current
+// position of outfp, without passing the data through user space.
+// Does not use or change infp's file position. outfp must not have any
+// unflushed data.
+// Returns the number of bytes copied, which may be less than len (0 if this
+// isn't supported). The caller should copy the rest in the usual way.
+i64 de_copy_file_data(deark *c, FILE *infp, i64 inpos, FILE *outfp, i64 len)
+{
+#if DE_USE_COPY_FILE_RANGE
+	int infd, outfd;
+	int use_sendfile = 0;
+	i64 nbytes_copied = 0;
+
+	infd = fileno(infp);
+	outfd = fileno(outfp);
+
+	while(nbytes_copied < len) {
+		size_t amt_to_copy;
+		ssize_t ret;
+
+		amt_to_copy = (size_t)de_min_int(len-nbytes_copied, 0x40000000);
+
+		if(use_sendfile) {
+			off_t off_in;
+
+			if(sizeof(off_t)<8 && inpos+len > 0x7fffffffLL) break;
+			off_in = (off_t)(inpos+nbytes_copied);
+			ret = sendfile(outfd, infd, &off_in, amt_to_copy);
+		}
+		else {
+			loff_t off_in;
+
+			off_in = (loff_t)(inpos+nbytes_copied);
+			ret = copy_file_range(infd, &off_in, outfd, NULL, amt_to_copy, 0);
+			if(ret<0 && nbytes_copied==0 &&
+				(errno==ENOSYS || errno==EXDEV || errno==EINVAL || errno==EOPNOTSUPP))
+			{
+				// Try again, with the older system call.
+				use_sendfile = 1;
+				continue;
+			}
+		}
+
+		if(ret<1) break;
+		nbytes_copied += (i64)ret;
+	}
+
+	return nbytes_copied;
+#else
+	return 0;
+#endif
+}
+
+struct de_mmapinfo {
+	void *addr;
+	size_t len;
+};
+
+// Try to map the whole of a file (opened by de_fopen_for_read) into memory.
+// Returns NULL on failure, in which case the caller should fall back to
+// ordinary reads.
+// On success, sets *pmem to the mapped memory, which is valid until
+// de_munmap_file() is called.
+struct de_mmapinfo *de_mmap_file_for_read(deark *c, FILE *fp, i64 len,
+	const u8 **pmem)
+{
+#if DE_USE_MMAP
+	struct de_mmapinfo *mmi;
+	void *addr;
+
+	*pmem = NULL;
+	if(len<1) return NULL;
+	if((u64)len > (u64)(size_t)(-1)) return NULL;
+
+	addr = mmap(NULL, (size_t)len, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+	if(addr==MAP_FAILED) return NULL;
+
+	mmi = de_malloc(c, sizeof(struct de_mmapinfo));
+	mmi->addr = addr;
+	mmi->len = (size_t)len;
+	*pmem = (const u8*)addr;
+	return mmi;
+#else
+	*pmem = NULL;
+	return NULL;
+#endif
+}
+
+void de_munmap_file(deark *c, struct de_mmapinfo *mmi)
+{
+	if(!mmi) return;
+#if DE_USE_MMAP
+	munmap(mmi->addr, mmi->len);
+#endif
+	de_free(c, mmi);
+}
+
+struct de_threadinfo {
+#if DE_USE_THREADS
+	pthread_t thread;
+#endif
+	de_thread_fn_type fn;
+	void *userdata;
+};
+
+#if DE_USE_THREADS
+static void *de_thread_main(void *p)
+{
+	struct de_threadinfo *ti = (struct de_threadinfo*)p;
+
+	ti->fn(ti->userdata);
+	return NULL;
+}
+#endif
+
+// Start a new thread, which will call fn(userdata).
+// Returns NULL if threads are not supported, or the thread could not be
+// started. The caller should then do the work some other way.
+struct de_threadinfo *de_thread_create(deark *c, de_thread_fn_type fn, void *userdata)
+{
+#if DE_USE_THREADS
+	struct de_threadinfo *ti;
+
+	ti = de_malloc(c, sizeof(struct de_threadinfo));
+	ti->fn = fn;
+	ti->userdata = userdata;
+	if(pthread_create(&ti->thread, NULL, de_thread_main, (void*)ti)) {
+		de_free(c, ti);
+		return NULL;
+	}
+	return ti;
+#else
+	return NULL;
+#endif
+}
+
+// Wait for the thread to end, and free ti.
+void de_thread_join(deark *c, struct de_threadinfo *ti)
+{
+	if(!ti) return;
+#if DE_USE_THREADS
+	pthread_join(ti->thread, NULL);
+#endif
+	de_free(c, ti);
+}
+
+// A mutex, and a condition variable that goes with it.
+struct de_syncobj {
+#if DE_USE_THREADS
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+#else
+	int reserved;
+#endif
+};
+
+// Returns NULL if not supported.
+struct de_syncobj *de_syncobj_create(deark *c)
+{
+#if DE_USE_THREADS
+	struct de_syncobj *so;
+
+	so = de_malloc(c, sizeof(struct de_syncobj));
+	if(pthread_mutex_init(&so->mutex, NULL)) {
+		de_free(c, so);
+		return NULL;
+	}
+	if(pthread_cond_init(&so->cond, NULL)) {
+		pthread_mutex_destroy(&so->mutex);
+		de_free(c, so);
+		return NULL;
+	}
+	return so;
+#else
+	return NULL;
+#endif
+}
+
+void de_syncobj_destroy(deark *c, struct de_syncobj *so)
+{
+	if(!so) return;
+#if DE_USE_THREADS
+	pthread_cond_destroy(&so->cond);
+	pthread_mutex_destroy(&so->mutex);
+#endif
+	de_free(c, so);
+}
+
+void de_syncobj_lock(struct de_syncobj *so)
+{
+#if DE_USE_THREADS
+	pthread_mutex_lock(&so->mutex);
+#endif
+}
+
+void de_syncobj_unlock(struct de_syncobj *so)
+{
+#if DE_USE_THREADS
+	pthread_mutex_unlock(&so->mutex);
+#endif
+}
+
+// Must be called with the lock held.
+void de_syncobj_wait(struct de_syncobj *so)
+{
+#if DE_USE_THREADS
+	pthread_cond_wait(&so->cond, &so->mutex);
+#endif
+}
+
+void de_syncobj_broadcast(struct de_syncobj *so)
+{
+#if DE_USE_THREADS
+	pthread_cond_broadcast(&so->cond);
+#endif
+}
+
 struct upd_attr_ctx {
 	int tried_stat;
 	int stat_ret;
@@ -308,6 +547,26 @@ void de_current_time_to_timestamp(struct de_timestamp *ts)
 	de_timestamp_set_subsec(ts, ((double)tv.tv_usec)/1000000.0);
 }
 
+// Returns a time in microseconds, relative to an arbitrary starting point.
+// Only useful for measuring elapsed time.
+i64 de_get_monotonic_time_usec(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if(clock_gettime(CLOCK_MONOTONIC, &ts)==0) {
+		return (i64)ts.tv_sec*1000000 + (i64)(ts.tv_nsec/1000);
+	}
+#endif
+	{
+		struct timeval tv;
+
+		de_zeromem(&tv, sizeof(struct timeval));
+		(void)gettimeofday(&tv, NULL);
+		return (i64)tv.tv_sec*1000000 + (i64)tv.tv_usec;
+	}
+}
+
 void de_exitprocess(int s)
 {
 	exit(s);
@@ -17,48 +17,98 @@
 #define DE_DEFAULT_MAX_IMAGE_DIMENSION 10000
 #define DE_DEFAULT_MAX_OUTPUT_FILES 1000 // Limit for direct output (not ZIP)
 #define DE_MAX_OUTPUT_FILES_HARD_LIMIT 250000
+#define DE_DEFAULT_IOCACHE_SIZE 1048576 // 1MiB
+#define DE_DEFAULT_INPUT_MEM_LIMIT 268435456 // 256MiB
+#define DE_DEFAULT_OBUF_MAX_SIZE 262144 // 256KiB
+#define DE_MIN_OBUF_MAX_SIZE 65536
 
-// Returns the best module to use, by looking at the file contents, etc.
-static struct deark_module_info *detect_module_for_file(deark *c, int *errflag)
+// Evaluates a module's signatures the slow way, for -opt detect:verify.
+static int sigs_match_exhaustive(deark *c, const struct deark_module_info *mi)
+{
+	int k;
+	int best = -1;
+
+	for(k=0; k<mi->num_sigs; k++) {
+		const struct de_module_sig *sig = &mi->sigs[k];
+
+		if(!dbuf_memcmp(c->infile, (i64)sig->pos, sig->bytes, (size_t)sig->len)) {
+			if((int)sig->confidence > best) best = (int)sig->confidence;
+		}
+	}
+	return best;
+}
+
+// If use_index is set, modules with signatures are only considered if one of
+// their signatures matched. Otherwise, every module's identify_fn is called,
+// and signatures are evaluated one at a time. In that case, *bad_sig_module
+// is set to the first module whose signatures are inconsistent with the index
+// or with its identify_fn.
+static struct deark_module_info *detect_module_internal(deark *c, int use_index,
+	int *errflag, struct deark_module_info **bad_sig_module)
 {
 	int i;
 	int result;
 	int orig_errcount;
+	const int *sigresults;
 	struct deark_module_info *best_module = NULL;
 
-	*errflag = 0;
-	if(!c->detection_data) {
-		c->detection_data = de_malloc(c, sizeof(struct de_detection_data_struct));
-	}
-
 	// This value is made available to modules' identification functions, so
 	// that they can potentially skip expensive tests that cannot possibly return
 	// a high enough confidence.
 	c->detection_data->best_confidence_so_far = 0;
 
+	sigresults = de_sigindex_scan(c);
+
 	orig_errcount = c->error_count;
 	for(i=0; i<c->num_modules; i++) {
-		if(c->module_info[i].identify_fn==NULL) continue;
+		struct deark_module_info *mi = &c->module_info[i];
+		int sigresult = -1;
+
+		if(mi->identify_fn==NULL && mi->num_sigs==0) continue;
 
 		// If autodetect is disabled for this module, and its autodetect routine
 		// doesn't do anything that may be needed by other modules, don't bother
 		// to run this module's autodetection.
-		if((c->module_info[i].flags & DE_MODFLAG_DISABLEDETECT) &&
-			!(c->module_info[i].flags & DE_MODFLAG_SHAREDDETECTION))
+		if((mi->flags & DE_MODFLAG_DISABLEDETECT) &&
+			!(mi->flags & DE_MODFLAG_SHAREDDETECTION))
 		{
 			continue;
 		}
 
-		result = c->module_info[i].identify_fn(c);
+		if(mi->num_sigs>0) {
+			if(use_index) {
+				sigresult = sigresults[i];
+				if(sigresult<0) continue;
+			}
+			else {
+				sigresult = sigs_match_exhaustive(c, mi);
+				if(sigresult != sigresults[i] && !*bad_sig_module) {
+					*bad_sig_module = mi;
+				}
+			}
+		}
+
+		if(mi->identify_fn) {
+			result = mi->identify_fn(c);
 
-		if(c->error_count > orig_errcount) {
-			// Detection routines don't normally produce errors. If one does,
-			// it's probably an internal error, or other serious problem.
-			*errflag = 1;
-			return NULL;
+			if(c->error_count > orig_errcount) {
+				// Detection routines don't normally produce errors. If one does,
+				// it's probably an internal error, or other serious problem.
+				*errflag = 1;
+				return NULL;
+			}
+
+			if(!use_index && mi->num_sigs>0 && sigresult<0 && result>0 &&
+				!*bad_sig_module)
+			{
+				*bad_sig_module = mi;
+			}
+		}
+		else {
+			result = (sigresult<0) ? 0 : sigresult;
 		}
 
-		if(c->module_info[i].flags & DE_MODFLAG_DISABLEDETECT) {
+		if(mi->flags & DE_MODFLAG_DISABLEDETECT) {
 			// Ignore results of autodetection.
 			continue;
 		}
@@ -67,13 +117,51 @@ static struct deark_module_info *detect_module_for_file(deark *c, int *errflag)
 
 		// This is the best result so far.
 		c->detection_data->best_confidence_so_far = result;
-		best_module = &c->module_info[i];
+		best_module = mi;
 		if(c->detection_data->best_confidence_so_far>=100) break;
 	}
 
 	return best_module;
 }
 
+// Returns the best module to use, by looking at the file contents, etc.
+static struct deark_module_info *detect_module_for_file(deark *c, int *errflag)
+{
+	struct deark_module_info *best_module;
+	struct deark_module_info *best_module_exh;
+	struct deark_module_info *bad_sig_module = NULL;
+
+	*errflag = 0;
+	if(!c->detection_data) {
+		c->detection_data = de_malloc(c, sizeof(struct de_detection_data_struct));
+	}
+
+	best_module = detect_module_internal(c, 1, errflag, &bad_sig_module);
+	if(*errflag || !c->detect_verify) goto done;
+
+	// Check that the index gives the same answer as calling everything.
+	best_module_exh = detect_module_internal(c, 0, errflag, &bad_sig_module);
+	if(*errflag) goto done;
+	if(bad_sig_module) {
+		de_internal_err_nonfatal(c, "Signatures for module %s do not agree with "
+			"its identify function", bad_sig_module->id);
+	}
+	if(best_module_exh != best_module) {
+		de_internal_err_nonfatal(c, "Indexed detection chose %s, exhaustive "
+			"detection chose %s",
+			best_module ? best_module->id : "(none)",
+			best_module_exh ? best_module_exh->id : "(none)");
+	}
+	else {
+		de_dbg(c, "detection verified: %s",
+			best_module ? best_module->id : "(none)");
+	}
+	best_module = best_module_exh;
+
+done:
+	return best_module;
+}
+
 struct sort_data_struct {
 	deark *c;
 	int module_index;
@@ -261,6 +349,7 @@ int de_run(deark *c)
 	int subdirs_opt;
 	int keepdirentries_opt;
 	int tmp_opt;
+	const char *s_opt;
 	de_module_params *mparams = NULL;
 	de_ucstring *friendly_infn = NULL;
 
@@ -311,6 +400,44 @@ int de_run(deark *c)
 	}
 	de_dbg(c, "Input file: %s", ucstring_getpsz_d(friendly_infn));
 
+	if(de_get_ext_option_bool(c, "mmap", 1)==0) {
+		c->disable_mmap = 1;
+	}
+
+	if(de_get_ext_option_bool(c, "zerocopy", 1)==0) {
+		c->disable_zerocopy = 1;
+	}
+
+	if(de_get_ext_option_bool(c, "detect:verify", 0)) {
+		c->detect_verify = 1;
+	}
+
+	if(de_get_ext_option_bool(c, "cmpr:threads", 0)>0) {
+		c->dfilter_threads = 1;
+	}
+
+	s_opt = de_get_ext_option(c, "iocache");
+	if(s_opt) {
+		// The size is in KiB.
+		c->iocache_size = de_atoi64(s_opt) * 1024;
+	}
+
+	s_opt = de_get_ext_option(c, "inputmem");
+	if(s_opt) {
+		// The size is in MiB.
+		c->input_mem_limit = de_atoi64(s_opt) * 1048576;
+	}
+
+	s_opt = de_get_ext_option(c, "obufsize");
+	if(s_opt) {
+		// The size is in KiB.
+		c->obuf_max_size = de_atoi64(s_opt) * 1024;
+		if(c->obuf_max_size<0) c->obuf_max_size = 0;
+		if(c->obuf_max_size>0 && c->obuf_max_size<DE_MIN_OBUF_MAX_SIZE) {
+			c->obuf_max_size = DE_MIN_OBUF_MAX_SIZE;
+		}
+	}
+
 	if(c->input_style==DE_INPUTSTYLE_STDIN) {
 		orig_ifile = dbuf_open_input_stdin(c);
 	}
@@ -435,8 +562,6 @@ int de_run(deark *c)
 	}
 
 	if(c->output_style==DE_OUTPUTSTYLE_ARCHIVE) {
-		const char *s_opt;
-
 		s_opt = de_get_ext_option(c, "archive:timestamp");
 		if(s_opt) {
 			c->reproducible_output = 1;
@@ -465,6 +590,15 @@ int de_run(deark *c)
 	if(de_get_ext_option_bool(c, "oinfo", 0)) {
 		c->enable_oinfo = 1;
 	}
+	s_opt = de_get_ext_option(c, "oinfo:digests");
+	if(s_opt) {
+		c->enable_oinfo = 1;
+		c->oinfo_digests = de_parse_digest_list(c, s_opt);
+	}
+	if(c->enable_oinfo) {
+		// CRC-32 is always reported
+		c->oinfo_digests |= DE_DIGEST_CRC32;
+	}
 
 	tmp_opt = de_get_ext_option_bool(c, "wbuffer", -1);
 	if(tmp_opt>0) {
@@ -523,6 +657,9 @@ int de_run(deark *c)
 	}
 
 done:
+	if(c->num_output_write_calls) {
+		de_dbg2(c, "physical writes to output files: %"I64_FMT, c->num_output_write_calls);
+	}
 	if(c->extrlist_dbuf) { dbuf_close(c->extrlist_dbuf); c->extrlist_dbuf=NULL; }
 	ucstring_destroy(friendly_infn);
 	if(subfile) dbuf_close(subfile);
@@ -548,9 +685,13 @@ deark *de_create_internal(void)
 	c->max_image_dimension = DE_DEFAULT_MAX_IMAGE_DIMENSION;
 	c->max_output_file_size = DE_DEFAULT_MAX_FILE_SIZE;
 	c->max_total_output_size = DE_DEFAULT_MAX_TOTAL_OUTPUT_SIZE;
+	c->iocache_size = DE_DEFAULT_IOCACHE_SIZE;
+	c->input_mem_limit = DE_DEFAULT_INPUT_MEM_LIMIT;
+	c->obuf_max_size = DE_DEFAULT_OBUF_MAX_SIZE;
 	c->current_time.is_valid = 0;
 	c->can_decode_fltpt = -1; // = unknown
 	c->host_is_le = -1; // = unknown
+	c->crc32_impl = -1; // = unknown
 	c->input_encoding = DE_ENCODING_UNKNOWN;
 	return c;
 }
@@ -572,6 +713,9 @@ void de_destroy(deark *c)
 	if(c->output_archive_filename) { de_free(c, c->output_archive_filename); }
 	if(c->extrlist_filename) { de_free(c, c->extrlist_filename); }
 	if(c->detection_data) { de_free(c, c->detection_data); }
+	de_sigindex_destroy(c);
+	de_arena_destroy(c->module_arena);
+	de_objpool_destroy(c);
 	de_free(c, c->module_info);
 	de_free(NULL,c);
 }
@@ -9,6 +9,21 @@
 #include "deark-private.h"
 #include "deark-version.h"
 
+#ifdef __SSE2__
+#define DE_SUM_SSE2
+#include <emmintrin.h>
+#endif
+
+#if DE_USE_CRC32_ACCEL && defined(__x86_64__)
+#define DE_CRC32_PCLMUL
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#elif DE_USE_CRC32_ACCEL && defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define DE_CRC32_ARMV8
+#include <arm_acle.h>
+#endif
+
 #define DE_MAX_SUBMODULE_NESTING_LEVEL 10
 
 char *de_get_version_string(char *buf, size_t bufsize)
@@ -815,6 +830,321 @@ void de_free(deark *c, void *m)
 	free(m);
 }
 
+#define DE_OBJPOOL_MAX_ITEMS 32
+#define DE_OBJPOOL_MAX_BYTES (16*1048576)
+
+struct de_objpool_item {
+	UI objtype;
+	i64 size;
+	void *obj;
+	de_objpool_destroy_fn destroy_fn; // NULL = de_free()
+};
+
+struct de_objpool {
+	UI num_items;
+	i64 total_size;
+	struct de_objpool_item items[DE_OBJPOOL_MAX_ITEMS];
+};
+
+static void objpool_destroy_item(deark *c, struct de_objpool_item *item)
+{
+	if(item->destroy_fn) {
+		item->destroy_fn(c, item->obj);
+	}
+	else {
+		de_free(c, item->obj);
+	}
+}
+
+// Removes an object of the given type from the pool, and returns it, or NULL
+// if there are none.
+// size: Must match the size given to de_objpool_put(). For objects whose size
+// doesn't matter, use 0.
+// The caller is responsible for resetting the object's state.
+void *de_objpool_get(deark *c, UI objtype, i64 size)
+{
+	struct de_objpool *op;
+	UI i;
+	void *obj;
+
+	if(!c || c->objpool_disabled || !c->objpool) return NULL;
+	op = c->objpool;
+
+	// Search from the end, so we're likely to get a recently-used object.
+	for(i=op->num_items; i>0; i--) {
+		struct de_objpool_item *item = &op->items[i-1];
+
+		if(item->objtype!=objtype || item->size!=size) continue;
+
+		obj = item->obj;
+		op->total_size -= size;
+		op->num_items--;
+		if(i-1 < op->num_items) {
+			de_memmove(item, &op->items[i], (op->num_items-(i-1))*sizeof(struct de_objpool_item));
+		}
+		return obj;
+	}
+	return NULL;
+}
+
+// Gives obj to the pool, instead of destroying it.
+// If the pool is full, obj may be destroyed immediately, or another object
+// may be destroyed to make room.
+// destroy_fn: The function to destroy obj with, or NULL to use de_free().
+void de_objpool_put(deark *c, UI objtype, i64 size, void *obj,
+	de_objpool_destroy_fn destroy_fn)
+{
+	struct de_objpool *op;
+	struct de_objpool_item *item;
+
+	if(!obj) return;
+	if(!c || c->objpool_disabled || size<0 || size>DE_OBJPOOL_MAX_BYTES) {
+		goto destroy_now;
+	}
+
+	if(!c->objpool) {
+		c->objpool = de_malloc(c, sizeof(struct de_objpool));
+	}
+	op = c->objpool;
+
+	// Make room, by evicting the oldest objects.
+	while(op->num_items>0 && (op->num_items>=DE_OBJPOOL_MAX_ITEMS ||
+		op->total_size+size>DE_OBJPOOL_MAX_BYTES))
+	{
+		objpool_destroy_item(c, &op->items[0]);
+		op->total_size -= op->items[0].size;
+		op->num_items--;
+		de_memmove(&op->items[0], &op->items[1], op->num_items*sizeof(struct de_objpool_item));
+	}
+
+	item = &op->items[op->num_items++];
+	item->objtype = objtype;
+	item->size = size;
+	item->obj = obj;
+	item->destroy_fn = destroy_fn;
+	op->total_size += size;
+	return;
+
+destroy_now:
+	if(destroy_fn) {
+		destroy_fn(c, obj);
+	}
+	else {
+		de_free(c, obj);
+	}
+}
+
+void de_objpool_destroy(deark *c)
+{
+	struct de_objpool *op;
+	UI i;
+
+	if(!c || !c->objpool) return;
+	op = c->objpool;
+	for(i=0; i<op->num_items; i++) {
+		objpool_destroy_item(c, &op->items[i]);
+	}
+	de_free(c, op);
+	c->objpool = NULL;
+}
+
+// Like de_malloc(), but reuses a memory block from the pool if possible.
+// Unless DE_POOLFLAG_NOZERO is set, the memory is zeroed.
+// Free it with de_pool_free(), using the same objtype and size.
+void *de_pool_malloc(deark *c, UI objtype, i64 size, UI flags)
+{
+	void *m;
+
+	m = de_objpool_get(c, objtype, size);
+	if(m) {
+		if(!(flags & DE_POOLFLAG_NOZERO)) {
+			de_zeromem(m, (size_t)size);
+		}
+		return m;
+	}
+	return de_malloc(c, size);
+}
+
+void de_pool_free(deark *c, UI objtype, i64 size, void *m)
+{
+	de_objpool_put(c, objtype, size, m, NULL);
+}
+
+// An arena (region) allocator, for small objects that all have about the same
+// lifetime. Memory is handed out from large blocks, and is only released in
+// bulk, by de_arena_reset() or de_arena_destroy().
+
+#define DE_ARENA_DFLT_BLKSIZE 4096
+#define DE_ARENA_ALIGN 16
+
+struct de_arena_block {
+	struct de_arena_block *next;
+	i64 size; // Bytes available after the header
+	i64 used;
+};
+
+// Size of the block header, rounded up so that the data is aligned.
+#define DE_ARENA_HDRSIZE \
+	((i64)((sizeof(struct de_arena_block)+DE_ARENA_ALIGN-1) & ~(size_t)(DE_ARENA_ALIGN-1)))
+
+struct de_arena {
+	deark *c;
+	i64 blksize;
+	struct de_arena_block *first; // The block that survives de_arena_reset()
+	struct de_arena_block *cur; // The block we're currently allocating from
+	u8 *last_alloc; // For extending the most recent allocation in place
+	i64 last_alloc_size;
+};
+
+static u8 *arena_blk_data(struct de_arena_block *blk)
+{
+	return ((u8*)blk) + DE_ARENA_HDRSIZE;
+}
+
+static struct de_arena_block *arena_new_block(struct de_arena *a, i64 size)
+{
+	struct de_arena_block *blk;
+
+	blk = de_malloc(a->c, DE_ARENA_HDRSIZE + size);
+	blk->size = size;
+	return blk;
+}
+
+// blksize: The usual size of the blocks to allocate; 0 for the default.
+struct de_arena *de_arena_create(deark *c, i64 blksize)
+{
+	struct de_arena *a;
+
+	if(blksize<=0) blksize = DE_ARENA_DFLT_BLKSIZE;
+	a = de_malloc(c, sizeof(struct de_arena));
+	a->c = c;
+	a->blksize = blksize;
+	a->first = arena_new_block(a, blksize);
+	a->cur = a->first;
+	return a;
+}
+
+// Memory returned is always zeroed, and is suitably aligned for any type.
+// It must not be freed individually.
+void *de_arena_malloc(struct de_arena *a, i64 n)
+{
+	struct de_arena_block *blk;
+	u8 *m;
+
+	if(n<1) n = 1;
+	if(n > DE_MAX_MALLOC) {
+		// Let de_malloc() report the error
+		return de_malloc(a->c, n);
+	}
+	n = (n+DE_ARENA_ALIGN-1) & ~(i64)(DE_ARENA_ALIGN-1);
+
+	blk = a->cur;
+	if(blk->used + n > blk->size) {
+		if(n > a->blksize/4) {
+			// Large allocations get a block of their own, inserted after
+			// the current block, so the rest of the current block isn't
+			// wasted.
+			blk = arena_new_block(a, n);
+			blk->next = a->cur->next;
+			a->cur->next = blk;
+		}
+		else {
+			blk = arena_new_block(a, a->blksize);
+			blk->next = a->cur->next;
+			a->cur->next = blk;
+			a->cur = blk;
+		}
+	}
+
+	m = arena_blk_data(blk) + blk->used;
+	blk->used += n;
+	// The first block is reused after a reset, so may not be zeroed.
+	if(blk==a->first) {
+		de_zeromem(m, (size_t)n);
+	}
+	a->last_alloc = m;
+	a->last_alloc_size = n;
+	return m;
+}
+
+// Change the size of memory that was allocated by de_arena_malloc().
+// The most recent allocation is extended in place if possible. Otherwise, the
+// contents are copied to new memory, and the old memory is wasted until the
+// arena is reset.
+// Any new memory is zeroed.
+void *de_arena_realloc(struct de_arena *a, void *m, i64 oldsize, i64 newsize)
+{
+	u8 *newm;
+
+	if(!m) return de_arena_malloc(a, newsize);
+	if(newsize<=oldsize) return m;
+
+	if((u8*)m==a->last_alloc && newsize<=a->last_alloc_size) {
+		de_zeromem(&a->last_alloc[oldsize], (size_t)(newsize-oldsize));
+		return m;
+	}
+
+	if((u8*)m==a->last_alloc && a->cur->used>=a->last_alloc_size &&
+		arena_blk_data(a->cur)+a->cur->used-a->last_alloc_size == a->last_alloc)
+	{
+		i64 n;
+
+		n = (newsize+DE_ARENA_ALIGN-1) & ~(i64)(DE_ARENA_ALIGN-1);
+		if(a->cur->used - a->last_alloc_size + n <= a->cur->size) {
+			a->cur->used += n - a->last_alloc_size;
+			a->last_alloc_size = n;
+			de_zeromem(&a->last_alloc[oldsize], (size_t)(newsize-oldsize));
+			return m;
+		}
+	}
+
+	newm = de_arena_malloc(a, newsize);
+	de_memcpy(newm, m, (size_t)oldsize);
+	return newm;
+}
+
+// Release everything allocated from the arena, but keep the arena (and its
+// first block) for reuse.
+void de_arena_reset(struct de_arena *a)
+{
+	struct de_arena_block *blk;
+	struct de_arena_block *next;
+
+	if(!a) return;
+	blk = a->first->next;
+	while(blk) {
+		next = blk->next;
+		de_free(a->c, blk);
+		blk = next;
+	}
+	a->first->next = NULL;
+	a->first->used = 0;
+	a->cur = a->first;
+	a->last_alloc = NULL;
+	a->last_alloc_size = 0;
+}
+
+void de_arena_destroy(struct de_arena *a)
+{
+	deark *c;
+
+	if(!a) return;
+	c = a->c;
+	de_arena_reset(a);
+	de_free(c, a->first);
+	de_free(c, a);
+}
+
+// Returns an arena whose memory will be released when the currently-running
+// module finishes. Created on first use.
+struct de_arena *de_get_module_arena(deark *c)
+{
+	if(!c->module_arena) {
+		c->module_arena = de_arena_create(c, 0);
+	}
+	return c->module_arena;
+}
+
 // Returns the index into c->module_info[], or -1 if no found.
 int de_get_module_idx_by_id(deark *c, const char *module_id)
 {
@@ -846,11 +1176,199 @@ struct deark_module_info *de_get_module_by_id(deark *c, const char *module_id)
 	return &c->module_info[idx];
 }
 
+// The module signature index has a table for each distinct signature offset,
+// which maps the first byte of a signature to a chain of candidate signatures.
+// It is filled in as the modules are registered.
+// Entry numbers are 1-based, so that 0 (the state of freshly allocated memory)
+// means "none".
+
+// Signatures that end within this many bytes of the start of the file are
+// checked using a single read.
+#define DE_SIGIDX_HEAD_SIZE 2048
+
+struct de_sigidx_entry {
+	const struct de_module_sig *sig;
+	int module_idx;
+	u16 next;
+};
+
+struct de_sigidx_root {
+	i64 pos;
+	i64 maxlen;
+	u16 first[256];
+};
+
+struct de_sigindex {
+	int num_roots, roots_alloc;
+	int num_entries, entries_alloc;
+	i64 head_len; // Number of bytes at the start of the file to read at once
+	struct de_sigidx_root *roots; // roots[0] is for offset 0
+	struct de_sigidx_entry *entries; // entries[0] is unused
+	int *sigresult;
+};
+
+static struct de_sigindex *sigidx_create(deark *c)
+{
+	struct de_sigindex *idx;
+
+	idx = de_malloc(c, sizeof(struct de_sigindex));
+	idx->roots_alloc = 8;
+	idx->roots = de_mallocarray(c, idx->roots_alloc, sizeof(struct de_sigidx_root));
+	idx->num_roots = 1;
+	idx->entries_alloc = 128;
+	idx->entries = de_mallocarray(c, idx->entries_alloc, sizeof(struct de_sigidx_entry));
+	return idx;
+}
+
+static struct de_sigidx_root *sigidx_get_root(deark *c, struct de_sigindex *idx,
+	i64 pos)
+{
+	int i;
+
+	for(i=0; i<idx->num_roots; i++) {
+		if(idx->roots[i].pos==pos) return &idx->roots[i];
+	}
+	if(idx->num_roots >= idx->roots_alloc) {
+		idx->roots = de_reallocarray(c, idx->roots, idx->roots_alloc,
+			sizeof(struct de_sigidx_root), (i64)idx->roots_alloc*2);
+		idx->roots_alloc *= 2;
+	}
+	idx->roots[idx->num_roots].pos = pos;
+	return &idx->roots[idx->num_roots++];
+}
+
+static void sigidx_add_sig(deark *c, struct de_sigindex *idx, int module_idx,
+	const struct de_module_sig *sig)
+{
+	struct de_sigidx_root *r;
+	struct de_sigidx_entry *e;
+	u8 b0;
+
+	if(sig->len<1 || sig->len>DE_MAX_MODULE_SIG_LEN || !sig->bytes) {
+		de_internal_err_fatal(c, "Bad signature for module %s",
+			c->module_info[module_idx].id);
+		return;
+	}
+	if(idx->num_entries+1 >= idx->entries_alloc) {
+		if(idx->entries_alloc >= 0x8000) {
+			de_internal_err_fatal(c, "Too many module signatures");
+			return;
+		}
+		idx->entries = de_reallocarray(c, idx->entries, idx->entries_alloc,
+			sizeof(struct de_sigidx_entry), (i64)idx->entries_alloc*2);
+		idx->entries_alloc *= 2;
+	}
+
+	r = (sig->pos==0) ? &idx->roots[0] : sigidx_get_root(c, idx, (i64)sig->pos);
+	if((i64)sig->len > r->maxlen) r->maxlen = (i64)sig->len;
+	if(r->pos + r->maxlen <= DE_SIGIDX_HEAD_SIZE && r->pos + r->maxlen > idx->head_len) {
+		idx->head_len = r->pos + r->maxlen;
+	}
+
+	b0 = (u8)sig->bytes[0];
+	idx->num_entries++;
+	e = &idx->entries[idx->num_entries];
+	e->sig = sig;
+	e->module_idx = module_idx;
+	e->next = r->first[b0];
+	r->first[b0] = (u16)idx->num_entries;
+}
+
+// Called when a module is registered.
+void de_sigindex_add_module(deark *c, int module_idx)
+{
+	const struct deark_module_info *mi = &c->module_info[module_idx];
+	int k;
+
+	if(mi->num_sigs<1) return;
+	if((mi->flags & DE_MODFLAG_DISABLEDETECT) &&
+		!(mi->flags & DE_MODFLAG_SHAREDDETECTION))
+	{
+		return;
+	}
+
+	if(!c->sigindex) {
+		c->sigindex = sigidx_create(c);
+	}
+	for(k=0; k<mi->num_sigs; k++) {
+		sigidx_add_sig(c, c->sigindex, module_idx, &mi->sigs[k]);
+	}
+}
+
+// Checks every indexed signature against c->infile.
+// Returns an array indexed by module: -1 if none of the module's signatures
+// matched, otherwise the best confidence of the ones that did.
+// The array remains valid until the next call, or until c is destroyed.
+const int *de_sigindex_scan(deark *c)
+{
+	struct de_sigindex *idx;
+	u8 buf[DE_MAX_MODULE_SIG_LEN];
+	u8 headbuf[DE_SIGIDX_HEAD_SIZE];
+	const u8 *head;
+	int i;
+
+	if(!c->sigindex) {
+		c->sigindex = sigidx_create(c);
+	}
+	idx = c->sigindex;
+	if(!idx->sigresult) {
+		idx->sigresult = de_mallocarray(c, c->num_modules, sizeof(int));
+	}
+
+	for(i=0; i<c->num_modules; i++) {
+		idx->sigresult[i] = -1;
+	}
+
+	// Bytes past the end of the file read as 0, the same as they do for
+	// dbuf_memcmp().
+	head = dbuf_get_span(c->infile, 0, idx->head_len, headbuf);
+
+	for(i=0; i<idx->num_roots; i++) {
+		const struct de_sigidx_root *r = &idx->roots[i];
+		const u8 *fdata;
+		UI n;
+
+		if(r->maxlen<1) continue;
+		if(r->pos + r->maxlen <= idx->head_len) {
+			fdata = &head[r->pos];
+		}
+		else {
+			fdata = dbuf_get_span(c->infile, r->pos, r->maxlen, buf);
+		}
+
+		for(n=r->first[fdata[0]]; n; n=idx->entries[n].next) {
+			const struct de_sigidx_entry *e = &idx->entries[n];
+
+			if(de_memcmp(&fdata[1], &e->sig->bytes[1], (size_t)e->sig->len-1)) {
+				continue;
+			}
+			if((int)e->sig->confidence > idx->sigresult[e->module_idx]) {
+				idx->sigresult[e->module_idx] = (int)e->sig->confidence;
+			}
+		}
+	}
+
+	return idx->sigresult;
+}
+
+void de_sigindex_destroy(deark *c)
+{
+	struct de_sigindex *idx = c->sigindex;
+
+	if(!idx) return;
+	de_free(c, idx->roots);
+	de_free(c, idx->entries);
+	de_free(c, idx->sigresult);
+	de_free(c, idx);
+	c->sigindex = NULL;
+}
+
 int de_run_module(deark *c, struct deark_module_info *mi, de_module_params *mparams,
 	enum de_moddisp_enum moddisp)
 {
 	enum de_moddisp_enum old_moddisp;
 	struct de_detection_data_struct *old_detection_data;
+	struct de_arena *old_module_arena;
 
 	if(!mi) return 0;
 	if(!mi->run_fn) {
@@ -880,9 +1398,13 @@ int de_run_module(deark *c, struct deark_module_info *mi, de_module_params *mpar
 	if(c->module_nesting_level>0 && c->debug_level>=3) {
 		de_dbg3(c, "[using %s module]", mi->id);
 	}
+	old_module_arena = c->module_arena;
+	c->module_arena = NULL;
 	c->module_nesting_level++;
 	mi->run_fn(c, mparams);
 	c->module_nesting_level--;
+	de_arena_destroy(c->module_arena);
+	c->module_arena = old_module_arena;
 	c->module_disposition = old_moddisp;
 	c->detection_data = old_detection_data;
 	return 1;
@@ -1151,12 +1673,24 @@ de_finfo *de_finfo_create(deark *c)
 	return fi;
 }
 
+// Like de_finfo_create(), but the finfo struct is allocated from arena 'a'.
+// It should still be destroyed with de_finfo_destroy(), before the arena is
+// reset, because the strings that get attached to it are not necessarily in
+// the arena.
+de_finfo *de_finfo_create_in_arena(deark *c, struct de_arena *a)
+{
+	de_finfo *fi;
+	fi = de_arena_malloc(a, sizeof(de_finfo));
+	fi->arena = a;
+	return fi;
+}
+
 void de_finfo_destroy(deark *c, de_finfo *fi)
 {
 	if(!fi) return;
 	if(fi->file_name_internal) ucstring_destroy(fi->file_name_internal);
 	if(fi->name_other) ucstring_destroy(fi->name_other);
-	de_free(c, fi);
+	if(!fi->arena) de_free(c, fi);
 }
 
 static i32 de_char_to_valid_fn_char(deark *c, i32 ch)
@@ -1918,19 +2452,27 @@ struct de_crcobj {
 	UI crctype;
 	UI align;
 	deark *c;
-	u16 *table16;
+	const u16 *table16; // Static slicing-by-4 tables, for CRC-16 types
+	UI crc32_impl;
 };
 
 #define DE_CRC32_INIT 0
 
-// crc32_calc() is based on public domain code by Jon Mayo, downloaded
+#define DE_CRC32IMPL_NIBBLE 0
+#define DE_CRC32IMPL_SLICE8 1
+#define DE_CRC32IMPL_PCLMUL 2
+#define DE_CRC32IMPL_ARMV8  3
+
+// crc32_calc_nibble() is based on public domain code by Jon Mayo, downloaded
 // from <http://orangetide.com/code/crc.c>.
 // It includes minor changes for Deark. I disclaim any copyright on these
 // minor changes. -JS
 // Note: I have found several other seemingly-independent implementations
 // of the same algorithm, such as the one by Karl Malbrain, used in miniz.
 // I don't know its origin.
-static u32 crc32_calc(const u8 *ptr, size_t cnt, u32 crc)
+// This is the reference implementation. It's slow, but simple enough to
+// trust, so the other implementations are tested against it.
+static u32 crc32_calc_nibble(const u8 *ptr, size_t cnt, u32 crc)
 {
 	static const u32 crc32_tab[16] = {
 		0x00000000U, 0x1db71064U, 0x3b6e20c8U, 0x26d930acU,
@@ -1948,103 +2490,369 @@ static u32 crc32_calc(const u8 *ptr, size_t cnt, u32 crc)
 	return ~crc;
 }
 
-// For a one-shot CRC calculations, or the first part of a multi-part
-// calculation.
-// buf can be NULL (in which case buf_len should be 0, but is ignored)
-static u32 de_crc32(const void *buf, i64 buf_len)
+// Slicing-by-8: Processes 8 bytes at a time, using 8 lookup tables whose
+// lookups are independent of each other.
+// Unlike crc32_calc_nibble(), this works on the inverted CRC.
+static u32 crc32_slice8_inv(const u8 *ptr, size_t cnt, u32 crc)
+{
+	const u32 *t = de_get_crc32_slice8_tables_ptr();
+
+	while(cnt>=8) {
+		u32 lo, hi;
+
+		lo = crc ^ ((u32)ptr[0] | ((u32)ptr[1]<<8) | ((u32)ptr[2]<<16) |
+			((u32)ptr[3]<<24));
+		hi = (u32)ptr[4] | ((u32)ptr[5]<<8) | ((u32)ptr[6]<<16) |
+			((u32)ptr[7]<<24);
+		crc = t[7*256 + (lo & 0xff)] ^ t[6*256 + ((lo>>8) & 0xff)] ^
+			t[5*256 + ((lo>>16) & 0xff)] ^ t[4*256 + (lo>>24)] ^
+			t[3*256 + (hi & 0xff)] ^ t[2*256 + ((hi>>8) & 0xff)] ^
+			t[1*256 + ((hi>>16) & 0xff)] ^ t[hi>>24];
+		ptr += 8;
+		cnt -= 8;
+	}
+
+	while(cnt--) {
+		crc = (crc >> 8) ^ t[(crc ^ *ptr++) & 0xff];
+	}
+	return crc;
+}
+
+static u32 crc32_calc_slice8(const u8 *ptr, size_t cnt, u32 crc)
+{
+	return ~crc32_slice8_inv(ptr, cnt, ~crc);
+}
+
+#ifdef DE_CRC32_PCLMUL
+
+// CRC-32 by "folding" with carry-less multiplication, as described in Intel's
+// paper "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+// Instruction". The constants are for the bit-reflected IEEE polynomial.
+// cnt must be a multiple of 16, and at least 64.
+// Works on the inverted CRC.
+__attribute__((target("pclmul,sse2")))
+static u32 crc32_pclmul_fold_inv(const u8 *ptr, size_t cnt, u32 crc)
+{
+	static const u64 k1k2[2] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+	static const u64 k3k4[2] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+	static const u64 k5k0[2] = { 0x0163cd6124ULL, 0x0000000000ULL };
+	static const u64 poly[2] = { 0x01db710641ULL, 0x01f7011641ULL };
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+	__m128i y5, y6, y7, y8;
+
+	x1 = _mm_loadu_si128((const __m128i*)(ptr + 0x00));
+	x2 = _mm_loadu_si128((const __m128i*)(ptr + 0x10));
+	x3 = _mm_loadu_si128((const __m128i*)(ptr + 0x20));
+	x4 = _mm_loadu_si128((const __m128i*)(ptr + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	x0 = _mm_loadu_si128((const __m128i*)k1k2);
+	ptr += 64;
+	cnt -= 64;
+
+	// Fold 64 bytes at a time, in 4 parallel streams
+	while(cnt>=64) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+		y5 = _mm_loadu_si128((const __m128i*)(ptr + 0x00));
+		y6 = _mm_loadu_si128((const __m128i*)(ptr + 0x10));
+		y7 = _mm_loadu_si128((const __m128i*)(ptr + 0x20));
+		y8 = _mm_loadu_si128((const __m128i*)(ptr + 0x30));
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+		ptr += 64;
+		cnt -= 64;
+	}
+
+	// Fold the 4 streams into one
+	x0 = _mm_loadu_si128((const __m128i*)k3k4);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	// Fold any remaining 16-byte blocks
+	while(cnt>=16) {
+		x2 = _mm_loadu_si128((const __m128i*)ptr);
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+		ptr += 16;
+		cnt -= 16;
+	}
+
+	// Reduce 128 bits to 64
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, x2);
+	x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, x3);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Barrett reduction to 32 bits
+	x0 = _mm_loadu_si128((const __m128i*)poly);
+	x2 = _mm_and_si128(x1, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	return (u32)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+static u32 crc32_calc_pclmul(const u8 *ptr, size_t cnt, u32 crc)
+{
+	crc = ~crc;
+	if(cnt>=64) {
+		size_t n = cnt & ~(size_t)15;
+
+		crc = crc32_pclmul_fold_inv(ptr, n, crc);
+		ptr += n;
+		cnt -= n;
+	}
+	crc = crc32_slice8_inv(ptr, cnt, crc);
+	return ~crc;
+}
+
+static int crc32_pclmul_is_supported(void)
 {
-	if(!buf) return DE_CRC32_INIT;
-	return (u32)crc32_calc((const u8*)buf, (size_t)buf_len, DE_CRC32_INIT);
+	unsigned int eax, ebx, ecx, edx;
+
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+	return (ecx & bit_PCLMUL) ? 1 : 0;
 }
 
-static u32 de_crc32_continue(u32 prev_crc, const void *buf, i64 buf_len)
+#endif // DE_CRC32_PCLMUL
+
+#ifdef DE_CRC32_ARMV8
+
+// Uses the ARMv8 CRC32 instructions. This is only compiled if the compiler
+// is targeting a CPU that is known to have them.
+static u32 crc32_calc_armv8(const u8 *ptr, size_t cnt, u32 crc)
 {
-	return (u32)crc32_calc((const u8*)buf, (size_t)buf_len, prev_crc);
+	crc = ~crc;
+	while(cnt>=8) {
+		u64 v;
+
+		de_memcpy(&v, ptr, 8);
+		crc = __crc32d(crc, v);
+		ptr += 8;
+		cnt -= 8;
+	}
+	while(cnt--) {
+		crc = __crc32b(crc, *ptr++);
+	}
+	return ~crc;
 }
 
-static void adler32_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
+#endif // DE_CRC32_ARMV8
+
+static u32 crc32_calc_by_impl(UI impl, const u8 *ptr, size_t cnt, u32 crc)
 {
-	u32 s1 = crco->val & 0xffff;
-	u32 s2 = (crco->val >> 16) & 0xffff;
-	i64 i;
+	if(cnt==0) return crc;
 
-	for(i = 0; i<buf_len; i++) {
-		s1 = (s1 + buf[i]) % 65521;
-		s2 = (s2 + s1) % 65521;
+	switch(impl) {
+#ifdef DE_CRC32_PCLMUL
+	case DE_CRC32IMPL_PCLMUL:
+		return crc32_calc_pclmul(ptr, cnt, crc);
+#endif
+#ifdef DE_CRC32_ARMV8
+	case DE_CRC32IMPL_ARMV8:
+		return crc32_calc_armv8(ptr, cnt, crc);
+#endif
+	case DE_CRC32IMPL_SLICE8:
+		return crc32_calc_slice8(ptr, cnt, crc);
 	}
-	crco->val = (s2 << 16) + s1;
+	return crc32_calc_nibble(ptr, cnt, crc);
+}
+
+// Returns the fastest implementation this CPU supports.
+static UI crc32_detect_impl(void)
+{
+#ifdef DE_CRC32_PCLMUL
+	if(crc32_pclmul_is_supported()) return DE_CRC32IMPL_PCLMUL;
+#endif
+#ifdef DE_CRC32_ARMV8
+	return DE_CRC32IMPL_ARMV8;
+#endif
+	return DE_CRC32IMPL_SLICE8;
+}
+
+static u32 de_crc32_continue(struct de_crcobj *crco, u32 prev_crc, const void *buf, i64 buf_len)
+{
+	return crc32_calc_by_impl(crco->crc32_impl, (const u8*)buf, (size_t)buf_len, prev_crc);
 }
 
-static void de_crc16xmodem_init(struct de_crcobj *crco)
+static void adler32_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
 {
-	const unsigned int polynomial = 0x1021;
-	unsigned int index;
+	u32 s1 = crco->val & 0xffff;
+	u32 s2 = (crco->val >> 16) & 0xffff;
+
+	while(buf_len>0) {
+		// 5552 is the most bytes we can process before s2 could overflow,
+		// so we only have to do the modulo operation once per 5552 bytes.
+		i64 n = de_min_int(buf_len, 5552);
+		i64 i;
 
-	crco->table16 = de_mallocarray(crco->c, 256, sizeof(u16));
-	crco->table16[0] = 0;
-	for(index=0; index<128; index++) {
-		unsigned int carry = crco->table16[index] & 0x8000;
-		unsigned int temp = (crco->table16[index] << 1) & 0xffff;
-		crco->table16[index * 2 + (carry ? 0 : 1)] = temp ^ polynomial;
-		crco->table16[index * 2 + (carry ? 1 : 0)] = temp;
+		for(i=0; i<n; i++) {
+			s1 += buf[i];
+			s2 += s1;
+		}
+		s1 %= 65521;
+		s2 %= 65521;
+		buf += n;
+		buf_len -= n;
 	}
+	crco->val = (s2 << 16) + s1;
 }
 
+// Slicing-by-4 CRC-16/XMODEM (not reflected)
 static void de_crc16xmodem_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
 {
-	i64 k;
+	const u16 *t = crco->table16;
+	u32 crc = crco->val;
+
+	while(buf_len>=4) {
+		u32 x;
+
+		x = crc ^ (((u32)buf[0]<<8) | (u32)buf[1]);
+		crc = (u32)t[3*256 + (x>>8)] ^ (u32)t[2*256 + (x & 0xff)] ^
+			(u32)t[256 + buf[2]] ^ (u32)t[buf[3]];
+		buf += 4;
+		buf_len -= 4;
+	}
 
-	if(!crco->table16) return;
-	for(k=0; k<buf_len; k++) {
-		crco->val = ((crco->val<<8)&0xffff) ^
-			(u32)crco->table16[((crco->val>>8) ^ (u32)buf[k]) & 0xff];
+	while(buf_len>0) {
+		crc = ((crc<<8)&0xffff) ^ (u32)t[((crc>>8) ^ (u32)*buf) & 0xff];
+		buf++;
+		buf_len--;
 	}
+	crco->val = crc;
 }
 
-static void cksum_bytes_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
+// Slicing-by-4 for CRC-16/ARC and other reflected CRC-16s
+static void de_crc16arc_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
 {
-	i64 k;
+	const u16 *t = crco->table16;
+	u32 crc = crco->val;
 
-	for(k=0; k<buf_len; k++) {
-		crco->val += (u32)buf[k];
+	while(buf_len>=4) {
+		u32 x;
+
+		x = crc ^ ((u32)buf[0] | ((u32)buf[1]<<8));
+		crc = (u32)t[3*256 + (x & 0xff)] ^ (u32)t[2*256 + (x>>8)] ^
+			(u32)t[256 + buf[2]] ^ (u32)t[buf[3]];
+		buf += 4;
+		buf_len -= 4;
 	}
+
+	while(buf_len>0) {
+		crc = (crc>>8) ^ (u32)t[(crc ^ (u32)*buf) & 0xff];
+		buf++;
+		buf_len--;
+	}
+	crco->val = crc;
 }
 
-static void cksum_u16_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
+// Adds up the bytes at even offsets, and the bytes at odd offsets, relative
+// to buf.
+static void sum_bytes_evenodd(const u8 *buf, i64 buf_len, u64 *psum_even, u64 *psum_odd)
 {
-	i64 k;
+	u64 sum_even = 0;
+	u64 sum_odd = 0;
+	i64 i = 0;
 
-	for(k=0; k<buf_len; k++) {
-		if(crco->align) {
-			crco->val += (u32)buf[k] << 8;
+#ifdef DE_SUM_SSE2
+	if(buf_len>=16) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i evenmask = _mm_set1_epi16(0x00ff);
+		__m128i acc_even = zero;
+		__m128i acc_odd = zero;
+		u64 tmp[2];
+
+		// _mm_sad_epu8 adds up groups of 8 bytes, into two 64-bit sums.
+		for(; i+16<=buf_len; i+=16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)&buf[i]);
+
+			acc_even = _mm_add_epi64(acc_even, _mm_sad_epu8(_mm_and_si128(v, evenmask), zero));
+			acc_odd = _mm_add_epi64(acc_odd, _mm_sad_epu8(_mm_srli_epi16(v, 8), zero));
 		}
-		else {
-			crco->val += (u32)buf[k];
+		_mm_storeu_si128((__m128i*)tmp, acc_even);
+		sum_even = tmp[0] + tmp[1];
+		_mm_storeu_si128((__m128i*)tmp, acc_odd);
+		sum_odd = tmp[0] + tmp[1];
+	}
+#else
+	{
+		// Accumulate in 32-bit ints, which compilers are better at vectorizing.
+		// 2^24 pairs can't overflow them.
+		while(i+2<=buf_len) {
+			i64 n = de_min_int((buf_len-i)/2, 0x1000000);
+			u32 s_e = 0;
+			u32 s_o = 0;
+			i64 k;
+
+			for(k=0; k<n; k++) {
+				s_e += buf[i+2*k];
+				s_o += buf[i+2*k+1];
+			}
+			sum_even += s_e;
+			sum_odd += s_o;
+			i += 2*n;
 		}
-		crco->align = !crco->align;
 	}
+#endif
+
+	// Any leftover bytes. i is even here.
+	for(; i<buf_len; i++) {
+		if(i & 1) sum_odd += buf[i];
+		else sum_even += buf[i];
+	}
+
+	*psum_even = sum_even;
+	*psum_odd = sum_odd;
 }
 
-static void de_crc16arc_init(struct de_crcobj *crco, u16 poly)
+static void cksum_bytes_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
 {
-	u32 i, k;
+	u64 sum_even, sum_odd;
 
-	crco->table16 = de_mallocarray(crco->c, 256, sizeof(u16));
-	for(i=0; i<256; i++) {
-		crco->table16[i] = i;
-		for(k=0; k<8; k++)
-			crco->table16[i] = (crco->table16[i]>>1) ^ ((crco->table16[i] & 1) ? poly : 0);
-	}
+	sum_bytes_evenodd(buf, buf_len, &sum_even, &sum_odd);
+	crco->val += (u32)(sum_even + sum_odd);
 }
 
-static void de_crc16arc_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
+// crco->align is 0 if the next byte is the low byte of a 16-bit integer,
+// 1 if it is the high byte.
+static void cksum_u16_continue(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
 {
-	i64 k;
+	u64 sum_even, sum_odd;
 
-	if(!crco->table16) return;
-	for(k=0; k<buf_len; k++) {
-		crco->val = ((crco->val>>8) ^
-			(u32)crco->table16[(crco->val ^ buf[k]) & 0xff]);
+	if(buf_len<1) return;
+	if(crco->align) {
+		crco->val += (u32)buf[0] << 8;
+		buf++;
+		buf_len--;
+		crco->align = 0;
+	}
+
+	sum_bytes_evenodd(buf, buf_len, &sum_even, &sum_odd);
+	crco->val += (u32)(sum_even + (sum_odd<<8));
+	if(buf_len & 1) {
+		crco->align = 1;
 	}
 }
 
@@ -2058,21 +2866,32 @@ struct de_crcobj *de_crcobj_create(deark *c, UI type_and_flags)
 	crco->crctype = type_and_flags;
 
 	switch(crco->crctype) {
+	case DE_CRCOBJ_CRC32_IEEE:
+		if(c) {
+			if(c->crc32_impl<0) {
+				c->crc32_impl = (int)crc32_detect_impl();
+			}
+			crco->crc32_impl = (UI)c->crc32_impl;
+		}
+		else {
+			crco->crc32_impl = crc32_detect_impl();
+		}
+		break;
 	case DE_CRCOBJ_CRC16_XMODEM:
 		// This is the CRC-16 algorithm used in MacBinary.
 		// The CRC RevEng catalogue calls it "CRC-16/XMODEM".
-		de_crc16xmodem_init(crco);
+		crco->table16 = de_get_crc16_slice4_tables_ptr(crco->crctype);
 		break;
 	case DE_CRCOBJ_CRC16_ARC:
 		// This is the CRC-16 algorithm used in ARC, LHA, ZOO, etc.
 		// The CRC RevEng catalogue calls it "CRC-16/ARC".
-		de_crc16arc_init(crco, 0xa001);
+		crco->table16 = de_get_crc16_slice4_tables_ptr(crco->crctype);
 		break;
 	case DE_CRCOBJ_CRC16_IBMSDLC:
 		// This is the CRC-16 algorithm used in ar001.
 		// I'm pretty sure it is equivalent to the one the CRC RevEng catalogue
 		// calls "CRC-16/IBM-SDLC".
-		de_crc16arc_init(crco, 0x8408);
+		crco->table16 = de_get_crc16_slice4_tables_ptr(crco->crctype);
 		break;
 	}
 
@@ -2086,7 +2905,6 @@ void de_crcobj_destroy(struct de_crcobj *crco)
 
 	if(!crco) return;
 	c = crco->c;
-	de_free(c, crco->table16);
 	de_free(c, crco);
 }
 
@@ -2096,7 +2914,7 @@ void de_crcobj_reset(struct de_crcobj *crco)
 
 	switch(crco->crctype) {
 	case DE_CRCOBJ_CRC32_IEEE:
-		crco->val = de_crc32(NULL, 0);
+		crco->val = DE_CRC32_INIT;
 		break;
 	case DE_CRCOBJ_ADLER32:
 		crco->val = 1;
@@ -2128,7 +2946,7 @@ void de_crcobj_addbuf(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
 
 	switch(crco->crctype) {
 	case DE_CRCOBJ_CRC32_IEEE:
-		crco->val = de_crc32_continue(crco->val, buf, buf_len);
+		crco->val = de_crc32_continue(crco, crco->val, buf, buf_len);
 		break;
 	case DE_CRCOBJ_CRC16_XMODEM:
 		de_crc16xmodem_continue(crco, buf, buf_len);
@@ -2150,13 +2968,193 @@ void de_crcobj_addbuf(struct de_crcobj *crco, const u8 *buf, i64 buf_len)
 	}
 }
 
+// The inverse of de_crcobj_getval().
+static void crcobj_setval(struct de_crcobj *crco, u32 v)
+{
+	switch(crco->crctype) {
+	case DE_CRCOBJ_CRC16_IBMSDLC:
+		crco->val = v ^ 0xffff;
+		return;
+	}
+	crco->val = v;
+}
+
+// Multiply two polynomials modulo the CRC polynomial, over GF(2).
+// Everything is bit-reflected: the x^0 term is the high bit of a 'width'-bit
+// value, and rpoly is the reflected polynomial (without the x^width term).
+static u32 gf2_mulmodp(u32 a, u32 b, UI width, u32 rpoly)
+{
+	u32 m = (u32)1 << (width-1);
+	u32 p = 0;
+
+	while(m) {
+		if(a & m) {
+			p ^= b;
+		}
+		m >>= 1;
+		b = (b & 1) ? ((b >> 1) ^ rpoly) : (b >> 1);
+	}
+	return p;
+}
+
+// Returns x^(8*n) modulo the CRC polynomial, in the same representation as
+// gf2_mulmodp(). Takes O(log n) time.
+static u32 gf2_x8nmodp(i64 n, UI width, u32 rpoly)
+{
+	u32 p = (u32)1 << (width-1); // x^0
+	u32 sq = (u32)1 << (width-1-8); // x^8
+
+	while(n>0) {
+		if(n & 1) {
+			p = gf2_mulmodp(sq, p, width, rpoly);
+		}
+		n >>= 1;
+		if(n>0) {
+			sq = gf2_mulmodp(sq, sq, width, rpoly);
+		}
+	}
+	return p;
+}
+
+static u32 reverse16(u32 x)
+{
+	u32 r = 0;
+	UI i;
+
+	for(i=0; i<16; i++) {
+		r = (r << 1) | (x & 1);
+		x >>= 1;
+	}
+	return r;
+}
+
+// For a CRC whose initial value equals its final XOR value (as is true of
+// all the CRCs we support), CRC(A+B) = CRC(A)*x^(8*len(B)) ^ CRC(B).
+static u32 crc_combine_reflected(u32 crc1, u32 crc2, i64 len2, UI width, u32 rpoly)
+{
+	return gf2_mulmodp(gf2_x8nmodp(len2, width, rpoly), crc1, width, rpoly) ^ crc2;
+}
+
+// Based on adler32_combine() from zlib.
+static u32 adler32_combine(u32 adler1, u32 adler2, i64 len2)
+{
+	const u32 base = 65521;
+	u32 sum1, sum2, rem;
+
+	rem = (u32)(len2 % base);
+	sum1 = adler1 & 0xffff;
+	sum2 = (rem * sum1) % base;
+	sum1 += (adler2 & 0xffff) + base - 1;
+	sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + base - rem;
+	if(sum1 >= base) sum1 -= base;
+	if(sum1 >= base) sum1 -= base;
+	if(sum2 >= (base << 1)) sum2 -= (base << 1);
+	if(sum2 >= base) sum2 -= base;
+	return sum1 | (sum2 << 16);
+}
+
+static int crcobj_can_combine(struct de_crcobj *crco)
+{
+	switch(crco->crctype) {
+	case DE_CRCOBJ_CRC32_IEEE:
+	case DE_CRCOBJ_ADLER32:
+	case DE_CRCOBJ_CRC16_XMODEM:
+	case DE_CRCOBJ_CRC16_ARC:
+	case DE_CRCOBJ_CRC16_IBMSDLC:
+	case DE_CRCOBJ_SUM_BYTES:
+		return 1;
+	}
+	return 0;
+}
+
+// val1 and val2 are in the format returned by de_crcobj_getval().
+// Only valid if crcobj_can_combine() returned 1.
+static u32 crcobj_combine_vals(struct de_crcobj *crco, u32 val1, u32 val2, i64 len2)
+{
+	switch(crco->crctype) {
+	case DE_CRCOBJ_CRC32_IEEE:
+		return crc_combine_reflected(val1, val2, len2, 32, 0xedb88320U);
+	case DE_CRCOBJ_ADLER32:
+		return adler32_combine(val1, val2, len2);
+	case DE_CRCOBJ_CRC16_XMODEM:
+		// A non-reflected CRC, so reflect it, and reflect it back.
+		return reverse16(crc_combine_reflected(reverse16(val1), reverse16(val2),
+			len2, 16, 0x8408));
+	case DE_CRCOBJ_CRC16_ARC:
+		return crc_combine_reflected(val1, val2, len2, 16, 0xa001);
+	case DE_CRCOBJ_CRC16_IBMSDLC:
+		return crc_combine_reflected(val1, val2, len2, 16, 0x8408);
+	case DE_CRCOBJ_SUM_BYTES:
+		return val1 + val2;
+	}
+	return val1;
+}
+
+// Update crco as if it had been given a further len2 bytes, whose CRC
+// (by itself, as returned by de_crcobj_getval()) is crc2.
+// This allows a large input to be processed in independent chunks.
+// Not supported for SUM_U16* types.
+void de_crcobj_combine(struct de_crcobj *crco, u32 crc2, i64 len2)
+{
+	if(len2<1) return;
+	if(!crcobj_can_combine(crco)) {
+		de_internal_err_nonfatal(crco->c, "Can't combine CRCs of this type");
+		return;
+	}
+	crcobj_setval(crco, crcobj_combine_vals(crco, de_crcobj_getval(crco), crc2, len2));
+}
+
+#define DE_CRC_RUNBUFSIZE 256
+
+// Long runs are processed in O(log(len)) time, by repeatedly combining the
+// CRC of a block with itself.
 void de_crcobj_addrun(struct de_crcobj *crco, u8 v, i64 len)
 {
-	i64 i;
+	u8 buf[DE_CRC_RUNBUFSIZE];
+	i64 nblocks;
+	u32 prev_val;
+	u32 blk_val;
+	u32 acc_val;
+	i64 blk_len;
 
-	for(i=0; i<len; i++) {
-		de_crcobj_addbuf(crco, &v, 1);
+	if(len<1) return;
+	de_memset(buf, v, (size_t)de_min_int(len, DE_CRC_RUNBUFSIZE));
+
+	if(len<=DE_CRC_RUNBUFSIZE*2 || !crcobj_can_combine(crco)) {
+		while(len>0) {
+			i64 n = de_min_int(len, DE_CRC_RUNBUFSIZE);
+
+			de_crcobj_addbuf(crco, buf, n);
+			len -= n;
+		}
+		return;
 	}
+
+	// Calculate the CRC of one block, by itself.
+	prev_val = de_crcobj_getval(crco);
+	de_crcobj_reset(crco);
+	acc_val = de_crcobj_getval(crco); // The CRC of an empty input
+	de_crcobj_addbuf(crco, buf, DE_CRC_RUNBUFSIZE);
+	blk_val = de_crcobj_getval(crco);
+	blk_len = DE_CRC_RUNBUFSIZE;
+
+	// Since every block is the same, the order in which they are combined
+	// doesn't matter.
+	nblocks = len / DE_CRC_RUNBUFSIZE;
+	while(nblocks>0) {
+		if(nblocks & 1) {
+			acc_val = crcobj_combine_vals(crco, acc_val, blk_val, blk_len);
+		}
+		nblocks >>= 1;
+		if(nblocks>0) {
+			blk_val = crcobj_combine_vals(crco, blk_val, blk_val, blk_len);
+			blk_len *= 2;
+		}
+	}
+
+	crcobj_setval(crco, crcobj_combine_vals(crco, prev_val, acc_val,
+		len - len%DE_CRC_RUNBUFSIZE));
+	de_crcobj_addbuf(crco, buf, len%DE_CRC_RUNBUFSIZE);
 }
 
 void de_crcobj_addzeroes(struct de_crcobj *crco, i64 len)
@@ -2188,6 +3186,155 @@ u32 de_calccrc_oneshot(dbuf *f, i64 pos, i64 len, UI type_and_flags)
 	return val;
 }
 
+// Simple bit-at-a-time or byte-at-a-time versions of the crcobj types other
+// than CRC-32, for testing.
+static u32 crcobj_calc_reference(UI crctype, const u8 *buf, i64 len)
+{
+	u32 v = 0;
+	u32 s1 = 1, s2 = 0;
+	i64 i;
+	UI k;
+
+	if(crctype==DE_CRCOBJ_CRC16_IBMSDLC) v = 0xffff;
+
+	for(i=0; i<len; i++) {
+		switch(crctype) {
+		case DE_CRCOBJ_ADLER32:
+			s1 = (s1 + buf[i]) % 65521;
+			s2 = (s2 + s1) % 65521;
+			break;
+		case DE_CRCOBJ_CRC16_XMODEM:
+			v ^= (u32)buf[i] << 8;
+			for(k=0; k<8; k++) {
+				v = (v & 0x8000) ? (((v<<1) ^ 0x1021) & 0xffff) : ((v<<1) & 0xffff);
+			}
+			break;
+		case DE_CRCOBJ_CRC16_ARC:
+		case DE_CRCOBJ_CRC16_IBMSDLC:
+			v ^= (u32)buf[i];
+			for(k=0; k<8; k++) {
+				v = (v & 1) ? ((v>>1) ^ (crctype==DE_CRCOBJ_CRC16_ARC ? 0xa001 : 0x8408)) :
+					(v>>1);
+			}
+			break;
+		case DE_CRCOBJ_SUM_BYTES:
+			v += (u32)buf[i];
+			break;
+		case DE_CRCOBJ_SUM_U16LE:
+			v += (u32)buf[i] << ((i & 1) ? 8 : 0);
+			break;
+		case DE_CRCOBJ_SUM_U16BE:
+			v += (u32)buf[i] << ((i & 1) ? 0 : 8);
+			break;
+		}
+	}
+
+	if(crctype==DE_CRCOBJ_ADLER32) v = (s2 << 16) | s1;
+	if(crctype==DE_CRCOBJ_CRC16_IBMSDLC) v ^= 0xffff;
+	return v;
+}
+
+// Compares each available CRC-32 implementation to the reference
+// implementation, on assorted lengths, alignments, and split points. Then
+// does something similar for the other crcobj types.
+// Returns 1 if they all agree.
+int de_crcobj_selftest(deark *c)
+{
+	static const UI other_types[] = { DE_CRCOBJ_ADLER32, DE_CRCOBJ_CRC16_XMODEM,
+		DE_CRCOBJ_CRC16_ARC, DE_CRCOBJ_CRC16_IBMSDLC, DE_CRCOBJ_SUM_BYTES,
+		DE_CRCOBJ_SUM_U16LE, DE_CRCOBJ_SUM_U16BE };
+	struct de_crcobj *crco = NULL;
+	static const char *impl_names[4] = { "nibble", "slice8", "pclmul", "armv8" };
+	UI impls[4];
+	UI num_impls = 0;
+	UI k;
+	u8 *buf = NULL;
+	const i64 bufsize = 70000;
+	u32 seed = 12345;
+	i64 i;
+	int retval = 0;
+
+	impls[num_impls++] = DE_CRC32IMPL_SLICE8;
+#ifdef DE_CRC32_PCLMUL
+	if(crc32_pclmul_is_supported()) impls[num_impls++] = DE_CRC32IMPL_PCLMUL;
+#endif
+#ifdef DE_CRC32_ARMV8
+	impls[num_impls++] = DE_CRC32IMPL_ARMV8;
+#endif
+
+	buf = de_malloc(c, bufsize);
+	for(i=0; i<bufsize; i++) {
+		seed = seed*1103515245U + 12345U;
+		buf[i] = (u8)(seed>>16);
+	}
+
+	for(k=0; k<num_impls; k++) {
+		i64 len;
+		UI impl = impls[k];
+
+		de_dbg(c, "testing CRC-32 implementation: %s", impl_names[impl]);
+		for(len=0; len<=bufsize-32; len = (len<300) ? len+1 : len*2+7) {
+			i64 ofs;
+
+			for(ofs=0; ofs<16; ofs++) {
+				u32 crc_ref, crc_x, crc_split;
+				i64 split;
+
+				crc_ref = crc32_calc_nibble(&buf[ofs], (size_t)len, DE_CRC32_INIT);
+				crc_x = crc32_calc_by_impl(impl, &buf[ofs], (size_t)len, DE_CRC32_INIT);
+				split = (len*(ofs+1))/17;
+				crc_split = crc32_calc_by_impl(impl, &buf[ofs], (size_t)split, 0x89abcdefU);
+				crc_split = crc32_calc_by_impl(impl, &buf[ofs+split], (size_t)(len-split),
+					crc_split);
+				if(crc_x!=crc_ref || crc_split!=crc32_calc_nibble(&buf[ofs+split],
+					(size_t)(len-split), crc32_calc_nibble(&buf[ofs], (size_t)split,
+					0x89abcdefU)))
+				{
+					de_err(c, "CRC-32 self-test failed (%s, len=%"I64_FMT", offset=%d)",
+						impl_names[impl], len, (int)ofs);
+					goto done;
+				}
+			}
+		}
+	}
+
+	for(k=0; k<(UI)DE_ARRAYCOUNT(other_types); k++) {
+		i64 len;
+
+		de_dbg(c, "testing crcobj type 0x%02x", other_types[k]);
+		crco = de_crcobj_create(c, other_types[k]);
+		for(len=0; len<=bufsize-32; len = (len<300) ? len+1 : len*2+7) {
+			i64 ofs;
+
+			for(ofs=0; ofs<4; ofs++) {
+				i64 split;
+
+				split = (len*(ofs+1))/5;
+				de_crcobj_reset(crco);
+				de_crcobj_addbuf(crco, &buf[ofs], split);
+				de_crcobj_addbuf(crco, &buf[ofs+split], len-split);
+				if(de_crcobj_getval(crco) != crcobj_calc_reference(other_types[k],
+					&buf[ofs], len))
+				{
+					de_err(c, "crcobj self-test failed (type 0x%02x, len=%"I64_FMT
+						", offset=%d)", other_types[k], len, (int)ofs);
+					goto done;
+				}
+			}
+		}
+		de_crcobj_destroy(crco);
+		crco = NULL;
+	}
+
+	de_msg(c, "CRC self-test passed (%u CRC-32 implementations, %u other types)",
+		num_impls, (UI)DE_ARRAYCOUNT(other_types));
+	retval = 1;
+done:
+	de_crcobj_destroy(crco);
+	de_free(c, buf);
+	return retval;
+}
+
 void de_get_reproducible_timestamp(deark *c, struct de_timestamp *ts)
 {
 	if(c->reproducible_timestamp.is_valid) {
@@ -11,6 +11,7 @@
 #ifdef DE_WINDOWS
 
 #include <windows.h>
+#include <io.h>
 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -282,6 +283,111 @@ int de_fclose(FILE *fp)
 	return fclose(fp);
 }
 
+// See the comments in deark-unix.c.
+FILE *de_fopen_tmpfile(deark *c)
+{
+	FILE *fp = NULL;
+
+	if(tmpfile_s(&fp)!=0) return NULL;
+	return fp;
+}
+
+// See the comments in deark-unix.c.
+// Not implemented for Windows.
+i64 de_copy_file_data(deark *c, FILE *infp, i64 inpos, FILE *outfp, i64 len)
+{
+	return 0;
+}
+
+struct de_mmapinfo {
+	HANDLE hmap;
+	void *addr;
+};
+
+// See the comments in deark-unix.c.
+struct de_mmapinfo *de_mmap_file_for_read(deark *c, FILE *fp, i64 len,
+	const u8 **pmem)
+{
+#if DE_USE_MMAP
+	struct de_mmapinfo *mmi;
+	HANDLE fh;
+	HANDLE hmap;
+	void *addr;
+
+	*pmem = NULL;
+	if(len<1) return NULL;
+	if((u64)len > (u64)(SIZE_T)(-1)) return NULL;
+
+	fh = (HANDLE)_get_osfhandle(_fileno(fp));
+	if(fh==INVALID_HANDLE_VALUE) return NULL;
+
+	hmap = CreateFileMappingW(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!hmap) return NULL;
+
+	addr = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, (SIZE_T)len);
+	if(!addr) {
+		CloseHandle(hmap);
+		return NULL;
+	}
+
+	mmi = de_malloc(c, sizeof(struct de_mmapinfo));
+	mmi->hmap = hmap;
+	mmi->addr = addr;
+	*pmem = (const u8*)addr;
+	return mmi;
+#else
+	*pmem = NULL;
+	return NULL;
+#endif
+}
+
+void de_munmap_file(deark *c, struct de_mmapinfo *mmi)
+{
+	if(!mmi) return;
+#if DE_USE_MMAP
+	UnmapViewOfFile(mmi->addr);
+	CloseHandle(mmi->hmap);
+#endif
+	de_free(c, mmi);
+}
+
+// Threads are not currently supported on Windows. (The condition variable
+// API that we'd want requires Windows Vista.)
+// See the comments in deark-unix.c.
+struct de_threadinfo *de_thread_create(deark *c, de_thread_fn_type fn, void *userdata)
+{
+	return NULL;
+}
+
+void de_thread_join(deark *c, struct de_threadinfo *ti)
+{
+}
+
+struct de_syncobj *de_syncobj_create(deark *c)
+{
+	return NULL;
+}
+
+void de_syncobj_destroy(deark *c, struct de_syncobj *so)
+{
+}
+
+void de_syncobj_lock(struct de_syncobj *so)
+{
+}
+
+void de_syncobj_unlock(struct de_syncobj *so)
+{
+}
+
+void de_syncobj_wait(struct de_syncobj *so)
+{
+}
+
+void de_syncobj_broadcast(struct de_syncobj *so)
+{
+}
+
 static void update_file_time(dbuf *f)
 {
 	WCHAR *fnW = NULL;
@@ -487,6 +593,17 @@ void de_current_time_to_timestamp(struct de_timestamp *ts)
 	de_FILETIME_to_timestamp(ft, ts, 0x1);
 }
 
+// Returns a time in microseconds, relative to an arbitrary starting point.
+// Only useful for measuring elapsed time.
+i64 de_get_monotonic_time_usec(void)
+{
+	LARGE_INTEGER freq, count;
+
+	if(!QueryPerformanceFrequency(&freq) || freq.QuadPart<=0) return 0;
+	QueryPerformanceCounter(&count);
+	return (i64)((double)count.QuadPart * 1000000.0 / (double)freq.QuadPart);
+}
+
 void de_exitprocess(int s)
 {
 	exit(s);
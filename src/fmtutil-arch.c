@@ -8,35 +8,62 @@
 #include "deark-private.h"
 #include "deark-fmtutil-arch.h"
 
+// The md, and the objects it owns, are allocated from a per-member arena,
+// which is recycled for the next member.
 struct de_arch_member_data *de_arch_create_md(deark *c, de_arch_lctx *d)
 {
 	struct de_arch_member_data *md;
+	struct de_arena *a;
 
-	md = de_malloc(c, sizeof(struct de_arch_member_data));
+	if(d && d->spare_arena) {
+		a = d->spare_arena;
+		d->spare_arena = NULL;
+	}
+	else {
+		a = de_arena_create(c, 0);
+	}
+
+	md = de_arena_malloc(a, sizeof(struct de_arch_member_data));
 	md->c = c;
 	md->d = d;
-	md->filename = ucstring_create(c);
-	md->name_for_msgs = ucstring_create(c);
-	md->fi = de_finfo_create(c);
+	md->arena = a;
+	md->filename = ucstring_create_in_arena(c, a);
+	md->name_for_msgs = ucstring_create_in_arena(c, a);
+	md->fi = de_finfo_create_in_arena(c, a);
 	return md;
 }
 
 void de_arch_destroy_md(deark *c, struct de_arch_member_data *md)
 {
+	struct de_arena *a;
+	de_arch_lctx *d;
+
 	if(!md) return;
+	a = md->arena;
+	d = md->d;
 	ucstring_destroy(md->filename);
 	ucstring_destroy(md->name_for_msgs);
 	ucstring_destroy(md->tmpfn_base);
 	ucstring_destroy(md->tmpfn_path);
 	de_finfo_destroy(c, md->fi);
-	de_free(c, md);
+	// This releases md itself.
+	de_arena_reset(a);
+
+	if(d && !d->spare_arena) {
+		d->spare_arena = a;
+	}
+	else {
+		de_arena_destroy(a);
+	}
 }
 
+// The lctx is allocated from the module's arena, so it must not be used after
+// the module that created it has finished.
 de_arch_lctx *de_arch_create_lctx(deark *c)
 {
 	de_arch_lctx *d;
 
-	d = de_malloc(c, sizeof(de_arch_lctx));
+	d = de_arena_malloc(de_get_module_arena(c), sizeof(de_arch_lctx));
 	d->c = c;
 	d->inf = c->infile;
 	return d;
@@ -46,7 +73,9 @@ void de_arch_destroy_lctx(deark *c, de_arch_lctx *d)
 {
 	if(!d) return;
 	de_crcobj_destroy(d->crco);
-	de_free(c, d);
+	de_arena_destroy(d->spare_arena);
+	d->spare_arena = NULL;
+	d->crco = NULL;
 }
 
 static void ensure_name_for_msgs_is_set(struct de_arch_member_data *md)
@@ -120,7 +149,7 @@ void de_arch_handle_field_dos_attr(struct de_arch_member_data *md, UI attr)
 
 	md->dos_attribs = attr;
 	md->has_dos_attribs = 1;
-	descr = ucstring_create(md->c);
+	descr = ucstring_create_in_arena(md->c, md->arena);
 	de_describe_dos_attribs(md->c, md->dos_attribs, descr, 0);
 	de_dbg(md->c, "DOS attribs: 0x%02x (%s)", md->dos_attribs, ucstring_getpsz_d(descr));
 	ucstring_destroy(descr);
@@ -196,6 +196,230 @@ void de_dfilter_decompress_oneshot(deark *c,
 	de_dfilter_destroy(dfctx);
 }
 
+///////////////////////////////////
+// Codec backend registry
+
+static void lzw_codectype1_wrapper(deark *c, struct de_dfilter_in_params *dcmpri,
+	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
+	void *codec_private_params)
+{
+	fmtutil_decompress_lzw(c, dcmpri, dcmpro, dres,
+		(struct de_lzw_params*)codec_private_params);
+}
+
+static void packbits_codectype1_wrapper(deark *c, struct de_dfilter_in_params *dcmpri,
+	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
+	void *codec_private_params)
+{
+	fmtutil_decompress_packbits_ex(c, dcmpri, dcmpro, dres,
+		(struct de_packbits_params*)codec_private_params);
+}
+
+// The first backend listed for a method is the default.
+static const struct fmtutil_codec_backend deflate_backends[] = {
+	{ "native", fmtutil_deflate_codectype1_native },
+	{ "miniz", fmtutil_deflate_codectype1_miniz }
+};
+static const struct fmtutil_codec_backend lzw_backends[] = {
+	{ "native", lzw_codectype1_wrapper }
+};
+static const struct fmtutil_codec_backend packbits_backends[] = {
+	{ "native", packbits_codectype1_wrapper }
+};
+static const struct fmtutil_codec_backend lh5x_backends[] = {
+	{ "native", fmtutil_lh5x_codectype1 }
+};
+
+struct codec_method_info;
+// Returns the index of the fastest backend, or -1 if unknown.
+typedef int (*codec_choose_fastest_fn_type)(deark *c,
+	const struct codec_method_info *cmi);
+
+struct codec_method_info {
+	const char *name;
+	const struct fmtutil_codec_backend *backends;
+	UI num_backends;
+	codec_choose_fastest_fn_type choose_fastest_fn; // May be NULL
+};
+
+static int deflate_choose_fastest(deark *c, const struct codec_method_info *cmi);
+
+static const struct codec_method_info codec_method_info_arr[] = {
+	{ "deflate", deflate_backends, DE_ARRAYCOUNT(deflate_backends), deflate_choose_fastest },
+	{ "lzw", lzw_backends, DE_ARRAYCOUNT(lzw_backends), NULL },
+	{ "packbits", packbits_backends, DE_ARRAYCOUNT(packbits_backends), NULL },
+	{ "lh5x", lh5x_backends, DE_ARRAYCOUNT(lh5x_backends), NULL }
+};
+
+// Make some compressible test data, vaguely resembling text.
+static void make_codec_sample_data(u8 *buf, i64 len)
+{
+	static const char *words[16] = { "the ", "of ", "and ", "compression ",
+		"a ", "to ", "in ", "file ", "data ", "is ", "format ", "that ",
+		"with ", "deark ", "image ", "for " };
+	u32 seed = 1;
+	i64 pos = 0;
+
+	while(pos<len) {
+		seed = seed*1103515245U + 12345U;
+		if(((seed>>16) & 0x1f)==0) {
+			// Occasional incompressible byte
+			buf[pos++] = (u8)(seed>>24);
+		}
+		else {
+			const char *w = words[(seed>>20) & 0x0f];
+
+			while(*w && pos<len) {
+				buf[pos++] = (u8)*w++;
+			}
+		}
+	}
+}
+
+#define CODEC_SAMPLE_SIZE 524288
+
+// Times each Deflate backend on some sample data.
+static int deflate_choose_fastest(deark *c, const struct codec_method_info *cmi)
+{
+	u8 *sample = NULL;
+	dbuf *cmprf = NULL;
+	dbuf *outf = NULL;
+	struct fmtutil_tdefl_ctx *tdctx = NULL;
+	struct de_dfilter_in_params dcmpri;
+	struct de_dfilter_out_params dcmpro;
+	struct de_dfilter_results dres;
+	struct de_deflate_params deflparams;
+	i64 best_time = 0;
+	int best_idx = -1;
+	UI i;
+	int k;
+
+	sample = de_malloc(c, CODEC_SAMPLE_SIZE);
+	make_codec_sample_data(sample, CODEC_SAMPLE_SIZE);
+	cmprf = dbuf_create_membuf(c, CODEC_SAMPLE_SIZE/2, 0);
+	tdctx = fmtutil_tdefl_create(c, cmprf,
+		(int)fmtutil_tdefl_create_comp_flags_from_zip_params(6, -15, 0));
+	if(fmtutil_tdefl_compress_buffer(tdctx, sample, CODEC_SAMPLE_SIZE,
+		FMTUTIL_TDEFL_FINISH) != FMTUTIL_TDEFL_STATUS_DONE)
+	{
+		goto done;
+	}
+
+	outf = dbuf_create_membuf(c, CODEC_SAMPLE_SIZE, 0);
+
+	for(i=0; i<cmi->num_backends; i++) {
+		i64 backend_time = 0;
+
+		for(k=0; k<3; k++) {
+			i64 t0, t;
+
+			dbuf_truncate(outf, 0);
+			de_dfilter_init_objects(c, &dcmpri, &dcmpro, &dres);
+			dcmpri.f = cmprf;
+			dcmpri.pos = 0;
+			dcmpri.len = cmprf->len;
+			dcmpro.f = outf;
+			de_zeromem(&deflparams, sizeof(struct de_deflate_params));
+
+			t0 = de_get_monotonic_time_usec();
+			cmi->backends[i].codec_fn(c, &dcmpri, &dcmpro, &dres, (void*)&deflparams);
+			t = de_get_monotonic_time_usec() - t0;
+
+			if(dres.errcode || outf->len!=CODEC_SAMPLE_SIZE) {
+				backend_time = -1;
+				break;
+			}
+			if(k==0 || t<backend_time) backend_time = t;
+		}
+
+		de_dbg2(c, "%s codec \"%s\": %"I64_FMT" us", cmi->name, cmi->backends[i].name,
+			backend_time);
+		if(backend_time<0) continue;
+		if(best_idx<0 || backend_time<best_time) {
+			best_idx = (int)i;
+			best_time = backend_time;
+		}
+	}
+
+done:
+	fmtutil_tdefl_destroy(tdctx);
+	dbuf_close(cmprf);
+	dbuf_close(outf);
+	de_free(c, sample);
+	return best_idx;
+}
+
+static const struct codec_method_info *get_codec_method_info(const char *method, UI *pidx)
+{
+	UI i;
+
+	for(i=0; i<(UI)DE_ARRAYCOUNT(codec_method_info_arr); i++) {
+		if(!de_strcmp(codec_method_info_arr[i].name, method)) {
+			if(pidx) *pidx = i;
+			return &codec_method_info_arr[i];
+		}
+	}
+	return NULL;
+}
+
+// Returns NULL if method is unknown, or idx is too large.
+const struct fmtutil_codec_backend *fmtutil_get_codec_backend(const char *method, UI idx)
+{
+	const struct codec_method_info *cmi;
+
+	cmi = get_codec_method_info(method, NULL);
+	if(!cmi || idx>=cmi->num_backends) return NULL;
+	return &cmi->backends[idx];
+}
+
+static UI choose_codec_backend(deark *c, const struct codec_method_info *cmi)
+{
+	char optname[32];
+	const char *o;
+	UI i;
+
+	de_snprintf(optname, sizeof(optname), "cmpr:%s", cmi->name);
+	o = de_get_ext_option(c, optname);
+	if(!o && !de_strcmp(cmi->name, "deflate")) {
+		o = de_get_ext_option(c, "deflatecodec"); // Old name of this option
+	}
+	if(!o) return 0;
+
+	if(!de_strcmp(o, "auto")) {
+		int ret;
+
+		if(cmi->num_backends<2 || !cmi->choose_fastest_fn) return 0;
+		ret = cmi->choose_fastest_fn(c, cmi);
+		if(ret<0) return 0;
+		de_dbg(c, "%s codec: %s (fastest)", cmi->name, cmi->backends[ret].name);
+		return (UI)ret;
+	}
+
+	for(i=0; i<cmi->num_backends; i++) {
+		if(!de_strcmp(o, cmi->backends[i].name)) return i;
+	}
+	de_warn(c, "Unknown %s codec \"%s\"", cmi->name, o);
+	return 0;
+}
+
+// Returns the backend to use for the given method, as selected by the user.
+// The selection is remembered for the rest of this run.
+// Returns NULL if method is unknown.
+const struct fmtutil_codec_backend *fmtutil_select_codec_backend(deark *c, const char *method)
+{
+	const struct codec_method_info *cmi;
+	UI midx = 0;
+
+	cmi = get_codec_method_info(method, &midx);
+	if(!cmi) return NULL;
+	if(midx >= (UI)sizeof(c->codec_backend_sel)) return &cmi->backends[0];
+
+	if(c->codec_backend_sel[midx]==0) {
+		c->codec_backend_sel[midx] = (u8)(1 + choose_codec_backend(c, cmi));
+	}
+	return &cmi->backends[c->codec_backend_sel[midx]-1];
+}
+
 // Trivial "decompression" of uncompressed data.
 void fmtutil_decompress_uncompressed(deark *c, struct de_dfilter_in_params *dcmpri,
 	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres, UI flags)
@@ -220,6 +444,76 @@ void fmtutil_decompress_uncompressed(deark *c, struct de_dfilter_in_params *dcmp
 	dres->bytes_consumed_valid = 1;
 }
 
+// A buffer used by simple RLE codecs to collect output bytes, so that they
+// can be written in large spans.
+struct rle_outbuf {
+	struct de_dfilter_ctx *dfctx;
+	size_t len;
+	size_t capacity;
+	u8 *buf;
+};
+
+#define RLE_OUTBUF_MAXSIZE 65536
+
+static void rle_outbuf_init(struct de_dfilter_ctx *dfctx, struct rle_outbuf *ob)
+{
+	i64 capacity = RLE_OUTBUF_MAXSIZE;
+
+	if(dfctx->dcmpro->len_known) {
+		// No need for a large buffer if the output is known to be small.
+		capacity = de_min_int(capacity, de_max_int(dfctx->dcmpro->expected_len, 256));
+	}
+	ob->dfctx = dfctx;
+	ob->capacity = (size_t)capacity;
+	ob->buf = de_malloc(dfctx->c, (i64)ob->capacity);
+	ob->len = 0;
+}
+
+static void rle_outbuf_flush(struct rle_outbuf *ob)
+{
+	if(ob->len==0) return;
+	dbuf_write(ob->dfctx->dcmpro->f, ob->buf, (i64)ob->len);
+	ob->len = 0;
+}
+
+static void rle_outbuf_write(struct rle_outbuf *ob, const u8 *m, i64 n)
+{
+	if(n<1) return;
+	if(ob->len + (size_t)n > ob->capacity) {
+		rle_outbuf_flush(ob);
+		if((size_t)n > ob->capacity/2) {
+			dbuf_write(ob->dfctx->dcmpro->f, m, n);
+			return;
+		}
+	}
+	de_memcpy(&ob->buf[ob->len], m, (size_t)n);
+	ob->len += (size_t)n;
+}
+
+static void rle_outbuf_write_run(struct rle_outbuf *ob, u8 b, i64 n)
+{
+	size_t amt;
+
+	while(n>0) {
+		if(ob->len >= ob->capacity) {
+			rle_outbuf_flush(ob);
+		}
+		amt = ob->capacity - ob->len;
+		if((i64)amt > n) amt = (size_t)n;
+		de_memset(&ob->buf[ob->len], b, amt);
+		ob->len += amt;
+		n -= (i64)amt;
+	}
+}
+
+static void rle_outbuf_destroy(struct rle_outbuf *ob)
+{
+	if(ob->buf) {
+		de_free(ob->dfctx->c, ob->buf);
+		ob->buf = NULL;
+	}
+}
+
 enum packbits_state_enum {
 	PACKBITS_STATE_NEUTRAL = 0,
 	PACKBITS_STATE_COPYING_LITERAL,
@@ -235,18 +529,20 @@ struct packbitsctx {
 	enum packbits_state_enum state;
 	i64 nliteral_bytes_remaining;
 	i64 repeat_count;
+	struct rle_outbuf ob;
 };
 
 static void my_packbits_codec_addbuf(struct de_dfilter_ctx *dfctx,
 	const u8 *buf, i64 buf_len)
 {
-	int i;
+	i64 i = 0;
+	i64 n;
 	u8 b;
 	struct packbitsctx *rctx = (struct packbitsctx*)dfctx->codec_private;
 
 	if(!rctx) return;
 
-	for(i=0; i<buf_len; i++) {
+	while(i<buf_len) {
 		if(dfctx->dcmpro->len_known &&
 			(rctx->nbytes_written >= dfctx->dcmpro->expected_len))
 		{
@@ -254,11 +550,10 @@ static void my_packbits_codec_addbuf(struct de_dfilter_ctx *dfctx,
 			break;
 		}
 
-		b = buf[i];
-		rctx->total_nbytes_processed++;
-
 		switch(rctx->state) {
 		case PACKBITS_STATE_NEUTRAL: // this is a code byte
+			b = buf[i++];
+			rctx->total_nbytes_processed++;
 			if(b>128) { // A compressed run
 				rctx->repeat_count = 257 - (i64)b;
 				rctx->state = PACKBITS_STATE_READING_UNIT_TO_REPEAT;
@@ -272,17 +567,25 @@ static void my_packbits_codec_addbuf(struct de_dfilter_ctx *dfctx,
 			// mark the end of compressed data, so maybe there should be options to
 			// tell us what to do when code 128 is encountered.
 			break;
-		case PACKBITS_STATE_COPYING_LITERAL: // This byte is uncompressed
-			dbuf_writebyte(dfctx->dcmpro->f, b);
-			rctx->nbytes_written++;
-			rctx->nliteral_bytes_remaining--;
+		case PACKBITS_STATE_COPYING_LITERAL: // Copy as many uncompressed bytes as we can
+			n = de_min_int(rctx->nliteral_bytes_remaining, buf_len-i);
+			if(dfctx->dcmpro->len_known) {
+				n = de_min_int(n, dfctx->dcmpro->expected_len - rctx->nbytes_written);
+			}
+			rle_outbuf_write(&rctx->ob, &buf[i], n);
+			i += n;
+			rctx->total_nbytes_processed += n;
+			rctx->nbytes_written += n;
+			rctx->nliteral_bytes_remaining -= n;
 			if(rctx->nliteral_bytes_remaining<=0) {
 				rctx->state = PACKBITS_STATE_NEUTRAL;
 			}
 			break;
 		case PACKBITS_STATE_READING_UNIT_TO_REPEAT:
+			b = buf[i++];
+			rctx->total_nbytes_processed++;
 			if(rctx->nbytes_per_unit==1) { // Optimization for standard PackBits
-				dbuf_write_run(dfctx->dcmpro->f, b, rctx->repeat_count);
+				rle_outbuf_write_run(&rctx->ob, b, rctx->repeat_count);
 				rctx->nbytes_written += rctx->repeat_count;
 				rctx->state = PACKBITS_STATE_NEUTRAL;
 			}
@@ -292,7 +595,7 @@ static void my_packbits_codec_addbuf(struct de_dfilter_ctx *dfctx,
 					i64 k;
 
 					for(k=0; k<rctx->repeat_count; k++) {
-						dbuf_write(dfctx->dcmpro->f, rctx->unitbuf, (i64)rctx->nbytes_per_unit);
+						rle_outbuf_write(&rctx->ob, rctx->unitbuf, (i64)rctx->nbytes_per_unit);
 					}
 					rctx->nbytes_in_unitbuf = 0;
 					rctx->nbytes_written += rctx->repeat_count * (i64)rctx->nbytes_per_unit;
@@ -302,6 +605,8 @@ static void my_packbits_codec_addbuf(struct de_dfilter_ctx *dfctx,
 			break;
 		}
 	}
+
+	rle_outbuf_flush(&rctx->ob);
 }
 
 static void my_packbits_codec_command(struct de_dfilter_ctx *dfctx, int cmd, UI flags)
@@ -336,6 +641,7 @@ static void my_packbits_codec_destroy(struct de_dfilter_ctx *dfctx)
 	struct packbitsctx *rctx = (struct packbitsctx*)dfctx->codec_private;
 
 	if(rctx) {
+		rle_outbuf_destroy(&rctx->ob);
 		de_free(dfctx->c, rctx);
 	}
 	dfctx->codec_private = NULL;
@@ -352,6 +658,7 @@ void dfilter_packbits_codec(struct de_dfilter_ctx *dfctx, void *codec_private_pa
 	if(pbparams && pbparams->is_packbits16) {
 		rctx->nbytes_per_unit = 2;
 	}
+	rle_outbuf_init(dfctx, &rctx->ob);
 	dfctx->codec_private = (void*)rctx;
 	dfctx->codec_addbuf_fn = my_packbits_codec_addbuf;
 	dfctx->codec_finish_fn = my_packbits_codec_finish;
@@ -411,18 +718,21 @@ struct rle90ctx {
 	i64 nbytes_written;
 	u8 last_output_byte;
 	int countcode_pending;
+	struct rle_outbuf ob;
 };
 
 static void my_rle90_codec_addbuf(struct de_dfilter_ctx *dfctx,
 	const u8 *buf, i64 buf_len)
 {
-	int i;
+	i64 i = 0;
+	i64 n;
 	u8 b;
+	const u8 *p;
 	struct rle90ctx *rctx = (struct rle90ctx*)dfctx->codec_private;
 
 	if(!rctx) return;
 
-	for(i=0; i<buf_len; i++) {
+	while(i<buf_len) {
 		if(dfctx->dcmpro->len_known &&
 			(rctx->nbytes_written >= dfctx->dcmpro->expected_len))
 		{
@@ -430,41 +740,56 @@ static void my_rle90_codec_addbuf(struct de_dfilter_ctx *dfctx,
 			break;
 		}
 
-		b = buf[i];
-		rctx->total_nbytes_processed++;
-
-		if(rctx->countcode_pending && b==0) {
-			// Not RLE, just an escaped 0x90 byte.
-			dbuf_writebyte(dfctx->dcmpro->f, 0x90);
-			rctx->nbytes_written++;
-			rctx->last_output_byte = 0x90;
+		if(rctx->countcode_pending) {
+			b = buf[i++];
+			rctx->total_nbytes_processed++;
 			rctx->countcode_pending = 0;
-		}
-		else if(rctx->countcode_pending) {
-			i64 count;
-
-			// RLE. We already emitted one byte (because the byte to repeat
-			// comes before the repeat count), so write countcode-1 bytes.
-			count = (i64)(b-1);
-			if(dfctx->dcmpro->len_known &&
-				(rctx->nbytes_written+count > dfctx->dcmpro->expected_len))
-			{
-				count = dfctx->dcmpro->expected_len - rctx->nbytes_written;
+
+			if(b==0) {
+				// Not RLE, just an escaped 0x90 byte.
+				rle_outbuf_write_run(&rctx->ob, 0x90, 1);
+				rctx->nbytes_written++;
+				rctx->last_output_byte = 0x90;
+			}
+			else {
+				i64 count;
+
+				// RLE. We already emitted one byte (because the byte to repeat
+				// comes before the repeat count), so write countcode-1 bytes.
+				count = (i64)(b-1);
+				if(dfctx->dcmpro->len_known &&
+					(rctx->nbytes_written+count > dfctx->dcmpro->expected_len))
+				{
+					count = dfctx->dcmpro->expected_len - rctx->nbytes_written;
+				}
+				rle_outbuf_write_run(&rctx->ob, rctx->last_output_byte, count);
+				rctx->nbytes_written += count;
 			}
-			dbuf_write_run(dfctx->dcmpro->f, rctx->last_output_byte, count);
-			rctx->nbytes_written += count;
+			continue;
+		}
 
-			rctx->countcode_pending = 0;
+		// Copy the bytes up to the next 0x90 byte, all at once.
+		p = de_memchr(&buf[i], 0x90, (size_t)(buf_len-i));
+		n = p ? (i64)(p-&buf[i]) : (buf_len-i);
+		if(dfctx->dcmpro->len_known) {
+			n = de_min_int(n, dfctx->dcmpro->expected_len - rctx->nbytes_written);
 		}
-		else if(b==0x90) {
-			rctx->countcode_pending = 1;
+
+		if(n>0) {
+			rle_outbuf_write(&rctx->ob, &buf[i], n);
+			rctx->last_output_byte = buf[i+n-1];
+			i += n;
+			rctx->total_nbytes_processed += n;
+			rctx->nbytes_written += n;
 		}
-		else {
-			dbuf_writebyte(dfctx->dcmpro->f, b);
-			rctx->nbytes_written++;
-			rctx->last_output_byte = b;
+		else { // buf[i] is 0x90
+			i++;
+			rctx->total_nbytes_processed++;
+			rctx->countcode_pending = 1;
 		}
 	}
+
+	rle_outbuf_flush(&rctx->ob);
 }
 
 static void my_rle90_codec_finish(struct de_dfilter_ctx *dfctx)
@@ -481,6 +806,7 @@ static void my_rle90_codec_destroy(struct de_dfilter_ctx *dfctx)
 	struct rle90ctx *rctx = (struct rle90ctx*)dfctx->codec_private;
 
 	if(rctx) {
+		rle_outbuf_destroy(&rctx->ob);
 		de_free(dfctx->c, rctx);
 	}
 	dfctx->codec_private = NULL;
@@ -494,6 +820,7 @@ void dfilter_rle90_codec(struct de_dfilter_ctx *dfctx, void *codec_private_param
 	struct rle90ctx *rctx = NULL;
 
 	rctx = de_malloc(dfctx->c, sizeof(struct rle90ctx));
+	rle_outbuf_init(dfctx, &rctx->ob);
 	dfctx->codec_private = (void*)rctx;
 	dfctx->codec_addbuf_fn = my_rle90_codec_addbuf;
 	dfctx->codec_finish_fn = my_rle90_codec_finish;
@@ -515,20 +842,24 @@ struct lzss_ctx {
 };
 
 // Used by lzss1 & hlp_lz77
-static void lzss_lz77buf_writebytecb(struct de_lz77buffer *rb, const u8 n)
+static void lzss_lz77buf_writespancb(struct de_lz77buffer *rb, const u8 *buf, UI len)
 {
 	struct lzss_ctx *sctx = (struct lzss_ctx*)rb->userdata;
 
 	if(sctx->stop_flag) return;
 	if(sctx->dcmpro->len_known) {
-		if(sctx->nbytes_written >= sctx->dcmpro->expected_len) {
+		i64 nbytes_wanted = sctx->dcmpro->expected_len - sctx->nbytes_written;
+
+		if((i64)len > nbytes_wanted) {
+			// Once we have enough output, stop when we get more.
 			sctx->stop_flag = 1;
-			return;
+			if(nbytes_wanted<=0) return;
+			len = (UI)nbytes_wanted;
 		}
 	}
 
-	dbuf_writebyte(sctx->dcmpro->f, n);
-	sctx->nbytes_written++;
+	dbuf_write(sctx->dcmpro->f, buf, (i64)len);
+	sctx->nbytes_written += (i64)len;
 }
 
 static void lzss_init_window_lz5(struct de_lz77buffer *ringbuf)
@@ -587,7 +918,7 @@ void fmtutil_lzss1_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 	sctx->cur_ipos = dcmpri->pos;
 	sctx->endpos = dcmpri->pos + dcmpri->len;
 	sctx->ringbuf = de_lz77buffer_create(c, LZSS_BUFSIZE);
-	sctx->ringbuf->writebyte_cb = lzss_lz77buf_writebytecb;
+	sctx->ringbuf->write_span_cb = lzss_lz77buf_writespancb;
 	sctx->ringbuf->userdata = (void*)sctx;
 
 	if(params->flags & 0x2) {
@@ -673,7 +1004,7 @@ void fmtutil_hlp_lz77_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 	sctx->cur_ipos = dcmpri->pos;
 	sctx->endpos = dcmpri->pos + dcmpri->len;
 	sctx->ringbuf = de_lz77buffer_create(c, 4096);
-	sctx->ringbuf->writebyte_cb = lzss_lz77buf_writebytecb;
+	sctx->ringbuf->write_span_cb = lzss_lz77buf_writespancb;
 	sctx->ringbuf->userdata = (void*)sctx;
 	de_lz77buffer_clear(sctx->ringbuf, 0x20);
 
@@ -720,20 +1051,6 @@ unc_done:
 
 //========================================================
 
-struct my_2layer_userdata {
-	struct de_dfilter_ctx *dfctx_codec2;
-	i64 intermediate_nbytes;
-};
-
-static void my_2layer_write_cb(dbuf *f, void *userdata,
-	const u8 *buf, i64 size)
-{
-	struct my_2layer_userdata *u = (struct my_2layer_userdata*)userdata;
-
-	de_dfilter_addbuf(u->dfctx_codec2, buf, size);
-	u->intermediate_nbytes += size;
-}
-
 // If src indicates error and dst does not, copy the error from src to dst.
 void de_dfilter_transfer_error(deark *c, struct de_dfilter_results *src,
 	struct de_dfilter_results *dst)
@@ -744,65 +1061,385 @@ void de_dfilter_transfer_error(deark *c, struct de_dfilter_results *src,
 	}
 }
 
-// Decompress an arbitrary two-layer compressed format.
-// tlp->codec1* is the first one that will be used during decompression (i.e. the second
-// method used when during *compression*).
-void de_dfilter_decompress_two_layer(deark *c, struct de_dcmpr_two_layer_params *tlp)
+// Multi-stage ("pipeline") decompression.
+// The output of each stage is sent to the next stage as it is produced,
+// through a custom dbuf.
+// Normally, all stages run on the calling thread, and the custom dbuf passes
+// its buffered data straight to the next stage's codec.
+// In threaded mode (-opt cmpr:threads), each stage after the first runs on its
+// own thread. A stage's output is collected into chunks, whose ownership is
+// handed to the next stage through a bounded queue.
+
+#define DFPIPE_CHUNK_SIZE 65536
+#define DFPIPE_QUEUE_LEN  4
+
+struct dfpipe_queue {
+	struct de_syncobj *so;
+	// The chunks that are waiting to be consumed:
+	u8 *chunks[DFPIPE_QUEUE_LEN];
+	i64 chunk_len[DFPIPE_QUEUE_LEN];
+	UI head;
+	UI count;
+	u8 eof_flag;
+	// Free chunks that can be reused:
+	u8 *spare[DFPIPE_QUEUE_LEN+2];
+	UI num_spare;
+	// The chunk currently being filled. Used only by the producer.
+	u8 *cur;
+	i64 cur_len;
+};
+
+struct dfpipe_ctx;
+
+struct dfpipe_stage {
+	struct dfpipe_ctx *pctx;
+	UI idx;
+	struct de_dfilter_ctx *dfctx; // Not used by stage 0
+	struct de_dfilter_out_params dcmpro;
+	struct de_dfilter_results dres;
+	dbuf *outf; // NULL for the last stage
+	i64 nbytes_written;
+	// Threaded mode only. The queue that this stage reads from, or NULL if
+	// this stage is run by the previous stage's thread.
+	struct dfpipe_queue *inq;
+	struct de_threadinfo *thread;
+};
+
+struct dfpipe_ctx {
+	deark *c;
+	UI num_stages;
+	struct dfpipe_stage *st; // array[num_stages]
+};
+
+static struct dfpipe_queue *dfpipe_queue_create(deark *c)
+{
+	struct dfpipe_queue *q;
+	struct de_syncobj *so;
+
+	so = de_syncobj_create(c);
+	if(!so) return NULL;
+	q = de_malloc(c, sizeof(struct dfpipe_queue));
+	q->so = so;
+	return q;
+}
+
+static void dfpipe_queue_destroy(deark *c, struct dfpipe_queue *q)
+{
+	UI i;
+
+	if(!q) return;
+	for(i=0; i<q->count; i++) {
+		de_free(c, q->chunks[(q->head+i)%DFPIPE_QUEUE_LEN]);
+	}
+	for(i=0; i<q->num_spare; i++) {
+		de_free(c, q->spare[i]);
+	}
+	de_free(c, q->cur);
+	de_syncobj_destroy(c, q->so);
+	de_free(c, q);
+}
+
+static u8 *dfpipe_queue_get_chunk(deark *c, struct dfpipe_queue *q)
+{
+	u8 *chunk = NULL;
+
+	de_syncobj_lock(q->so);
+	if(q->num_spare>0) {
+		chunk = q->spare[--q->num_spare];
+	}
+	de_syncobj_unlock(q->so);
+
+	if(!chunk) {
+		chunk = de_malloc(c, DFPIPE_CHUNK_SIZE);
+	}
+	return chunk;
+}
+
+static void dfpipe_queue_recycle_chunk(deark *c, struct dfpipe_queue *q, u8 *chunk)
 {
-	dbuf *outf_codec1 = NULL;
-	struct de_dfilter_out_params dcmpro_codec1;
-	struct de_dfilter_results dres_codec2;
-	struct my_2layer_userdata u;
-	struct de_dfilter_ctx *dfctx_codec2 = NULL;
+	de_syncobj_lock(q->so);
+	if(q->num_spare < (UI)DE_ARRAYCOUNT(q->spare)) {
+		q->spare[q->num_spare++] = chunk;
+		chunk = NULL;
+	}
+	de_syncobj_unlock(q->so);
+	de_free(c, chunk);
+}
 
-	de_dfilter_init_objects(c, NULL, &dcmpro_codec1, NULL);
-	de_dfilter_init_objects(c, NULL, NULL, &dres_codec2);
-	de_zeromem(&u, sizeof(struct my_2layer_userdata));
+// Hand the current chunk to the consumer, waiting for room if necessary.
+static void dfpipe_queue_push(struct dfpipe_queue *q)
+{
+	UI k;
 
-	// Make a custom dbuf. The output from the first decompressor will be written
-	// to it, and it will relay that output to the second decompressor.
-	outf_codec1 = dbuf_create_custom_dbuf(c, 0, 0);
-	dbuf_enable_wbuffer(outf_codec1);
-	outf_codec1->userdata_for_customwrite = (void*)&u;
-	outf_codec1->customwrite_fn = my_2layer_write_cb;
+	if(!q->cur) return;
+	if(q->cur_len<1) return;
 
-	dcmpro_codec1.f = outf_codec1;
-	if(tlp->intermed_len_known) {
-		dcmpro_codec1.len_known = 1;
-		dcmpro_codec1.expected_len = tlp->intermed_expected_len;
+	de_syncobj_lock(q->so);
+	while(q->count >= DFPIPE_QUEUE_LEN) {
+		de_syncobj_wait(q->so);
+	}
+	k = (q->head + q->count) % DFPIPE_QUEUE_LEN;
+	q->chunks[k] = q->cur;
+	q->chunk_len[k] = q->cur_len;
+	q->count++;
+	de_syncobj_broadcast(q->so);
+	de_syncobj_unlock(q->so);
+
+	q->cur = NULL;
+	q->cur_len = 0;
+}
+
+static void dfpipe_queue_write(deark *c, struct dfpipe_queue *q, const u8 *buf, i64 size)
+{
+	while(size>0) {
+		i64 n;
+
+		if(!q->cur) {
+			q->cur = dfpipe_queue_get_chunk(c, q);
+			q->cur_len = 0;
+		}
+
+		n = de_min_int(size, DFPIPE_CHUNK_SIZE - q->cur_len);
+		de_memcpy(&q->cur[q->cur_len], buf, (size_t)n);
+		q->cur_len += n;
+		buf += n;
+		size -= n;
+
+		if(q->cur_len >= DFPIPE_CHUNK_SIZE) {
+			dfpipe_queue_push(q);
+		}
+	}
+}
+
+// Called by the producer when it has no more data.
+static void dfpipe_queue_close(struct dfpipe_queue *q)
+{
+	dfpipe_queue_push(q);
+	de_syncobj_lock(q->so);
+	q->eof_flag = 1;
+	de_syncobj_broadcast(q->so);
+	de_syncobj_unlock(q->so);
+}
+
+static void dfpipe_write_cb(dbuf *f, void *userdata,
+	const u8 *buf, i64 size)
+{
+	struct dfpipe_stage *st = (struct dfpipe_stage*)userdata;
+	struct dfpipe_stage *next = &st->pctx->st[st->idx+1];
+
+	st->nbytes_written += size;
+	if(next->inq) {
+		dfpipe_queue_write(st->pctx->c, next->inq, buf, size);
 	}
 	else {
-		dcmpro_codec1.len_known = 0;
-		dcmpro_codec1.expected_len = 0;
+		de_dfilter_addbuf(next->dfctx, buf, size);
 	}
+}
+
+// Called when stage st will produce no more output.
+static void dfpipe_end_output(struct dfpipe_stage *st)
+{
+	struct dfpipe_stage *next;
 
-	dfctx_codec2 = de_dfilter_create(c, tlp->codec2, tlp->codec2_private_params, tlp->dcmpro, &dres_codec2);
-	u.dfctx_codec2 = dfctx_codec2;
+	if(!st->outf) return;
+	dbuf_flush(st->outf);
 
-	// The first codec in the chain does not need the advanced (de_dfilter_create) API.
-	if(tlp->codec1_type1) {
-		tlp->codec1_type1(c, tlp->dcmpri, &dcmpro_codec1, tlp->dres, tlp->codec1_private_params);
+	next = &st->pctx->st[st->idx+1];
+	if(next->inq) {
+		dfpipe_queue_close(next->inq);
 	}
 	else {
-		de_dfilter_decompress_oneshot(c, tlp->codec1_pushable, tlp->codec1_private_params,
-			tlp->dcmpri, &dcmpro_codec1, tlp->dres);
+		de_dfilter_finish(next->dfctx);
+		dfpipe_end_output(next);
 	}
-	dbuf_flush(outf_codec1);
-	de_dfilter_finish(dfctx_codec2);
+}
 
-	if(tlp->dres->errcode) goto done;
-	de_dbg2(c, "size after intermediate decompression: %"I64_FMT, u.intermediate_nbytes);
+static void dfpipe_thread_main(void *userdata)
+{
+	struct dfpipe_stage *st = (struct dfpipe_stage*)userdata;
+	struct dfpipe_queue *q = st->inq;
+	deark *c = st->pctx->c;
 
-	if(dres_codec2.errcode) {
-		// An error occurred in codec2, and not in codec1.
-		// Copy the error info to the dres that will be returned to the caller.
-		de_dfilter_transfer_error(c, &dres_codec2, tlp->dres);
-		goto done;
+	while(1) {
+		u8 *chunk;
+		i64 chunk_len;
+
+		de_syncobj_lock(q->so);
+		while(q->count==0 && !q->eof_flag) {
+			de_syncobj_wait(q->so);
+		}
+		if(q->count==0) {
+			de_syncobj_unlock(q->so);
+			break;
+		}
+		chunk = q->chunks[q->head];
+		chunk_len = q->chunk_len[q->head];
+		q->head = (q->head+1) % DFPIPE_QUEUE_LEN;
+		q->count--;
+		de_syncobj_broadcast(q->so);
+		de_syncobj_unlock(q->so);
+
+		// If the codec has stopped, this does nothing, but we still have to
+		// drain the queue.
+		de_dfilter_addbuf(st->dfctx, chunk, chunk_len);
+		dfpipe_queue_recycle_chunk(c, q, chunk);
+	}
+
+	de_dfilter_finish(st->dfctx);
+	dfpipe_end_output(st);
+}
+
+// Start a thread for each stage after the first, if possible.
+static void dfpipe_start_threads(struct dfpipe_ctx *pctx)
+{
+	deark *c = pctx->c;
+	UI i;
+
+	// A stage's thread may need to know whether the next stage has a thread,
+	// so start them from last to first.
+	for(i=pctx->num_stages-1; i>=1; i--) {
+		struct dfpipe_stage *st = &pctx->st[i];
+
+		st->inq = dfpipe_queue_create(c);
+		if(!st->inq) break;
+		st->thread = de_thread_create(c, dfpipe_thread_main, (void*)st);
+		if(!st->thread) {
+			dfpipe_queue_destroy(c, st->inq);
+			st->inq = NULL;
+			break;
+		}
+	}
+}
+
+// Decompress data that was compressed with multiple methods, one after
+// another.
+// pp->stages[0] is the first one that will be used during decompression
+// (i.e. the last method used when *compressing*).
+// Errors from the first stage take priority, then the second, etc.
+void de_dfilter_decompress_pipeline(deark *c, struct de_dcmpr_pipeline_params *pp)
+{
+	struct dfpipe_ctx *pctx = NULL;
+	const struct de_dfilter_stage_params *sp;
+	u8 saved_objpool_disabled = c->objpool_disabled;
+	UI n;
+	UI i;
+
+	n = pp->num_stages;
+	if(n<1) goto done;
+
+	pctx = de_malloc(c, sizeof(struct dfpipe_ctx));
+	pctx->c = c;
+	pctx->num_stages = n;
+	pctx->st = de_mallocarray(c, (i64)n, sizeof(struct dfpipe_stage));
+
+	for(i=0; i<n; i++) {
+		struct dfpipe_stage *st = &pctx->st[i];
+
+		st->pctx = pctx;
+		st->idx = i;
+		de_dfilter_init_objects(c, NULL, &st->dcmpro, &st->dres);
+		if(i==n-1) break;
+
+		// Make a custom dbuf. The output from this stage will be written to it,
+		// and it will relay that output to the next stage.
+		st->outf = dbuf_create_custom_dbuf(c, 0, 0);
+		dbuf_enable_wbuffer(st->outf);
+		st->outf->userdata_for_customwrite = (void*)st;
+		st->outf->customwrite_fn = dfpipe_write_cb;
+
+		st->dcmpro.f = st->outf;
+		if(pp->stages[i].out_len_known) {
+			st->dcmpro.len_known = 1;
+			st->dcmpro.expected_len = pp->stages[i].out_expected_len;
+		}
+	}
+
+	for(i=1; i<n; i++) {
+		sp = &pp->stages[i];
+		pctx->st[i].dfctx = de_dfilter_create(c, sp->codec_pushable, sp->codec_private_params,
+			(i==n-1) ? pp->dcmpro : &pctx->st[i].dcmpro, &pctx->st[i].dres);
+	}
+
+	// Codecs may emit debugging messages, which would be out of order if
+	// they came from different threads.
+	if(n>1 && c->dfilter_threads && c->debug_level<1) {
+		// The object pool is not thread-safe.
+		saved_objpool_disabled = c->objpool_disabled;
+		c->objpool_disabled = 1;
+		dfpipe_start_threads(pctx);
+	}
+
+	// The first stage does not need the advanced (de_dfilter_create) API.
+	sp = &pp->stages[0];
+	if(sp->codec_type1) {
+		sp->codec_type1(c, pp->dcmpri, (n>1) ? &pctx->st[0].dcmpro : pp->dcmpro,
+			pp->dres, sp->codec_private_params);
+	}
+	else {
+		de_dfilter_decompress_oneshot(c, sp->codec_pushable, sp->codec_private_params,
+			pp->dcmpri, (n>1) ? &pctx->st[0].dcmpro : pp->dcmpro, pp->dres);
+	}
+	dfpipe_end_output(&pctx->st[0]);
+
+	for(i=1; i<n; i++) {
+		de_thread_join(c, pctx->st[i].thread);
+		pctx->st[i].thread = NULL;
+	}
+	c->objpool_disabled = saved_objpool_disabled;
+
+	if(pp->dres->errcode) goto done;
+	for(i=0; i+1<n; i++) {
+		de_dbg2(c, "size after intermediate decompression: %"I64_FMT,
+			pctx->st[i].nbytes_written);
+	}
+
+	for(i=1; i<n; i++) {
+		if(pctx->st[i].dres.errcode) {
+			// An error occurred in a later stage, and not in the first one.
+			// Copy the error info to the dres that will be returned to the caller.
+			de_dfilter_transfer_error(c, &pctx->st[i].dres, pp->dres);
+			goto done;
+		}
 	}
 
 done:
-	de_dfilter_destroy(dfctx_codec2);
-	dbuf_close(outf_codec1);
+	if(pctx) {
+		for(i=0; i<n; i++) {
+			struct dfpipe_stage *st = &pctx->st[i];
+
+			de_dfilter_destroy(st->dfctx);
+			dbuf_close(st->outf);
+			dfpipe_queue_destroy(c, st->inq);
+		}
+		de_free(c, pctx->st);
+		de_free(c, pctx);
+	}
+}
+
+// Decompress an arbitrary two-layer compressed format.
+// tlp->codec1* is the first one that will be used during decompression (i.e. the second
+// method used when during *compression*).
+void de_dfilter_decompress_two_layer(deark *c, struct de_dcmpr_two_layer_params *tlp)
+{
+	struct de_dfilter_stage_params stages[2];
+	struct de_dcmpr_pipeline_params pp;
+
+	de_zeromem(stages, sizeof(stages));
+	stages[0].codec_type1 = tlp->codec1_type1;
+	stages[0].codec_pushable = tlp->codec1_pushable;
+	stages[0].codec_private_params = tlp->codec1_private_params;
+	stages[0].out_len_known = tlp->intermed_len_known;
+	stages[0].out_expected_len = tlp->intermed_len_known ? tlp->intermed_expected_len : 0;
+	stages[1].codec_pushable = tlp->codec2;
+	stages[1].codec_private_params = tlp->codec2_private_params;
+
+	de_zeromem(&pp, sizeof(struct de_dcmpr_pipeline_params));
+	pp.num_stages = 2;
+	pp.stages = stages;
+	pp.dcmpri = tlp->dcmpri;
+	pp.dcmpro = tlp->dcmpro;
+	pp.dres = tlp->dres;
+	de_dfilter_decompress_pipeline(c, &pp);
 }
 
 struct de_lz77buffer *de_lz77buffer_create(deark *c, UI bufsize)
@@ -810,7 +1447,7 @@ struct de_lz77buffer *de_lz77buffer_create(deark *c, UI bufsize)
 	struct de_lz77buffer *rb;
 
 	rb = de_malloc(c, sizeof(struct de_lz77buffer));
-	rb->buf = de_malloc(c, (i64)bufsize);
+	rb->buf = de_pool_malloc(c, DE_OBJPOOL_LZ77BUFFER, (i64)bufsize, 0);
 	rb->bufsize = bufsize;
 	rb->mask = bufsize - 1;
 	return rb;
@@ -819,7 +1456,7 @@ struct de_lz77buffer *de_lz77buffer_create(deark *c, UI bufsize)
 void de_lz77buffer_destroy(deark *c, struct de_lz77buffer *rb)
 {
 	if(!rb) return;
-	de_free(c, rb->buf);
+	de_pool_free(c, DE_OBJPOOL_LZ77BUFFER, (i64)rb->bufsize, rb->buf);
 	de_free(c, rb);
 }
 
@@ -837,21 +1474,78 @@ void de_lz77buffer_set_curpos(struct de_lz77buffer *rb, UI newpos)
 
 void de_lz77buffer_add_literal_byte(struct de_lz77buffer *rb, u8 b)
 {
-	rb->writebyte_cb(rb, b);
-	rb->buf[rb->curpos] = b;
+	if(rb->write_span_cb) {
+		rb->buf[rb->curpos] = b;
+		rb->write_span_cb(rb, &rb->buf[rb->curpos], 1);
+	}
+	else {
+		rb->writebyte_cb(rb, b);
+		rb->buf[rb->curpos] = b;
+	}
 	rb->curpos = (rb->curpos+1) & rb->mask;
 }
 
+static void lz77buffer_emit(struct de_lz77buffer *rb, const u8 *buf, UI len)
+{
+	UI i;
+
+	if(rb->write_span_cb) {
+		rb->write_span_cb(rb, buf, len);
+		return;
+	}
+	for(i=0; i<len; i++) {
+		rb->writebyte_cb(rb, buf[i]);
+	}
+}
+
+// The result is the same as if each byte were copied one at a time, in order.
 void de_lz77buffer_copy_from_hist(struct de_lz77buffer *rb,
 	UI startpos, UI count)
 {
 	UI frompos;
-	UI i;
+	UI dist;
 
 	frompos = startpos & rb->mask;
-	for(i=0; i<count; i++) {
-		de_lz77buffer_add_literal_byte(rb, rb->buf[frompos]);
-		frompos = (frompos+1) & rb->mask;
+	// How far back the source is. If it's 0, the source is the bytes we're
+	// about to overwrite, which means they don't change.
+	dist = (rb->curpos - frompos) & rb->mask;
+
+	while(count>0) {
+		UI n;
+		u8 *dst = &rb->buf[rb->curpos];
+
+		// Don't let the source or destination wrap around.
+		n = count;
+		if(n > rb->bufsize - frompos) n = rb->bufsize - frompos;
+		if(n > rb->bufsize - rb->curpos) n = rb->bufsize - rb->curpos;
+
+		if(dist>0 && dist<n) {
+			UI nbytes_done;
+
+			// The source overlaps the destination, so the result is a
+			// repeating pattern.
+			if(dist==1) {
+				de_memset(dst, rb->buf[frompos], n);
+			}
+			else {
+				de_memcpy(dst, &rb->buf[frompos], dist);
+				nbytes_done = dist;
+				while(nbytes_done < n) {
+					UI k = de_min_int(nbytes_done, n-nbytes_done);
+
+					de_memcpy(&dst[nbytes_done], dst, k);
+					nbytes_done += k;
+				}
+			}
+		}
+		else if(dist>0) {
+			de_memmove(dst, &rb->buf[frompos], n);
+		}
+
+		lz77buffer_emit(rb, dst, n);
+		rb->curpos = (rb->curpos+n) & rb->mask;
+		frompos = (frompos+n) & rb->mask;
+		count -= n;
 	}
 }
 
@@ -14,6 +14,29 @@ struct fax34_huffman_tree {
 	struct fmtutil_huffman_decoder *_2d_codes;
 };
 
+// A lookup table for decoding fax codes. The first level is indexed by the
+// next l1_nbits bits of input. An entry can point to a second-level table,
+// indexed by the l2_nbits bits after that.
+// An entry with nbits==0 is a code (or prefix) that we can't decode this way,
+// so it is left to the Huffman tree decoder.
+struct fax34_lut_entry {
+	i16 val; // The decoded value, or the index of the 2nd-level table
+	u8 nbits; // Total code length
+	u8 is_ptr;
+};
+
+struct fax34_lut {
+	UI l1_nbits;
+	UI l2_nbits;
+	size_t num_entries;
+	struct fax34_lut_entry *e;
+};
+
+struct fax34_luts {
+	struct fax34_lut wb[2]; // [0]=white, [1]=black
+	struct fax34_lut _2d_codes;
+};
+
 struct fax_ctx {
 	struct de_dfilter_in_params *dcmpri;
 	struct de_dfilter_out_params *dcmpro;
@@ -27,12 +50,17 @@ struct fax_ctx {
 
 	i64 nbytes_written;
 	struct de_bitreader bitrd;
-
-	u8 *curr_row; // array[image_width]
-	u8 *prev_row; // array[image_width]
+	struct fax34_luts *luts;
+	struct fax34_huffman_tree *f34ht; // Created only if needed
 
 	i64 rowspan_final;
-	u8 *tmp_row_packed; // array[rowspan_final]
+	u8 *curr_row_packed; // array[rowspan_final], 1 bit/pixel, 1=black
+
+	// The reference (previous) row, as a list of the positions of its
+	// changing elements. Even-numbered changes are to black, odd to white.
+	i64 *ref_changes; // array[image_width]
+	i64 ref_nchanges;
+	i64 ref_idx; // A hint, for finding b1
 
 	i64 pending_run_len;
 	UI f2d_h_codes_remaining;
@@ -197,32 +225,223 @@ static void destroy_fax34_huffman_tree(deark *c, struct fax34_huffman_tree *f34h
 	de_free(c, f34ht);
 }
 
-static void fax34_on_eol(deark *c, struct fax_ctx *fc, int is_real)
+struct fax34_code_item {
+	u16 code;
+	u8 len;
+	i16 val;
+};
+
+static UI fax34_lut_index(UI x, UI nbits, int is_lsb)
 {
-	i64 i;
+	UI i;
+	UI y = 0;
 
-	de_dbg3(c, "%sEOL", is_real?"":"implicit ");
+	if(!is_lsb) return x;
+	// In LSB-first mode, the first bit of the code is the low bit of the index.
+	for(i=0; i<nbits; i++) {
+		if(x & (1U<<i)) y |= 1U<<(nbits-1-i);
+	}
+	return y;
+}
 
-	if(fc->ypos >= fc->image_height) goto done;
+static void fax34_build_lut(deark *c, struct fax34_lut *lut, UI l1_nbits, UI l2_nbits,
+	const struct fax34_code_item *codes, size_t ncodes, int is_lsb)
+{
+	size_t i;
+	UI k;
+	UI n_l1 = 1U<<l1_nbits;
+	UI nsub = 0;
+	UI next_sub;
+	u8 needsub[256];
+
+	lut->l1_nbits = l1_nbits;
+	lut->l2_nbits = l2_nbits;
+
+	// Find the prefixes of the long codes, each of which needs a 2nd-level table.
+	de_zeromem(needsub, sizeof(needsub));
+	for(i=0; i<ncodes; i++) {
+		if(codes[i].len > l1_nbits) {
+			k = (UI)codes[i].code >> (codes[i].len - l1_nbits);
+			if(!needsub[k]) {
+				needsub[k] = 1;
+				nsub++;
+			}
+		}
+	}
 
-	// [Pack curr_row into bits (tmp_row_packed)]
-	de_zeromem(fc->tmp_row_packed, (size_t)fc->rowspan_final);
-	for(i=0; i<fc->image_width; i++) {
-		if(fc->curr_row[i]) {
-			fc->tmp_row_packed[i/8] |= 1U<<(7-i%8);
+	lut->num_entries = (size_t)n_l1 + ((size_t)nsub<<l2_nbits);
+	lut->e = de_mallocarray(c, (i64)lut->num_entries, sizeof(struct fax34_lut_entry));
+
+	next_sub = n_l1;
+	for(k=0; k<n_l1; k++) {
+		if(needsub[k]) {
+			struct fax34_lut_entry *e = &lut->e[fax34_lut_index(k, l1_nbits, is_lsb)];
+
+			e->is_ptr = 1;
+			e->val = (i16)next_sub;
+			next_sub += 1U<<l2_nbits;
 		}
 	}
 
-	// [Write tmp_row_packed to fc->dcmpro]
-	dbuf_write(fc->dcmpro->f, fc->tmp_row_packed, fc->rowspan_final);
+	for(i=0; i<ncodes; i++) {
+		UI len = (UI)codes[i].len;
+		UI code = (UI)codes[i].code;
+		UI base = 0;
+		UI tblbits = l1_nbits;
+		UI f;
+
+		if(len > l1_nbits) {
+			base = (UI)lut->e[fax34_lut_index(code >> (len-l1_nbits), l1_nbits, is_lsb)].val;
+			len -= l1_nbits;
+			code &= (1U<<len)-1;
+			tblbits = l2_nbits;
+		}
+
+		// Fill in every entry whose index begins with this code.
+		for(f=0; f < (1U<<(tblbits-len)); f++) {
+			struct fax34_lut_entry *e;
+
+			e = &lut->e[base + fax34_lut_index((code<<(tblbits-len)) | f, tblbits, is_lsb)];
+			e->val = codes[i].val;
+			e->nbits = codes[i].len;
+		}
+	}
+}
+
+static struct fax34_luts *create_fax34_luts(deark *c, int need_2d, int is_lsb)
+{
+	struct fax34_luts *luts;
+	struct fax34_code_item items[105];
+	size_t i;
+	UI isblack;
+
+	luts = de_malloc(c, sizeof(struct fax34_luts));
+
+	for(isblack=0; isblack<2; isblack++) {
+		for(i=0; i<105; i++) {
+			items[i].code = isblack ? fax34blackcodes[i] : fax34whitecodes[i];
+			items[i].len = (u8)getfax34codelength(isblack, i);
+			items[i].val = (i16)getfax34val(i);
+		}
+		// Codes are up to 13 bits long
+		fax34_build_lut(c, &luts->wb[isblack], 8, 5, items, 105, is_lsb);
+	}
+
+	if(need_2d) {
+		for(i=0; i<DE_ARRAYCOUNT(fax34_2dcodes); i++) {
+			items[i].code = fax34_2dcodes[i];
+			items[i].len = fax34_2dcodelengths[i];
+			items[i].val = (i16)fax34_2dvals[i];
+		}
+		fax34_build_lut(c, &luts->_2d_codes, 7, 0, items, DE_ARRAYCOUNT(fax34_2dcodes),
+			is_lsb);
+	}
+
+	return luts;
+}
+
+static void destroy_fax34_luts(deark *c, struct fax34_luts *luts)
+{
+	if(!luts) return;
+	de_free(c, luts->wb[0].e);
+	de_free(c, luts->wb[1].e);
+	de_free(c, luts->_2d_codes.e);
+	de_free(c, luts);
+}
+
+// Read the next code, using a lookup table if possible, otherwise the Huffman
+// tree.
+// which: 0=white, 1=black, 2=2d.
+// Return value and *pval are the same as fmtutil_huffman_read_next_value().
+static int fax34_read_code(deark *c, struct fax_ctx *fc, UI which,
+	fmtutil_huffman_valtype *pval)
+{
+	const struct fax34_lut *lut;
+	struct fmtutil_huffman_decoder *ht;
+	UI orig_nbits_in_bitbuf;
+	u64 v;
+
+	lut = (which==2) ? &fc->luts->_2d_codes : &fc->luts->wb[which];
+	orig_nbits_in_bitbuf = fc->bitrd.bbll.nbits_in_bitbuf;
+
+	if(de_bitreader_peekbits(&fc->bitrd, lut->l1_nbits+lut->l2_nbits, &v)) {
+		const struct fax34_lut_entry *e;
+		UI i1, i2;
+
+		if(fc->bitrd.bbll.is_lsb) {
+			i1 = (UI)(v & ((1U<<lut->l1_nbits)-1));
+			i2 = (UI)(v >> lut->l1_nbits);
+		}
+		else {
+			i1 = (UI)(v >> lut->l2_nbits);
+			i2 = (UI)(v & ((1U<<lut->l2_nbits)-1));
+		}
+
+		e = &lut->e[i1];
+		if(e->is_ptr) {
+			e = &lut->e[(UI)e->val + i2];
+		}
+		if(e->nbits) {
+			de_bitreader_skip_peeked_bits(&fc->bitrd, e->nbits, orig_nbits_in_bitbuf);
+			*pval = (fmtutil_huffman_valtype)e->val;
+			return 1;
+		}
+		de_bitreader_skip_peeked_bits(&fc->bitrd, 0, orig_nbits_in_bitbuf);
+	}
+
+	// Near the end of the data, or a bad code.
+	if(!fc->f34ht) {
+		fc->f34ht = create_fax34_huffman_tree(c, (int)fc->is_2d);
+	}
+	ht = (which==2) ? fc->f34ht->_2d_codes : fc->f34ht->htwb[which];
+	return fmtutil_huffman_read_next_value(ht->bk, &fc->bitrd, pval, NULL);
+}
+
+// Make fc->ref_changes describe the row in fc->curr_row_packed.
+static void fax34_set_ref_row(struct fax_ctx *fc)
+{
+	i64 k;
+	i64 n = 0;
+	u8 color = 0;
+
+	for(k=0; k<fc->rowspan_final && k*8<fc->image_width; k++) {
+		UI b = (UI)fc->curr_row_packed[k];
+		UI j;
+
+		// Skip over bytes that have no changes.
+		if(b == (color ? 0xffU : 0x00U)) continue;
+
+		for(j=0; j<8; j++) {
+			u8 pixel = (u8)((b>>(7-j)) & 1);
+
+			if(pixel != color) {
+				if(k*8+(i64)j >= fc->image_width) break;
+				fc->ref_changes[n++] = k*8+(i64)j;
+				color = pixel;
+			}
+		}
+	}
+
+	fc->ref_nchanges = n;
+	fc->ref_idx = 0;
+}
+
+static void fax34_on_eol(deark *c, struct fax_ctx *fc, int is_real)
+{
+	de_dbg3(c, "%sEOL", is_real?"":"implicit ");
+
+	if(fc->ypos >= fc->image_height) goto done;
+
+	// The row is already packed; write it out.
+	dbuf_write(fc->dcmpro->f, fc->curr_row_packed, fc->rowspan_final);
 	fc->nbytes_written += fc->rowspan_final;
 
 	if(fc->is_2d) {
-		de_memcpy(fc->prev_row, fc->curr_row, (size_t)fc->image_width);
+		fax34_set_ref_row(fc);
 	}
 
-	// initialize curr_row
-	de_zeromem(fc->curr_row, (size_t)fc->image_width);
+	// initialize curr_row_packed
+	de_zeromem(fc->curr_row_packed, (size_t)fc->rowspan_final);
 
 	fc->ypos++;
 done:
@@ -233,13 +452,35 @@ done:
 	fc->have_read_tag_bit = 0;
 }
 
+// Set pixels x1 through x2-1 to black.
+static void fax34_set_black_pixels(struct fax_ctx *fc, i64 x1, i64 x2)
+{
+	u8 *row = fc->curr_row_packed;
+	i64 k1, k2;
+	u8 m1, m2;
+
+	if(x2 <= x1) return;
+	k1 = x1/8;
+	k2 = (x2-1)/8;
+	m1 = (u8)(0xff >> (UI)(x1%8));
+	m2 = (u8)(0xff << (UI)(7-(x2-1)%8));
+	if(k1==k2) {
+		row[k1] |= (m1 & m2);
+		return;
+	}
+	row[k1] |= m1;
+	if(k2 > k1+1) {
+		de_memset(&row[k1+1], 0xff, (size_t)(k2-k1-1));
+	}
+	row[k2] |= m2;
+}
+
 // Record run_len pixels as fc0->a0_color, updating fc->a0.
 // respect_negative_a0==0: If fc->a0 == -1, sets it to 0 first.
 // respect_negative_a0==1: If fc->a0 == -1, only sets rec_len-1 pixels.
 static void fax34_record_run(deark *c, struct fax_ctx *fc, i64 run_len,
 	int respect_negative_a0)
 {
-	i64 i;
 	u8 color = fc->a0_color;
 
 	de_dbg3(c, "run c=%u len=%d", (UI)color, (int)run_len);
@@ -254,10 +495,11 @@ static void fax34_record_run(deark *c, struct fax_ctx *fc, i64 run_len,
 	if(color==0) { // Pixels are initialized to 0, don't need to set them.
 		fc->a0 += run_len;
 	}
-	else {
-		for(i=0; (i<run_len) && (fc->a0 < fc->image_width); i++) {
-			fc->curr_row[fc->a0++] = color;
-		}
+	else if(run_len>0 && fc->a0 < fc->image_width) {
+		i64 x2 = de_min_int(fc->a0 + run_len, fc->image_width);
+
+		fax34_set_black_pixels(fc, fc->a0, x2);
+		fc->a0 = x2;
 	}
 
 	if(fc->a0 > fc->image_width) {
@@ -334,52 +576,41 @@ done:
 	return retval;
 }
 
-// Sets fc->b1 appropriately, according to fc->a0 and fc->prev_row and
-// fc->image_width.
-static void find_b1(struct fax_ctx *fc)
+// Sets fc->b1 (and fc->b2, if pb2 is set) appropriately, according to fc->a0
+// and the reference row, and fc->image_width.
+// b1 is the first changing element on the reference row to the right of a0,
+// of opposite color to a0_color. b2 is the next changing element after b1.
+static void find_b1_int(struct fax_ctx *fc, int want_b2)
 {
-	i64 i;
+	i64 k = fc->ref_idx;
+	const i64 *ch = fc->ref_changes;
 
-	for(i=fc->a0+1; i<fc->image_width; i++) {
-		if(i<0) continue;
+	// Find the first change to the right of a0. (a0 usually only increases,
+	// but not always.)
+	while(k>0 && ch[k-1] > fc->a0) k--;
+	while(k<fc->ref_nchanges && ch[k] <= fc->a0) k++;
+	fc->ref_idx = k;
 
-		// first prev_row pixel to the right of a0, of opposite color to a0_color
-		if(fc->prev_row[i]==fc->a0_color) continue;
+	// Even-numbered changes are to black (1), odd-numbered to white (0).
+	if((k%2==0) == (fc->a0_color!=0)) k++;
 
-		// Looking for a "changing element". I.e. if both it and the pixel to the left
-		// exist, they must have different colors.
-		if(i==0) {
-			// Leftmost pixel is "changing" if it is black
-			if(fc->prev_row[i]==0) continue;
-		}
-		else {
-			if(fc->prev_row[i-1] == fc->prev_row[i]) continue;
-		}
-
-		fc->b1 = i;
-		return;
+	fc->b1 = (k < fc->ref_nchanges) ? ch[k] : fc->image_width;
+	if(want_b2) {
+		fc->b2 = (k+1 < fc->ref_nchanges) ? ch[k+1] : fc->image_width;
 	}
-	fc->b1 = fc->image_width;
 }
 
-static void find_b1_and_b2(struct fax_ctx *fc)
+static void find_b1(struct fax_ctx *fc)
 {
-	i64 i;
-
-	find_b1(fc);
+	find_b1_int(fc, 0);
+}
 
-	for(i=fc->b1+1; i<fc->image_width; i++) {
-		// Looking for a "changing element", i.e. one having a different color from
-		// the pixel to its left.
-		if(fc->prev_row[i-1] == fc->prev_row[i]) continue;
-		fc->b2 = i;
-		return;
-	}
-	fc->b2 = fc->image_width;
+static void find_b1_and_b2(struct fax_ctx *fc)
+{
+	find_b1_int(fc, 1);
 }
 
-static void do_decompress_fax34(deark *c, struct fax_ctx *fc,
-	struct fax34_huffman_tree *f34ht)
+static void do_decompress_fax34(deark *c, struct fax_ctx *fc)
 {
 	char errmsg[100];
 	static const char errmsg_UNEXPECTEDEOD[] = "Unexpected end of compressed data";
@@ -458,7 +689,7 @@ static void do_decompress_fax34(deark *c, struct fax_ctx *fc,
 		}
 
 		if(in_2d_mode) {
-			ret = fmtutil_huffman_read_next_value(f34ht->_2d_codes->bk, &fc->bitrd, &val, NULL);
+			ret = fax34_read_code(c, fc, 2, &val);
 			if(!ret) {
 				if(fc->bitrd.eof_flag) {
 					de_strlcpy(errmsg, errmsg_UNEXPECTEDEOD, sizeof(errmsg));
@@ -514,7 +745,7 @@ static void do_decompress_fax34(deark *c, struct fax_ctx *fc,
 			}
 		}
 		else {
-			ret = fmtutil_huffman_read_next_value(f34ht->htwb[(UI)fc->a0_color]->bk, &fc->bitrd, &val, NULL);
+			ret = fax34_read_code(c, fc, (UI)fc->a0_color, &val);
 			if(!ret) {
 				if(fc->bitrd.eof_flag) {
 					de_strlcpy(errmsg, errmsg_UNEXPECTEDEOD, sizeof(errmsg));
@@ -581,7 +812,6 @@ void fmtutil_fax34_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 	void *codec_private_params)
 {
 	struct fax_ctx *fc = NULL;
-	struct fax34_huffman_tree *f34ht = NULL;
 
 	fc = de_malloc(c, sizeof(struct fax_ctx));
 	fc->modname = "fax_decode";
@@ -617,19 +847,20 @@ void fmtutil_fax34_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 		fc->rowspan_final = fc->fax34params->out_rowspan;
 	}
 
-	fc->curr_row = de_malloc(c, fc->image_width);
-	fc->prev_row = de_malloc(c, fc->image_width);
-	fc->tmp_row_packed = de_malloc(c, fc->rowspan_final);
+	fc->curr_row_packed = de_malloc(c, fc->rowspan_final);
+	if(fc->is_2d) {
+		fc->ref_changes = de_mallocarray(c, fc->image_width, sizeof(i64));
+	}
 
-	f34ht = create_fax34_huffman_tree(c, (int)fc->is_2d);
-	do_decompress_fax34(c, fc, f34ht);
+	fc->luts = create_fax34_luts(c, (int)fc->is_2d, (int)fc->fax34params->is_lsb);
+	do_decompress_fax34(c, fc);
 
 done:
-	destroy_fax34_huffman_tree(c, f34ht);
 	if(fc) {
-		de_free(c, fc->curr_row);
-		de_free(c, fc->prev_row);
-		de_free(c, fc->tmp_row_packed);
+		destroy_fax34_luts(c, fc->luts);
+		destroy_fax34_huffman_tree(c, fc->f34ht);
+		de_free(c, fc->curr_row_packed);
+		de_free(c, fc->ref_changes);
 		de_free(c, fc);
 	}
 }
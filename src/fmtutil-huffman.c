@@ -10,6 +10,8 @@
 
 #define NODE_REF_TYPE u32
 #define MAX_MAX_NODES  66000
+// Codes up to this many bits are decoded with a single table lookup.
+#define HUFFMAN_FAST_TABLE_MAX_BITS 10
 
 struct huffman_nval_pointer_data {
 	NODE_REF_TYPE noderef;
@@ -32,6 +34,17 @@ struct huffman_node {
 	union huffman_nval_data child[2];
 };
 
+// An item in the fast lookup table, which is indexed by the next few bits of
+// input.
+struct huffman_fast_entry {
+#define FASTSTATUS_INVALID 0
+#define FASTSTATUS_VALUE   1 // A complete code, 'nbits' long
+#define FASTSTATUS_POINTER 2 // A longer code. Continue decoding at node d.hnpd.
+	u8 status;
+	u8 nbits;
+	union huffman_nval_data d;
+};
+
 struct huffman_lengths_arr_item {
 	fmtutil_huffman_valtype val;
 	UI len;
@@ -57,6 +70,13 @@ struct fmtutil_huffman_codebook {
 
 	i64 num_codes;
 	UI max_bits;
+
+	// The fast lookup table. Built when needed, from the tree.
+	u8 fast_table_valid;
+	u8 fast_table_is_lsb; // Whether it's for an LSB-first bitreader
+	UI fast_table_nbits;
+	UI fast_table_alloc_nbits;
+	struct huffman_fast_entry *fast_table; // array[1<<fast_table_nbits]
 };
 
 // Ensure that at least n nodes are allocated (0 through n-1)
@@ -133,6 +153,7 @@ int fmtutil_huffman_add_code(deark *c, struct fmtutil_huffman_codebook *bk,
 	int retval = 0;
 
 	if(code_nbits>FMTUTIL_HUFFMAN_MAX_CODE_LENGTH) goto done;
+	bk->fast_table_valid = 0;
 
 	if(code_nbits<1) {
 		bk->value_of_null_code = val;
@@ -228,6 +249,94 @@ done:
 	return retval;
 }
 
+static void huffman_set_fast_entries(struct fmtutil_huffman_codebook *bk, UI prefix,
+	UI prefix_nbits, const struct huffman_fast_entry *e)
+{
+	UI num_free_bits = bk->fast_table_nbits - prefix_nbits;
+	UI k;
+
+	for(k=0; k<(1U<<num_free_bits); k++) {
+		UI idx;
+
+		if(bk->fast_table_is_lsb) {
+			// The first bit is the low bit of the index.
+			idx = prefix | (k<<prefix_nbits);
+		}
+		else {
+			// The first bit is the high bit of the index.
+			idx = (prefix<<num_free_bits) | k;
+		}
+		bk->fast_table[idx] = *e; // struct copy
+	}
+}
+
+// Recursively fill in the fast table entries for the subtree at node n.
+// prefix = the code bits leading to this node (in fast table index order).
+static void huffman_fill_fast_table(struct fmtutil_huffman_codebook *bk,
+	NODE_REF_TYPE n, UI depth, UI prefix)
+{
+	UI child_idx;
+
+	if(n>=bk->next_avail_node || n>=bk->nodes_alloc) return;
+
+	for(child_idx=0; child_idx<=1; child_idx++) {
+		struct huffman_fast_entry e;
+		UI prefix2;
+		u8 child_status = bk->nodes[n].child_status[child_idx];
+
+		if(bk->fast_table_is_lsb) {
+			prefix2 = prefix | (child_idx<<depth);
+		}
+		else {
+			prefix2 = (prefix<<1) | child_idx;
+		}
+
+		if(child_status==CHILDSTATUS_VALUE) {
+			e.status = FASTSTATUS_VALUE;
+			e.nbits = (u8)(depth+1);
+			e.d = bk->nodes[n].child[child_idx]; // union copy
+			huffman_set_fast_entries(bk, prefix2, depth+1, &e);
+		}
+		else if(child_status==CHILDSTATUS_POINTER) {
+			if(depth+1 < bk->fast_table_nbits) {
+				huffman_fill_fast_table(bk, bk->nodes[n].child[child_idx].hnpd.noderef,
+					depth+1, prefix2);
+			}
+			else {
+				e.status = FASTSTATUS_POINTER;
+				e.nbits = (u8)(depth+1);
+				e.d = bk->nodes[n].child[child_idx]; // union copy
+				huffman_set_fast_entries(bk, prefix2, depth+1, &e);
+			}
+		}
+		// (Unused children leave their entries as FASTSTATUS_INVALID.)
+	}
+}
+
+static void huffman_build_fast_table(deark *c, struct fmtutil_huffman_codebook *bk,
+	u8 is_lsb)
+{
+	UI nbits;
+
+	nbits = bk->max_bits;
+	if(nbits>HUFFMAN_FAST_TABLE_MAX_BITS) nbits = HUFFMAN_FAST_TABLE_MAX_BITS;
+	if(nbits<1) nbits = 1;
+
+	if(!bk->fast_table || bk->fast_table_alloc_nbits!=nbits) {
+		de_free(c, bk->fast_table);
+		bk->fast_table = de_mallocarray(c, (i64)1<<nbits, sizeof(struct huffman_fast_entry));
+		bk->fast_table_alloc_nbits = nbits;
+	}
+	else {
+		de_zeromem(bk->fast_table, ((size_t)1<<nbits) * sizeof(struct huffman_fast_entry));
+	}
+
+	bk->fast_table_nbits = nbits;
+	bk->fast_table_is_lsb = is_lsb;
+	huffman_fill_fast_table(bk, 0, 0, 0);
+	bk->fast_table_valid = 1;
+}
+
 // Read the next Huffman code from a bitreader, and decode it.
 // *pval will always be written to. On error, it will be set to 0.
 // pnbits returns the number of bits read. Can be NULL.
@@ -251,6 +360,38 @@ int fmtutil_huffman_read_next_value(struct fmtutil_huffman_codebook *bk,
 		goto done;
 	}
 
+	if(bk->next_avail_node>0) {
+		UI orig_nbits_in_bitbuf;
+		u64 idx;
+
+		if(!bk->fast_table_valid || bk->fast_table_is_lsb!=bitrd->bbll.is_lsb) {
+			huffman_build_fast_table(bitrd->f->c, bk, bitrd->bbll.is_lsb);
+		}
+
+		orig_nbits_in_bitbuf = bitrd->bbll.nbits_in_bitbuf;
+		if(de_bitreader_peekbits(bitrd, bk->fast_table_nbits, &idx)) {
+			const struct huffman_fast_entry *e = &bk->fast_table[idx];
+
+			if(e->status==FASTSTATUS_VALUE) {
+				de_bitreader_skip_peeked_bits(bitrd, e->nbits, orig_nbits_in_bitbuf);
+				*pval = e->d.hnvd.value;
+				bitcount = e->nbits;
+				retval = 1;
+				goto done;
+			}
+			else if(e->status==FASTSTATUS_POINTER) {
+				// A long code. Continue one bit at a time.
+				de_bitreader_skip_peeked_bits(bitrd, e->nbits, orig_nbits_in_bitbuf);
+				tmpcursor.curr_noderef = e->d.hnpd.noderef;
+				bitcount = e->nbits;
+			}
+			else {
+				// Bad code. Let the slow code handle it.
+				de_bitreader_skip_peeked_bits(bitrd, 0, orig_nbits_in_bitbuf);
+			}
+		}
+	}
+
 	while(1) {
 		int ret;
 		u8 b;
@@ -514,13 +655,11 @@ done:
 	return retval;
 }
 
-static struct fmtutil_huffman_codebook *huffman_create_codebook(deark *c,
+static void huffman_set_codebook_limits(deark *c, struct fmtutil_huffman_codebook *bk,
 	i64 initial_codes, i64 max_codes)
 {
-	struct fmtutil_huffman_codebook *bk;
 	i64 initial_nodes;
 
-	bk = de_malloc(c, sizeof(struct fmtutil_huffman_codebook));
 	if(max_codes>0) {
 		bk->max_nodes = max_codes;
 	}
@@ -542,25 +681,74 @@ static struct fmtutil_huffman_codebook *huffman_create_codebook(deark *c,
 	}
 
 	huffman_ensure_alloc(c, bk, (NODE_REF_TYPE)initial_nodes);
+}
+
+static struct fmtutil_huffman_codebook *huffman_create_codebook(deark *c,
+	i64 initial_codes, i64 max_codes)
+{
+	struct fmtutil_huffman_codebook *bk;
+
+	bk = de_malloc(c, sizeof(struct fmtutil_huffman_codebook));
+	huffman_set_codebook_limits(c, bk, initial_codes, max_codes);
 	bk->next_avail_node = 0;
 	bk->num_codes = 0;
 	bk->max_bits = 0;
 	return bk;
 }
 
+// Make bk empty, as if it were new, but keep its memory.
+static void huffman_reset_codebook(deark *c, struct fmtutil_huffman_codebook *bk,
+	i64 initial_codes, i64 max_codes)
+{
+	// Nodes past next_avail_node are never used, so are still zeroed.
+	if(bk->next_avail_node>0) {
+		de_zeromem(bk->nodes, (size_t)bk->next_avail_node * sizeof(struct huffman_node));
+	}
+	bk->next_avail_node = 0;
+	bk->has_null_code = 0;
+	bk->value_of_null_code = 0;
+	bk->num_codes = 0;
+	bk->max_bits = 0;
+	bk->fast_table_valid = 0;
+	huffman_set_codebook_limits(c, bk, initial_codes, max_codes);
+}
+
 static void huffman_destroy_codebook(deark *c, struct fmtutil_huffman_codebook *bk)
 {
 	if(!bk) return;
+	de_free(c, bk->fast_table);
 	de_free(c, bk->nodes);
 	de_free(c, bk);
 }
 
+static void huffman_destroy_decoder_now(deark *c, void *obj)
+{
+	struct fmtutil_huffman_decoder *ht = (struct fmtutil_huffman_decoder*)obj;
+
+	huffman_destroy_codebook(c, ht->bk);
+	ht->bk = NULL;
+	de_free(c, ht->builder->lengths_arr);
+	de_free(c, ht->builder);
+	de_free(c, ht->cursor);
+	de_free(c, ht);
+}
+
 // initial_codes: If not 0, pre-allocate enough nodes for this many codes.
 // max_codes: If not 0, attempting to add substantially more codes than this will fail.
+// Decoders are often created and destroyed many times in a row, so destroyed
+// decoders are kept in the object pool, and reused.
 struct fmtutil_huffman_decoder *fmtutil_huffman_create_decoder(deark *c, i64 initial_codes, i64 max_codes)
 {
 	struct fmtutil_huffman_decoder *ht = NULL;
 
+	ht = (struct fmtutil_huffman_decoder*)de_objpool_get(c, DE_OBJPOOL_HUFFMAN_DECODER, 0);
+	if(ht) {
+		huffman_reset_codebook(c, ht->bk, initial_codes, max_codes);
+		ht->builder->lengths_arr_numused = 0;
+		fmtutil_huffman_reset_cursor(ht->cursor);
+		return ht;
+	}
+
 	ht = de_malloc(c, sizeof(struct fmtutil_huffman_decoder));
 	ht->cursor = de_malloc(c, sizeof(struct fmtutil_huffman_cursor));
 	ht->bk = huffman_create_codebook(c, initial_codes, max_codes);
@@ -572,10 +760,5 @@ struct fmtutil_huffman_decoder *fmtutil_huffman_create_decoder(deark *c, i64 ini
 void fmtutil_huffman_destroy_decoder(deark *c, struct fmtutil_huffman_decoder *ht)
 {
 	if(!ht) return;
-	huffman_destroy_codebook(c, ht->bk);
-	ht->bk = NULL;
-	de_free(c, ht->builder->lengths_arr);
-	de_free(c, ht->builder);
-	de_free(c, ht->cursor);
-	de_free(c, ht);
+	de_objpool_put(c, DE_OBJPOOL_HUFFMAN_DECODER, 0, (void*)ht, huffman_destroy_decoder_now);
 }
@@ -32,7 +32,6 @@ struct lzh_ctx {
 	struct de_lz77buffer *ringbuf;
 	int ringbuf_owned_by_caller; // hack
 
-	u8 is_deflate64;
 	u8 is_lhark_lh7;
 	UI lh5x_literals_tree_max_codes;
 	UI lh5x_offsets_tree_fields_nbits;
@@ -46,7 +45,6 @@ struct lzh_ctx {
 	u8 implode_3_trees;
 	UI implode_min_match_len;
 	UI dist_code_extra_bits;
-	struct de_crcobj *crco;
 	i64 max_offset_used;
 };
 
@@ -63,7 +61,6 @@ static void destroy_lzh_ctx(struct lzh_ctx *cctx)
 		de_lz77buffer_destroy(c, cctx->ringbuf);
 		cctx->ringbuf = NULL;
 	}
-	if(cctx->crco) de_crcobj_destroy(cctx->crco);
 	de_free(c, cctx);
 }
 
@@ -556,34 +553,35 @@ static int lzh_have_enough_output(struct lzh_ctx *cctx)
 	return 0;
 }
 
-static void lzh_update_crc(struct lzh_ctx *cctx, u8 n)
+// Write up to len bytes, stopping if we have enough output.
+// Returns the number of bytes written.
+static UI lzh_write_output(struct lzh_ctx *cctx, const u8 *buf, UI len)
 {
-	de_crcobj_addbuf(cctx->crco, &n, 1);
+	if(cctx->dcmpro->len_known) {
+		i64 nbytes_wanted = cctx->dcmpro->expected_len - cctx->nbytes_written;
+
+		if(nbytes_wanted<=0) return 0;
+		if((i64)len > nbytes_wanted) len = (UI)nbytes_wanted;
+	}
+	dbuf_write(cctx->dcmpro->f, buf, (i64)len);
+	cctx->nbytes_written += (i64)len;
+	return len;
 }
 
-static void lzh_lz77buf_writebytecb(struct de_lz77buffer *rb, u8 n)
+static void lzh_lz77buf_writespancb(struct de_lz77buffer *rb, const u8 *buf, UI len)
 {
 	struct lzh_ctx *cctx = (struct lzh_ctx*)rb->userdata;
 
-	if(lzh_have_enough_output(cctx)) {
-		return;
-	}
-	dbuf_writebyte(cctx->dcmpro->f, n);
-	if(cctx->crco) lzh_update_crc(cctx, n);
-	cctx->nbytes_written++;
+	(void)lzh_write_output(cctx, buf, len);
 }
 
-static void lzh_lz77buf_writebytecb_flagerrors(struct de_lz77buffer *rb, u8 n)
+static void lzh_lz77buf_writespancb_flagerrors(struct de_lz77buffer *rb, const u8 *buf, UI len)
 {
 	struct lzh_ctx *cctx = (struct lzh_ctx*)rb->userdata;
 
-	if(lzh_have_enough_output(cctx)) {
+	if(lzh_write_output(cctx, buf, len) < len) {
 		cctx->err_flag = 1;
-		return;
 	}
-	dbuf_writebyte(cctx->dcmpro->f, n);
-	if(cctx->crco) lzh_update_crc(cctx, n);
-	cctx->nbytes_written++;
 }
 
 static void decompress_lh5x_internal(struct lzh_ctx *cctx, struct de_lh5x_params *lzhp)
@@ -626,7 +624,7 @@ static void decompress_lh5x_internal(struct lzh_ctx *cctx, struct de_lh5x_params
 
 	cctx->ringbuf = de_lz77buffer_create(cctx->c, rb_size);
 	cctx->ringbuf->userdata = (void*)cctx;
-	cctx->ringbuf->writebyte_cb = lzh_lz77buf_writebytecb;
+	cctx->ringbuf->write_span_cb = lzh_lz77buf_writespancb;
 	if(lzhp->history_fill_val!=0x00) {
 		de_lz77buffer_clear(cctx->ringbuf, lzhp->history_fill_val);
 	}
@@ -689,437 +687,818 @@ void fmtutil_lh5x_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 
 //////////////////// Deflate - native decoder (not miniz)
 
-static UI deflate_decode_length(deark *c, struct lzh_ctx *cctx, UI code)
+// This is a table-driven decoder, separate from the generic LZH engine
+// used by the other formats in this file.
+// Each Huffman code is decoded with one lookup in a table indexed by the
+// next INFL_*_TABLEBITS bits of input (plus, for longer codes, one lookup
+// in a subtable). Table entries for length and distance codes also record
+// the base value and number of extra bits, so a length or distance, and its
+// extra bits, can be decoded in one step.
+// Output is decoded into a flat buffer that holds the sliding window
+// followed by the new data, so matches never have to wrap around.
+
+#define INFL_LITLEN_TABLEBITS  10
+#define INFL_DIST_TABLEBITS    8
+#define INFL_CODELEN_TABLEBITS 7
+// Primary table, plus at most one subtable (up to 2^(15-TABLEBITS)
+// entries) per code that doesn't fit in the primary table.
+#define INFL_LITLEN_TABLESIZE  ((1<<INFL_LITLEN_TABLEBITS) + 288*(1<<(15-INFL_LITLEN_TABLEBITS)))
+#define INFL_DIST_TABLESIZE    ((1<<INFL_DIST_TABLEBITS) + 32*(1<<(15-INFL_DIST_TABLEBITS)))
+#define INFL_CODELEN_TABLESIZE (1<<INFL_CODELEN_TABLEBITS)
+
+// Size of the part of the output buffer that follows the window.
+#define INFL_OUTCHUNK_SIZE     262144
+#define INFL_INBUF_SIZE        65536
+
+// Table entry format:
+//  bits 0-7: Number of bits in the code (for a subtable pointer: the number
+//    of bits used to index the primary table)
+//  bits 8-12: Number of extra bits (for a subtable pointer: the number of
+//    bits used to index the subtable)
+//  bits 13-15: INFL_KIND_*
+//  bits 16-31: The literal value, or base length or distance (for a subtable
+//    pointer: the index of the subtable)
+#define INFL_KIND_LIT      0
+#define INFL_KIND_LEN      1
+#define INFL_KIND_EOB      2
+#define INFL_KIND_DIST     3
+#define INFL_KIND_SUBTABLE 4
+#define INFL_KIND_INVALID  5
+#define INFL_ENTRY(kind, val, nextra) \
+	(((u32)(val)<<16) | ((u32)(kind)<<13) | ((u32)(nextra)<<8))
+#define INFL_E_NBITS(e)  ((UI)((e) & 0xff))
+#define INFL_E_NEXTRA(e) ((UI)(((e)>>8) & 0x1f))
+#define INFL_E_KIND(e)   ((UI)(((e)>>13) & 0x7))
+#define INFL_E_VAL(e)    ((UI)((e)>>16))
+
+struct inflate_ctx {
+	deark *c;
+	struct de_dfilter_in_params *dcmpri;
+	struct de_dfilter_out_params *dcmpro;
+	struct de_dfilter_results *dres;
+	const char *modname;
+	u8 is_deflate64;
+	u8 err_flag;
+	u8 stop_flag; // Set if we have all the output we need
+
+	// Bits not yet consumed are the low bitcount bits of bitbuf. Bits above
+	// that may also contain valid data (the bits that follow), but may not
+	// be relied on.
+	u64 bitbuf;
+	UI bitcount;
+	// Number of 0-valued bits appended after the end of the input. If bits
+	// beyond the end of input are consumed, padding_bits > bitcount.
+	UI padding_bits;
+
+	const u8 *in_ptr; // Next byte to load into bitbuf
+	const u8 *in_end;
+	const u8 *in_chunk_start;
+	i64 in_chunk_filepos; // File position corresponding to in_chunk_start
+	i64 in_next_filepos; // File position of the first byte not yet in a chunk
+	i64 in_endpos;
+	u8 *inbuf; // Used if the input is not resident in memory
+
+	u8 *outbuf; // Window (wsize bytes), followed by INFL_OUTCHUNK_SIZE bytes
+	UI wsize;
+	UI outbuf_size;
+	UI outpos;
+	UI flushpos; // Bytes before this have been written to the output file
+	UI out_limit; // Flush before decoding a symbol if outpos is beyond this
+	i64 outpos_at_eof; // -1 if not known
+	i64 nbytes_written;
+
+	struct de_crcobj *adler_crco; // Used for zlib
+	struct de_crcobj *crco_for_output; // Owned by the caller
+	struct de_lz77buffer *ringbuf_to_use; // Owned by the caller
+
+	u32 litlen_syms[288];
+	u32 dist_syms[32];
+	u32 litlen_table[INFL_LITLEN_TABLESIZE];
+	u32 dist_table[INFL_DIST_TABLESIZE];
+	u32 codelen_table[INFL_CODELEN_TABLESIZE];
+};
+
+static const u16 infl_len_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17,
+	19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const u8 infl_len_nextra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
+	2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const u16 infl_dist_base[32] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49,
+	65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577, 32769, 49153 };
+static const u8 infl_dist_nextra[32] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4,
+	5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14 };
+
+static void infl_set_error(struct inflate_ctx *ictx, const char *msg)
+{
+	de_dfilter_set_errorf(ictx->c, ictx->dres, ictx->modname, "%s", msg);
+	ictx->err_flag = 1;
+}
+
+// Makes a new chunk of input available at in_ptr.
+// Returns 0 if there is no more input.
+static int infl_load_input_chunk(struct inflate_ctx *ictx)
 {
-	UI length = 0;
-	UI more_bits_count = 0;
+	i64 nbytes_left;
+	i64 n;
+	const u8 *ptr;
+
+	nbytes_left = ictx->in_endpos - ictx->in_next_filepos;
+	if(nbytes_left<=0) return 0;
 
-	if(code<=264) {
-		length = code - 254;
-		more_bits_count = 0;
+	if(dbuf_get_span_direct(ictx->dcmpri->f, ictx->in_next_filepos, nbytes_left, &ptr)) {
+		n = nbytes_left;
 	}
-	else if(code>=265 && code<=284) {
-		more_bits_count = (code-261)/4;
-		length = ((4 + (code+3)%4) << more_bits_count) + 3;
+	else {
+		n = de_min_int(nbytes_left, INFL_INBUF_SIZE);
+		if(!dbuf_get_span_direct(ictx->dcmpri->f, ictx->in_next_filepos, n, &ptr)) {
+			if(!ictx->inbuf) {
+				ictx->inbuf = de_pool_malloc(ictx->c, DE_OBJPOOL_INFLATE_INBUF, INFL_INBUF_SIZE,
+					DE_POOLFLAG_NOZERO);
+			}
+			dbuf_read(ictx->dcmpri->f, ictx->inbuf, ictx->in_next_filepos, n);
+			ptr = ictx->inbuf;
+		}
 	}
-	else if(code==285) {
-		if(cctx->is_deflate64) {
-			length = 3;
-			more_bits_count = 16;
+
+	ictx->in_chunk_start = ptr;
+	ictx->in_ptr = ptr;
+	ictx->in_end = ptr + n;
+	ictx->in_chunk_filepos = ictx->in_next_filepos;
+	ictx->in_next_filepos += n;
+	return 1;
+}
+
+// Fills bitbuf as full as possible, one byte at a time. Used near the end of
+// an input chunk. After the end of input, 0 bits are added.
+static void infl_refill_slow(struct inflate_ctx *ictx)
+{
+	while(ictx->bitcount <= 56) {
+		if(ictx->in_ptr >= ictx->in_end) {
+			if(ictx->padding_bits==0) {
+				if(infl_load_input_chunk(ictx)) continue;
+				ictx->outpos_at_eof = (i64)ictx->outpos;
+			}
+			ictx->padding_bits += 8;
+			ictx->bitcount += 8;
+			continue;
 		}
-		else {
-			length = 258;
-			more_bits_count = 0;
+		ictx->bitbuf |= (u64)(*ictx->in_ptr) << ictx->bitcount;
+		ictx->in_ptr++;
+		ictx->bitcount += 8;
+	}
+
+	if(ictx->padding_bits > ictx->bitcount && !ictx->err_flag) {
+		infl_set_error(ictx, "Unexpected end of input");
+		// Discard any output that was decoded from bits past the end
+		if(ictx->outpos_at_eof >= (i64)ictx->flushpos) {
+			ictx->outpos = (UI)ictx->outpos_at_eof;
 		}
 	}
+}
+
+static u64 infl_load_u64le(const u8 *m)
+{
+	UI i;
+	u64 val = 0;
+
+	for(i=0; i<8; i++) {
+		val |= ((u64)m[i])<<(i*8);
+	}
+	return val;
+}
+
+// Ensure there are at least 56 bits in bitbuf.
+static void infl_refill(struct inflate_ctx *ictx)
+{
+	if(ictx->in_end - ictx->in_ptr >= 8) {
+		ictx->bitbuf |= infl_load_u64le(ictx->in_ptr) << ictx->bitcount;
+		ictx->in_ptr += (63 - ictx->bitcount) >> 3;
+		ictx->bitcount |= 56;
+	}
 	else {
-		de_dfilter_set_errorf(c, cctx->dres, cctx->modname, "Bad length code");
-		cctx->err_flag = 1;
-		goto done;
+		infl_refill_slow(ictx);
 	}
+}
 
-	if(more_bits_count>0) {
-		UI more_bits_val;
+// nbits must be <=32
+static UI infl_getbits(struct inflate_ctx *ictx, UI nbits)
+{
+	UI n;
 
-		more_bits_val = (UI)lzh_getbits(cctx, more_bits_count);
-		length += more_bits_val;
-	}
+	if(ictx->bitcount < nbits) infl_refill(ictx);
+	n = (UI)(ictx->bitbuf & (((u64)1 << nbits)-1));
+	ictx->bitbuf >>= nbits;
+	ictx->bitcount -= nbits;
+	return n;
+}
 
-done:
-	return length;
+static void infl_skip_to_byte_boundary(struct inflate_ctx *ictx)
+{
+	UI n = ictx->bitcount % 8;
+
+	ictx->bitbuf >>= n;
+	ictx->bitcount -= n;
+}
+
+// The file position of the next byte that has not been entirely consumed.
+static i64 infl_get_curpos(struct inflate_ctx *ictx, UI *pnbits_used)
+{
+	UI real_bits;
+	i64 pos;
+
+	real_bits = ictx->bitcount;
+	if(ictx->padding_bits >= real_bits) real_bits = 0;
+	else real_bits -= ictx->padding_bits;
+
+	pos = ictx->in_chunk_filepos + (i64)(ictx->in_ptr - ictx->in_chunk_start);
+	pos -= (i64)((real_bits+7)/8);
+	if(pnbits_used) *pnbits_used = (8 - real_bits%8)%8;
+	return pos;
 }
 
-static UI deflate_read_and_decode_distance(deark *c, struct lzh_ctx *cctx)
+// Decodes one symbol, for the slow paths. Returns the table entry,
+// after consuming its code bits (but not its extra bits).
+static u32 infl_read_sym(struct inflate_ctx *ictx, const u32 *table, UI tablebits)
 {
-	UI dist_code;
-	UI dist = 0;
-	UI more_bits_count;
-	UI more_bits_val;
+	u32 e;
+
+	if(ictx->bitcount < 15) infl_refill(ictx);
+	e = table[ictx->bitbuf & ((1U<<tablebits)-1)];
+	if(INFL_E_KIND(e)==INFL_KIND_SUBTABLE) {
+		ictx->bitbuf >>= tablebits;
+		ictx->bitcount -= tablebits;
+		e = table[INFL_E_VAL(e) + (UI)(ictx->bitbuf & ((1U<<INFL_E_NEXTRA(e))-1))];
+	}
+	ictx->bitbuf >>= INFL_E_NBITS(e);
+	ictx->bitcount -= INFL_E_NBITS(e);
+	return e;
+}
 
-	dist_code = read_next_code_using_tree(cctx, &cctx->offsets_tree);
-	if(dist_code<=3) {
-		dist = dist_code;
-		more_bits_count = 0;
+// Builds a decoding table from a list of code lengths, in the manner of
+// fmtutil_huffman_make_canonical_code().
+// sym_entries[n] is the table entry to use for symbol n, minus its code length.
+static int infl_build_table(struct inflate_ctx *ictx, const u8 *lens, UI nsyms,
+	const u32 *sym_entries, UI tablebits, u32 *table, UI table_capacity)
+{
+	UI count[16];
+	UI next_code[16];
+	u16 codes[288];
+	u8 sub_maxlen[1<<INFL_LITLEN_TABLEBITS];
+	UI primary_size = 1U<<tablebits;
+	UI next_free;
+	UI s, i, len;
+	UI code;
+	int left;
+
+	de_zeromem(count, sizeof(count));
+	for(s=0; s<nsyms; s++) {
+		count[lens[s]]++;
+	}
+	count[0] = 0;
+
+	left = 1;
+	for(len=1; len<=15; len++) {
+		left <<= 1;
+		left -= (int)count[len];
+		if(left<0) return 0; // Over-subscribed
+	}
+	// (Incomplete codes are allowed. Unused codes decode as "invalid".)
+
+	code = 0;
+	next_code[0] = 0;
+	for(len=1; len<=15; len++) {
+		code = (code + count[len-1]) << 1;
+		next_code[len] = code;
+	}
+
+	// Assign codes, bit-reversed, since Deflate stores them starting with the
+	// most significant bit.
+	for(s=0; s<nsyms; s++) {
+		UI fwd, rev;
+
+		len = lens[s];
+		if(len==0) continue;
+		fwd = next_code[len]++;
+		rev = 0;
+		for(i=0; i<len; i++) {
+			rev = (rev<<1) | ((fwd>>i) & 1);
+		}
+		codes[s] = (u16)rev;
 	}
-	else if(dist_code<=29 || (cctx->is_deflate64 && dist_code<=31)) {
-		more_bits_count = (dist_code/2)-1;
-		dist = (2 + dist_code%2) << more_bits_count;
+
+	for(i=0; i<primary_size; i++) {
+		table[i] = INFL_ENTRY(INFL_KIND_INVALID, 0, 0);
 	}
-	else {
-		de_dfilter_set_errorf(c, cctx->dres, cctx->modname, "Bad distance code");
-		cctx->err_flag = 1;
-		goto done;
+
+	// Allocate subtables
+	de_zeromem(sub_maxlen, primary_size);
+	for(s=0; s<nsyms; s++) {
+		if(lens[s]>tablebits) {
+			UI p = codes[s] & (primary_size-1);
+
+			if(lens[s] > sub_maxlen[p]) sub_maxlen[p] = lens[s];
+		}
 	}
+	next_free = primary_size;
+	for(i=0; i<primary_size; i++) {
+		UI subbits;
 
-	if(more_bits_count > 0) {
-		more_bits_val = (UI)lzh_getbits(cctx, more_bits_count);
-		dist += more_bits_val;
+		if(sub_maxlen[i]==0) continue;
+		subbits = sub_maxlen[i] - tablebits;
+		if(next_free + (1U<<subbits) > table_capacity) return 0;
+		table[i] = INFL_ENTRY(INFL_KIND_SUBTABLE, next_free, subbits) | tablebits;
+		for(code=0; code<(1U<<subbits); code++) {
+			table[next_free+code] = INFL_ENTRY(INFL_KIND_INVALID, 0, 0);
+		}
+		next_free += 1U<<subbits;
 	}
 
-done:
-	return dist;
+	for(s=0; s<nsyms; s++) {
+		len = lens[s];
+		if(len==0) continue;
+		if(len<=tablebits) {
+			for(i=codes[s]; i<primary_size; i+=(1U<<len)) {
+				table[i] = sym_entries[s] | len;
+			}
+		}
+		else {
+			u32 pe = table[codes[s] & (primary_size-1)];
+			UI subsize = 1U<<INFL_E_NEXTRA(pe);
+			UI sublen = len - tablebits;
+
+			for(i=(UI)codes[s]>>tablebits; i<subsize; i+=(1U<<sublen)) {
+				table[INFL_E_VAL(pe)+i] = sym_entries[s] | sublen;
+			}
+		}
+	}
+
+	return 1;
 }
 
-// Call record_a_code_length() for a range of codes, all the same length
-static int huffman_record_len_for_range(deark *c, struct fmtutil_huffman_decoder *ht,
-	fmtutil_huffman_valtype range_start, i64 count, UI codelen)
+static void infl_init_sym_entries(struct inflate_ctx *ictx)
 {
-	i64 i;
+	UI s;
 
-	for(i=0; i<count; i++) {
-		int ret = fmtutil_huffman_record_a_code_length(c, ht->builder,
-			range_start+(fmtutil_huffman_valtype)i, codelen);
-		if(!ret) return 0;
+	for(s=0; s<288; s++) {
+		if(s<256) {
+			ictx->litlen_syms[s] = INFL_ENTRY(INFL_KIND_LIT, s, 0);
+		}
+		else if(s==256) {
+			ictx->litlen_syms[s] = INFL_ENTRY(INFL_KIND_EOB, 0, 0);
+		}
+		else if(s<=285) {
+			ictx->litlen_syms[s] = INFL_ENTRY(INFL_KIND_LEN, infl_len_base[s-257],
+				infl_len_nextra[s-257]);
+		}
+		else {
+			ictx->litlen_syms[s] = INFL_ENTRY(INFL_KIND_INVALID, 0, 0);
+		}
+	}
+	if(ictx->is_deflate64) {
+		ictx->litlen_syms[285] = INFL_ENTRY(INFL_KIND_LEN, 3, 16);
+	}
+
+	for(s=0; s<32; s++) {
+		if(s<30 || ictx->is_deflate64) {
+			ictx->dist_syms[s] = INFL_ENTRY(INFL_KIND_DIST, infl_dist_base[s],
+				infl_dist_nextra[s]);
+		}
+		else {
+			ictx->dist_syms[s] = INFL_ENTRY(INFL_KIND_INVALID, 0, 0);
+		}
 	}
-	return 1;
 }
 
-static int deflate_block_type1_make_fixed_trees(deark *c, struct lzh_ctx *cctx)
+// Writes any pending output, and slides the window to the start of outbuf.
+static void infl_flush_output(struct inflate_ctx *ictx)
 {
-	int retval = 0;
+	i64 n;
 
-	cctx->literals_tree.ht =  fmtutil_huffman_create_decoder(c, 288, 288);
-	huffman_record_len_for_range(c, cctx->literals_tree.ht, 0, 144, 8); // 0..143
-	huffman_record_len_for_range(c, cctx->literals_tree.ht, 144, 112, 9); // 144..255
-	huffman_record_len_for_range(c, cctx->literals_tree.ht, 256, 24, 7); // 256..279
-	huffman_record_len_for_range(c, cctx->literals_tree.ht, 280, 8, 8); // 280..287
-	if(!fmtutil_huffman_make_canonical_code(c, cctx->literals_tree.ht->bk,
-		cctx->literals_tree.ht->builder, 0, "lit/len codebook"))
-	{
-		goto done;
+	n = (i64)(ictx->outpos - ictx->flushpos);
+	if(ictx->dcmpro->len_known) {
+		i64 nbytes_wanted = ictx->dcmpro->expected_len - ictx->nbytes_written;
+
+		if(n > nbytes_wanted) {
+			n = de_max_int(nbytes_wanted, 0);
+			ictx->stop_flag = 1;
+		}
+	}
+
+	if(n>0) {
+		const u8 *buf = &ictx->outbuf[ictx->flushpos];
+
+		dbuf_write(ictx->dcmpro->f, buf, n);
+		if(ictx->adler_crco) de_crcobj_addbuf(ictx->adler_crco, buf, n);
+		if(ictx->crco_for_output) de_crcobj_addbuf(ictx->crco_for_output, buf, n);
+		ictx->nbytes_written += n;
 	}
 
-	// This is a trivial Huffman tree -- We could do without it and just read
-	// 5 bits directly, though we'd have to reverse the order of the bits.
-	cctx->offsets_tree.ht =  fmtutil_huffman_create_decoder(c, 32, 32);
-	huffman_record_len_for_range(c, cctx->offsets_tree.ht, 0, 32, 5);
-	if(!fmtutil_huffman_make_canonical_code(c, cctx->offsets_tree.ht->bk,
-		cctx->offsets_tree.ht->builder, 0, "offsets codebook"))
+	if(ictx->outpos > ictx->wsize) {
+		de_memmove(ictx->outbuf, &ictx->outbuf[ictx->outpos - ictx->wsize], ictx->wsize);
+		ictx->outpos = ictx->wsize;
+		ictx->outpos_at_eof = -1;
+	}
+	ictx->flushpos = ictx->outpos;
+}
+
+static int infl_make_fixed_tables(struct inflate_ctx *ictx)
+{
+	u8 lens[288];
+
+	de_memset(&lens[0], 8, 144);
+	de_memset(&lens[144], 9, 112);
+	de_memset(&lens[256], 7, 24);
+	de_memset(&lens[280], 8, 8);
+	if(!infl_build_table(ictx, lens, 288, ictx->litlen_syms, INFL_LITLEN_TABLEBITS,
+		ictx->litlen_table, INFL_LITLEN_TABLESIZE))
 	{
-		goto done;
+		return 0;
 	}
 
-	retval = 1;
-done:
-	return retval;
+	de_memset(lens, 5, 32);
+	if(!infl_build_table(ictx, lens, 32, ictx->dist_syms, INFL_DIST_TABLEBITS,
+		ictx->dist_table, INFL_DIST_TABLESIZE))
+	{
+		return 0;
+	}
+	return 1;
 }
 
-static int deflate_block_type2_read_trees(deark *c, struct lzh_ctx *cctx)
+static int infl_read_dynamic_tables(struct inflate_ctx *ictx)
 {
-	UI n;
-	UI i;
-	UI num_total_codes;
+	deark *c = ictx->c;
 	UI num_literal_codes;
 	UI num_dist_codes;
 	UI num_bit_length_codes;
-	int retval = 0;
-	int ret;
+	UI num_total_codes;
+	UI i;
 	static const u8 cll_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11,
 		4, 12, 3, 13, 2, 14, 1, 15};
-	UI cll[19]; // sorted code length lengths
-	UI prev_code = 0;
-	UI num_rle_codes_left = 0;
-	int saved_indent_level;
+	u8 cll[19];
+	u32 codelen_syms[19];
+	u8 lens[288+32];
+
+	num_literal_codes = infl_getbits(ictx, 5) + 257;
+	num_dist_codes = infl_getbits(ictx, 5) + 1;
+	num_bit_length_codes = infl_getbits(ictx, 4) + 4;
+	de_dbg3(c, "num lit/len codes: %u", num_literal_codes);
+	de_dbg3(c, "num dist codes: %u", num_dist_codes);
+	de_dbg3(c, "num bit-length codes: %u", num_bit_length_codes);
+	if(num_literal_codes>286 || (num_dist_codes>30 && !ictx->is_deflate64)) {
+		infl_set_error(ictx, "Bad table definition");
+		return 0;
+	}
 
-	de_dbg_indent_save(c, &saved_indent_level);
-	lzh_destroy_trees(cctx);
+	// "Meta" table - An unencoded sequence of Huffman code lengths, used
+	// to define the code lengths in the rest of the table definition.
 	de_zeromem(cll, sizeof(cll));
-
-	n = (UI)lzh_getbits(cctx, 5);
-	num_literal_codes = n + 257;
-	de_dbg2(c, "num lit/len codes: %u", num_literal_codes);
-
-	n = (UI)lzh_getbits(cctx, 5);
-	num_dist_codes = n + 1;
-	de_dbg2(c, "num dist codes: %u", num_dist_codes);
-
-	n = (UI)lzh_getbits(cctx, 4);
-	num_bit_length_codes = n + 4;
-	de_dbg2(c, "num bit-length codes: %u", num_bit_length_codes);
-
-	// "Meta" tree - An unencoded sequence of Huffman code lengths, used
-	// to construct a Huffman tree containing the code values (which
-	// themselves are usually code lengths) used in the rest of the tree
-	// definition section.
-
-	cctx->meta_tree.ht = fmtutil_huffman_create_decoder(c, 19, 19);
 	for(i=0; i<num_bit_length_codes; i++) {
-		n = (UI)lzh_getbits(cctx, 3);
-		cll[(UI)cll_order[i]] = n;
-		if(c->debug_level>=3) {
-			de_dbg3(c, "%u. length[%u] = %u", i, (UI)cll_order[i], n);
-		}
+		cll[(UI)cll_order[i]] = (u8)infl_getbits(ictx, 3);
 	}
 	for(i=0; i<19; i++) {
-		if(cll[i]>0) {
-			fmtutil_huffman_record_a_code_length(c, cctx->meta_tree.ht->builder,
-				(fmtutil_huffman_valtype)i, cll[i]);
-		}
+		codelen_syms[i] = INFL_ENTRY(INFL_KIND_LIT, i, 0);
 	}
-
-	if(!fmtutil_huffman_make_canonical_code(c, cctx->meta_tree.ht->bk,
-		cctx->meta_tree.ht->builder, 0, "derived codelengths codebook"))
+	if(!infl_build_table(ictx, cll, 19, codelen_syms, INFL_CODELEN_TABLEBITS,
+		ictx->codelen_table, INFL_CODELEN_TABLESIZE))
 	{
-		goto done;
+		infl_set_error(ictx, "Bad table definition");
+		return 0;
 	}
 
-	cctx->literals_tree.ht = fmtutil_huffman_create_decoder(c, num_literal_codes, 286);
-	cctx->offsets_tree.ht = fmtutil_huffman_create_decoder(c, num_dist_codes, 32);
-
-	de_dbg3(c, "[main lit/len/offsets definition table]");
-	de_dbg_indent(c, 1);
 	num_total_codes = num_literal_codes + num_dist_codes;
-	for(i=0; i<num_total_codes; i++) {
+	i = 0;
+	while(i<num_total_codes) {
+		u32 e;
 		UI x;
-		const char *tblname;
-		UI code_bias;
-
-		if(i<num_literal_codes) {
-			tblname = "lit/len";
-			code_bias = 0;
-		}
-		else {
-			tblname = "offset";
-			code_bias = num_literal_codes;
+		UI count;
+		u8 val;
+
+		if(ictx->err_flag) return 0;
+		e = infl_read_sym(ictx, ictx->codelen_table, INFL_CODELEN_TABLEBITS);
+		if(INFL_E_KIND(e)!=INFL_KIND_LIT) {
+			infl_set_error(ictx, "Bad table definition");
+			return 0;
 		}
+		x = INFL_E_VAL(e);
 
-		if(num_rle_codes_left>0) {
-			x = prev_code;
-			num_rle_codes_left--;
+		if(x<=15) {
+			lens[i++] = (u8)x;
+			continue;
 		}
-		else {
-			x = read_next_code_using_tree(cctx, &cctx->meta_tree);
 
-			if(x<=15) {
-				prev_code = x;
-				de_dbg3(c, "%s %u codelen: %u", tblname, i-code_bias, x);
-			}
-			else if(x==16) { // Read next 2 bits, copy prev code 3-6 times
-				x = prev_code;
-				n = (UI)lzh_getbits(cctx, 2);
-				num_rle_codes_left = n + 3 - 1;
-				de_dbg3(c, "[next %u codes same as prev]", n+3);
-			}
-			else if(x==17) { // Read next 3 bits, next 3-10 codes are 0
-				x = 0;
-				prev_code = 0;
-				n = (UI)lzh_getbits(cctx, 3);
-				num_rle_codes_left = n + 3 - 1;
-				de_dbg3(c, "[next %u codes = 0]", n+3);
-			}
-			else if(x==18) { // Read next 7 bits, next 11-138 codes are 0
-				x = 0;
-				prev_code = 0;
-				n = (UI)lzh_getbits(cctx, 7);
-				num_rle_codes_left = n + 11 - 1;
-				de_dbg3(c, "[next %u codes = 0]", n+11);
-			}
-			else {
-				goto done;
+		if(x==16) { // Repeat previous code length 3-6 times
+			if(i==0) {
+				infl_set_error(ictx, "Bad table definition");
+				return 0;
 			}
+			val = lens[i-1];
+			count = 3 + infl_getbits(ictx, 2);
 		}
-
-		if(i<num_literal_codes) {
-			ret = fmtutil_huffman_record_a_code_length(c, cctx->literals_tree.ht->builder,
-				(fmtutil_huffman_valtype)i, x);
+		else if(x==17) { // 3-10 zeroes
+			val = 0;
+			count = 3 + infl_getbits(ictx, 3);
 		}
-		else {
-			ret = fmtutil_huffman_record_a_code_length(c, cctx->offsets_tree.ht->builder,
-				(fmtutil_huffman_valtype)(i-code_bias), x);
+		else { // 11-138 zeroes
+			val = 0;
+			count = 11 + infl_getbits(ictx, 7);
 		}
-		if(!ret) goto done;
-
+		if(i+count > num_total_codes) {
+			infl_set_error(ictx, "Bad table definition");
+			return 0;
+		}
+		de_memset(&lens[i], val, count);
+		i += count;
 	}
-	de_dbg_indent(c, -1);
 
-	if(!fmtutil_huffman_make_canonical_code(c, cctx->literals_tree.ht->bk,
-		cctx->literals_tree.ht->builder, 0, "derived lit/len codebook"))
+	if(!infl_build_table(ictx, lens, num_literal_codes, ictx->litlen_syms,
+		INFL_LITLEN_TABLEBITS, ictx->litlen_table, INFL_LITLEN_TABLESIZE))
 	{
-		goto done;
+		infl_set_error(ictx, "Bad lit/len table");
+		return 0;
 	}
-
-	if(!fmtutil_huffman_make_canonical_code(c, cctx->offsets_tree.ht->bk,
-		cctx->offsets_tree.ht->builder, 0, "derived offsets codebook"))
+	if(!infl_build_table(ictx, &lens[num_literal_codes], num_dist_codes, ictx->dist_syms,
+		INFL_DIST_TABLEBITS, ictx->dist_table, INFL_DIST_TABLESIZE))
 	{
-		goto done;
+		infl_set_error(ictx, "Bad distance table");
+		return 0;
 	}
-
-	retval = 1;
-done:
-	de_dbg_indent_restore(c, saved_indent_level);
-	return retval;
+	return 1;
 }
 
-static int lzh_do_deflate_block_type1_2(deark *c, struct lzh_ctx *cctx, UI blktype)
+// Decodes the compressed data of a block of type 1 or 2.
+// This is the decoder's inner loop. For speed, the state that changes most
+// often is kept in local variables, and written back before calling
+// anything that uses it.
+static int infl_decode_huffman_block(struct inflate_ctx *ictx)
 {
+	u64 bitbuf = ictx->bitbuf;
+	UI bitcount = ictx->bitcount;
+	const u8 *in_ptr = ictx->in_ptr;
+	u8 *outbuf = ictx->outbuf;
+	UI outpos = ictx->outpos;
+	const u32 *lt = ictx->litlen_table;
+	const u32 *dt = ictx->dist_table;
 	int retval = 0;
 
-	if(blktype==1) {
-		if(!deflate_block_type1_make_fixed_trees(c, cctx)) goto done;
-	}
-	else {
-		if(!deflate_block_type2_read_trees(c, cctx)) goto done;
-	}
+#define INFL_SAVE_STATE() do { ictx->bitbuf = bitbuf; ictx->bitcount = bitcount; \
+	ictx->in_ptr = in_ptr; ictx->outpos = outpos; } while(0)
+#define INFL_LOAD_STATE() do { bitbuf = ictx->bitbuf; bitcount = ictx->bitcount; \
+	in_ptr = ictx->in_ptr; outpos = ictx->outpos; } while(0)
+#define INFL_REFILL() do { \
+	if(ictx->in_end - in_ptr >= 8) { \
+		bitbuf |= infl_load_u64le(in_ptr) << bitcount; \
+		in_ptr += (63 - bitcount) >> 3; \
+		bitcount |= 56; \
+	} \
+	else { \
+		INFL_SAVE_STATE(); \
+		infl_refill_slow(ictx); \
+		INFL_LOAD_STATE(); \
+		if(ictx->err_flag) goto done; \
+	} } while(0)
+#define INFL_LOOKUP(e, table, tablebits) do { \
+	e = table[bitbuf & ((1U<<(tablebits))-1)]; \
+	if(INFL_E_KIND(e)==INFL_KIND_SUBTABLE) { \
+		bitbuf >>= (tablebits); \
+		bitcount -= (tablebits); \
+		e = table[INFL_E_VAL(e) + (UI)(bitbuf & ((1U<<INFL_E_NEXTRA(e))-1))]; \
+	} } while(0)
 
 	while(1) {
-		UI code;
+		u32 e;
+		UI nbits, ntotal;
+		UI len, dist;
+		u8 *dst;
+		const u8 *src;
+
+		if(outpos > ictx->out_limit) {
+			INFL_SAVE_STATE();
+			infl_flush_output(ictx);
+			INFL_LOAD_STATE();
+			if(ictx->stop_flag) {
+				retval = 1;
+				goto done;
+			}
+		}
 
-		if(cctx->bitrd.eof_flag || cctx->err_flag) break;
+		// Enough for a 15-bit code plus 16 extra bits
+		if(bitcount < 31) INFL_REFILL();
 
-		code = read_next_code_using_tree(cctx, &cctx->literals_tree);
-		if(code<=255) {
-			if(cctx->c->debug_level>=4) {
-				de_dbg(c, "%u lit", code);
-			}
-			de_lz77buffer_add_literal_byte(cctx->ringbuf, (u8)code);
+		INFL_LOOKUP(e, lt, INFL_LITLEN_TABLEBITS);
+
+		// Decode literals without refilling, while there are enough bits.
+		while(INFL_E_KIND(e)==INFL_KIND_LIT) {
+			nbits = INFL_E_NBITS(e);
+			bitbuf >>= nbits;
+			bitcount -= nbits;
+			outbuf[outpos++] = (u8)INFL_E_VAL(e);
+			if(bitcount<15 || outpos>ictx->out_limit) goto next_symbol;
+			INFL_LOOKUP(e, lt, INFL_LITLEN_TABLEBITS);
 		}
-		else if(code>=257 && code<=285) { // beginning of a match
-			UI length = deflate_decode_length(c, cctx, code);
-			UI dist = deflate_read_and_decode_distance(c, cctx);
-			if(cctx->c->debug_level>=4) {
-				de_dbg(c, "%u match d=%u l=%u", code, dist+1, length);
+
+		if(INFL_E_KIND(e)!=INFL_KIND_LEN) {
+			if(INFL_E_KIND(e)==INFL_KIND_EOB) {
+				nbits = INFL_E_NBITS(e);
+				bitbuf >>= nbits;
+				bitcount -= nbits;
+				retval = 1;
+				goto done;
 			}
-			de_lz77buffer_copy_from_hist(cctx->ringbuf,
-				(UI)(cctx->ringbuf->curpos-1-dist), length);
+			INFL_SAVE_STATE();
+			infl_set_error(ictx, "Bad length code");
+			goto done;
 		}
-		else if(code==256) { // end of block
-			if(cctx->c->debug_level>=4) {
-				de_dbg(c, "%u stop", code);
-			}
-			retval = 1;
+
+		nbits = INFL_E_NBITS(e);
+		ntotal = nbits + INFL_E_NEXTRA(e);
+		// (Only 15 bits are guaranteed to be available after a literal. The
+		// code bits are still at the bottom of bitbuf, so it's safe to refill.)
+		if(bitcount < ntotal) INFL_REFILL();
+		len = INFL_E_VAL(e) + (UI)((bitbuf & (((u64)1<<ntotal)-1)) >> nbits);
+		bitbuf >>= ntotal;
+		bitcount -= ntotal;
+
+		// Enough for a 15-bit code plus 14 extra bits
+		if(bitcount < 29) INFL_REFILL();
+
+		INFL_LOOKUP(e, dt, INFL_DIST_TABLEBITS);
+		if(INFL_E_KIND(e)!=INFL_KIND_DIST) {
+			INFL_SAVE_STATE();
+			infl_set_error(ictx, "Bad distance code");
 			goto done;
 		}
+		nbits = INFL_E_NBITS(e);
+		ntotal = nbits + INFL_E_NEXTRA(e);
+		dist = INFL_E_VAL(e) + (UI)((bitbuf & (((u64)1<<ntotal)-1)) >> nbits);
+		bitbuf >>= ntotal;
+		bitcount -= ntotal;
+
+		// (The window is always full, initially with zeroes, so dist can't
+		// be too large.)
+		dst = &outbuf[outpos];
+		src = dst - dist;
+		outpos += len;
+		if(dist>=8) {
+			// Copy 8 bytes at a time. This can write up to 7 bytes past the
+			// end, which is allowed for.
+			u8 *dst_end = dst + len;
+
+			do {
+				de_memcpy(dst, src, 8);
+				dst += 8;
+				src += 8;
+			} while(dst < dst_end);
+		}
+		else if(dist==1) {
+			de_memset(dst, src[0], len);
+		}
 		else {
-			de_dbg(c, "unsupported code %u", code);
-			cctx->err_flag = 1;
-			goto done;
+			UI i;
+
+			for(i=0; i<len; i++) {
+				dst[i] = src[i];
+			}
 		}
+next_symbol:
+		;
 	}
 
 done:
+	if(!ictx->err_flag) {
+		INFL_SAVE_STATE();
+	}
 	return retval;
+#undef INFL_SAVE_STATE
+#undef INFL_LOAD_STATE
+#undef INFL_REFILL
+#undef INFL_LOOKUP
 }
 
-// Copy uncompressed aligned bytes
-static int lzh_copy_aligned_bytes(deark *c, struct lzh_ctx *cctx, i64 nbytes_to_copy1)
+static int infl_do_block_type0(struct inflate_ctx *ictx)
 {
-	i64 nbytes_left_to_copy = nbytes_to_copy1;
-
-	de_bitreader_skip_to_byte_boundary(&cctx->bitrd);
-	while(nbytes_left_to_copy>0) {
-		u8 b;
-
-		if(cctx->bitrd.curpos >= cctx->bitrd.endpos) {
-			cctx->bitrd.eof_flag = 1;
-			goto done;
-		}
-		b = dbuf_getbyte_p(cctx->bitrd.f, &cctx->bitrd.curpos);
-		de_lz77buffer_add_literal_byte(cctx->ringbuf, b);
-		nbytes_left_to_copy--;
+	deark *c = ictx->c;
+	UI blk_dlen;
+	UI blk_check;
+
+	infl_skip_to_byte_boundary(ictx);
+	blk_dlen = infl_getbits(ictx, 16);
+	blk_check = infl_getbits(ictx, 16);
+	de_dbg3(c, "non-compressed block dlen: %u", blk_dlen);
+	if(blk_check != (blk_dlen ^ 0xffff)) {
+		infl_set_error(ictx, "Non-compressed block failed consistency check");
+		return 0;
 	}
 
-done:
-	if(nbytes_left_to_copy!=0) {
+	// First use up any whole bytes in bitbuf
+	while(blk_dlen>0 && ictx->bitcount>=8) {
+		if(ictx->outpos >= ictx->outbuf_size) infl_flush_output(ictx);
+		ictx->outbuf[ictx->outpos++] = (u8)ictx->bitbuf;
+		ictx->bitbuf >>= 8;
+		ictx->bitcount -= 8;
+		blk_dlen--;
+	}
+	if(ictx->padding_bits > ictx->bitcount) {
+		infl_set_error(ictx, "Unexpected end of input");
 		return 0;
 	}
-	return 1;
-}
+	if(ictx->bitcount==0) {
+		// Bits above bitcount would be stale after we copy bytes directly
+		// from the input.
+		ictx->bitbuf = 0;
+	}
 
-static int lzh_do_deflate_block_type0(deark *c, struct lzh_ctx *cctx)
-{
-	int retval = 0;
-	UI blk_dlen;
-	UI blk_check, blk_check_expected;
+	// Then copy the rest directly from the input
+	while(blk_dlen>0) {
+		UI n;
 
-	// Go to the next byte boundary
-	de_bitreader_skip_to_byte_boundary(&cctx->bitrd);
+		if(ictx->in_ptr >= ictx->in_end) {
+			if(!infl_load_input_chunk(ictx)) {
+				infl_set_error(ictx, "Unexpected end of input");
+				return 0;
+			}
+		}
+		if(ictx->outpos >= ictx->outbuf_size) {
+			infl_flush_output(ictx);
+			if(ictx->stop_flag) return 1;
+		}
 
-	// Next, two 16-bit fields
-	blk_dlen = (UI)lzh_getbits(cctx, 16);
-	de_dbg2(c, "non-compressed block dlen: %u", blk_dlen);
-	blk_check_expected = blk_dlen ^ 0xffff;
-	blk_check = (UI)lzh_getbits(cctx, 16);
-	de_dbg2(c, "consistency check: 0x%04x", blk_check);
-	if(blk_check != blk_check_expected) {
-		de_dfilter_set_errorf(c, cctx->dres, cctx->modname,
-			"Non-compressed block failed consistency check");
-		goto done;
+		n = blk_dlen;
+		if((i64)n > (i64)(ictx->in_end - ictx->in_ptr)) n = (UI)(ictx->in_end - ictx->in_ptr);
+		if(n > ictx->outbuf_size - ictx->outpos) n = ictx->outbuf_size - ictx->outpos;
+		de_memcpy(&ictx->outbuf[ictx->outpos], ictx->in_ptr, n);
+		ictx->outpos += n;
+		ictx->in_ptr += n;
+		blk_dlen -= n;
 	}
-
-	// Then the literal bytes
-	if(!lzh_copy_aligned_bytes(c, cctx, (i64)blk_dlen)) goto done;
-	retval = 1;
-
-done:
-	return retval;
+	return 1;
 }
 
 // Returns 0 if this was the last block, or on error.
-static int lzh_do_deflate_block(deark *c, struct lzh_ctx *cctx)
+static int infl_do_block(struct inflate_ctx *ictx)
 {
+	deark *c = ictx->c;
 	UI is_last;
 	UI blktype;
-	int blkret;
-	char pos_descr[32];
-	int retval = 0;
-
-	lzh_destroy_trees(cctx);
+	int blkret = 0;
+	i64 pos;
+	UI nbits_used;
+
+	pos = infl_get_curpos(ictx, &nbits_used);
+	is_last = infl_getbits(ictx, 1);
+	blktype = infl_getbits(ictx, 2);
+	if(c->debug_level>=2) {
+		if(nbits_used==0) {
+			de_dbg2(c, "block at %"I64_FMT", type=%u, last=%u", pos, blktype, is_last);
+		}
+		else {
+			de_dbg2(c, "block at %"I64_FMT"+%ubits, type=%u, last=%u", pos, nbits_used,
+				blktype, is_last);
+		}
+	}
 
-	de_bitreader_describe_curpos(&cctx->bitrd, pos_descr, sizeof(pos_descr));
-	is_last = (UI)lzh_getbits(cctx, 1);
-	blktype = (UI)lzh_getbits(cctx, 2);
-	de_dbg(c, "block at %s, type=%u, last=%u", pos_descr, blktype, is_last);
 	de_dbg_indent(c, 1);
-
 	switch(blktype) {
 	case 0:
-		blkret = lzh_do_deflate_block_type0(c, cctx);
+		blkret = infl_do_block_type0(ictx);
 		break;
 	case 1:
+		if(!infl_make_fixed_tables(ictx)) {
+			infl_set_error(ictx, "Internal error");
+			break;
+		}
+		blkret = infl_decode_huffman_block(ictx);
+		break;
 	case 2:
-		blkret = lzh_do_deflate_block_type1_2(c, cctx, blktype);
+		if(!infl_read_dynamic_tables(ictx)) break;
+		blkret = infl_decode_huffman_block(ictx);
 		break;
 	default:
-		de_dfilter_set_errorf(c, cctx->dres, cctx->modname, "Unsupported block type: %u",
+		de_dfilter_set_errorf(c, ictx->dres, ictx->modname, "Unsupported block type: %u",
 			blktype);
-		blkret = 0;
+		ictx->err_flag = 1;
 	}
-
-	if(blkret && !is_last) {
-		retval = 1;
-	}
-
 	de_dbg_indent(c, -1);
-	return retval;
-}
-
-static void decompress_deflate_internal(struct lzh_ctx *cctx)
-{
-	deark *c = cctx->c;
-
-	while(1) {
-		int ret;
 
-		if(cctx->bitrd.eof_flag || cctx->err_flag) break;
-		if(lzh_have_enough_output(cctx)) break;
-
-		ret = lzh_do_deflate_block(c, cctx);
-		if(!ret) break;
+	if(blkret && !ictx->err_flag && ictx->padding_bits > ictx->bitcount) {
+		infl_set_error(ictx, "Unexpected end of input");
 	}
+	if(ictx->err_flag || ictx->stop_flag) return 0;
+	return (blkret && !is_last);
 }
 
-static int lzh_read_zlib_header(deark *c, struct lzh_ctx *cctx)
+static int infl_read_zlib_header(struct inflate_ctx *ictx)
 {
+	deark *c = ictx->c;
 	u8 h[2];
 	UI meth, cinfo;
 	UI fcheck, fdict, flevel;
 	UI chk;
 	int retval = 0;
 
-	de_dbg(c, "zlib header at %"I64_FMT, cctx->bitrd.curpos);
+	de_dbg(c, "zlib header at %"I64_FMT, infl_get_curpos(ictx, NULL));
 	de_dbg_indent(c, 1);
-	h[0] = (u8)lzh_getbits(cctx, 8);
-	h[1] = (u8)lzh_getbits(cctx, 8);
+	h[0] = (u8)infl_getbits(ictx, 8);
+	h[1] = (u8)infl_getbits(ictx, 8);
 
 	meth = (UI)(h[0]&0x0f);
 	de_dbg2(c, "CM: %u", meth);
@@ -1142,101 +1521,144 @@ static int lzh_read_zlib_header(deark *c, struct lzh_ctx *cctx)
 
 done:
 	if(!retval) {
-		de_dfilter_set_errorf(c, cctx->dres, cctx->modname, "Bad or unsupported zlib parameters");
+		infl_set_error(ictx, "Bad or unsupported zlib parameters");
 	}
 	de_dbg_indent(c, -1);
 	return retval;
 }
 
-static int lzh_read_zlib_trailer(deark *c, struct lzh_ctx *cctx)
+static int infl_read_zlib_trailer(struct inflate_ctx *ictx)
 {
+	deark *c = ictx->c;
 	u32 cs_reported;
 	u32 cs_calc;
+	UI i;
 	int retval = 0;
 
-	de_bitreader_skip_to_byte_boundary(&cctx->bitrd);
-	de_dbg(c, "zlib trailer at %"I64_FMT, cctx->bitrd.curpos);
+	infl_skip_to_byte_boundary(ictx);
+	de_dbg(c, "zlib trailer at %"I64_FMT, infl_get_curpos(ictx, NULL));
 	de_dbg_indent(c, 1);
-	if(cctx->bitrd.curpos + 4 > cctx->bitrd.endpos) goto done;
-	cs_reported = (u32)dbuf_getu32be_p(cctx->bitrd.f, &cctx->bitrd.curpos);
+	cs_reported = 0;
+	for(i=0; i<4; i++) {
+		cs_reported = (cs_reported<<8) | (u32)infl_getbits(ictx, 8);
+	}
+	if(ictx->padding_bits > ictx->bitcount) goto done;
 	de_dbg2(c, "checksum (reported): 0x%08x", (UI)cs_reported);
-	cs_calc = de_crcobj_getval(cctx->crco);
+	cs_calc = de_crcobj_getval(ictx->adler_crco);
 	de_dbg2(c, "checksum (calculated): 0x%08x", (UI)cs_calc);
 	if(cs_calc != cs_reported) goto done;
 	retval = 1;
 
 done:
 	if(!retval) {
-		de_dfilter_set_errorf(c, cctx->dres, cctx->modname, "Bad zlib trailer");
+		infl_set_error(ictx, "Bad zlib trailer");
 	}
 	de_dbg_indent(c, -1);
 	return retval;
 }
 
-static void fmtutil_deflate_codectype1_native(deark *c, struct de_dfilter_in_params *dcmpri,
+// Copy the caller's history into our window
+static void infl_load_history(struct inflate_ctx *ictx, struct de_lz77buffer *rb)
+{
+	UI n = (UI)de_min_int(rb->bufsize, ictx->wsize);
+	UI i;
+
+	for(i=0; i<n; i++) {
+		ictx->outbuf[ictx->wsize - n + i] = rb->buf[(rb->curpos - n + i) & rb->mask];
+	}
+}
+
+static void infl_save_history(struct inflate_ctx *ictx, struct de_lz77buffer *rb)
+{
+	UI n = (UI)de_min_int(rb->bufsize, ictx->outpos);
+	UI i;
+
+	for(i=0; i<n; i++) {
+		rb->buf[(rb->curpos + i) & rb->mask] = ictx->outbuf[ictx->outpos - n + i];
+	}
+	de_lz77buffer_set_curpos(rb, rb->curpos + n);
+}
+
+// codec_private_params is type de_deflate_params. Cannot be NULL.
+void fmtutil_deflate_codectype1_native(deark *c, struct de_dfilter_in_params *dcmpri,
 	struct de_dfilter_out_params *dcmpro, struct de_dfilter_results *dres,
 	void *codec_private_params)
 {
 	struct de_deflate_params *deflparams = (struct de_deflate_params*)codec_private_params;
-	struct lzh_ctx *cctx = NULL;
+	struct inflate_ctx *ictx = NULL;
 	u8 is_zlib = 0;
 
-	cctx = de_malloc(c, sizeof(struct lzh_ctx));
-	cctx->modname = "deflate-native";
-	cctx->c = c;
-	cctx->dcmpri = dcmpri;
-	cctx->dcmpro = dcmpro;
-	cctx->dres = dres;
+	ictx = de_malloc(c, sizeof(struct inflate_ctx));
+	ictx->modname = "deflate";
+	ictx->c = c;
+	ictx->dcmpri = dcmpri;
+	ictx->dcmpro = dcmpro;
+	ictx->dres = dres;
+	ictx->crco_for_output = deflparams->crco_for_output;
+	ictx->ringbuf_to_use = deflparams->ringbuf_to_use;
+	ictx->outpos_at_eof = -1;
 
 	if(deflparams->flags & DE_DEFLATEFLAG_ISZLIB) is_zlib = 1;
-	if(deflparams->flags & DE_DEFLATEFLAG_DEFLATE64) cctx->is_deflate64 = 1;
+	if(deflparams->flags & DE_DEFLATEFLAG_DEFLATE64) ictx->is_deflate64 = 1;
 
-	cctx->bitrd.bbll.is_lsb = 1;
-	cctx->bitrd.f = dcmpri->f;
-	cctx->bitrd.curpos = dcmpri->pos;
-	cctx->bitrd.endpos = dcmpri->pos + dcmpri->len;
-
-	if(is_zlib) {
-		if(!lzh_read_zlib_header(c, cctx)) goto done;
+	ictx->in_next_filepos = dcmpri->pos;
+	ictx->in_endpos = de_min_int(dcmpri->pos + de_max_int(dcmpri->len, 0), dcmpri->f->len);
+	ictx->in_chunk_filepos = dcmpri->pos;
 
-		cctx->crco = de_crcobj_create(c, DE_CRCOBJ_ADLER32);
+	ictx->wsize = ictx->is_deflate64 ? 65536 : 32768;
+	ictx->outbuf_size = ictx->wsize + INFL_OUTCHUNK_SIZE;
+	// +8 for the 8-byte match copy.
+	// This buffer is large, so reuse it from one member to the next. Only the
+	// window has to start out zeroed.
+	ictx->outbuf = de_pool_malloc(c, DE_OBJPOOL_INFLATE_OUTBUF, (i64)ictx->outbuf_size + 8,
+		DE_POOLFLAG_NOZERO);
+	de_zeromem(ictx->outbuf, ictx->wsize);
+	ictx->out_limit = ictx->outbuf_size - (ictx->is_deflate64 ? 65538 : 258);
+	ictx->outpos = ictx->wsize;
+	ictx->flushpos = ictx->outpos;
+	if(ictx->ringbuf_to_use) {
+		infl_load_history(ictx, ictx->ringbuf_to_use);
 	}
 
-	if(deflparams->ringbuf_to_use) {
-		cctx->ringbuf = deflparams->ringbuf_to_use;
-		cctx->ringbuf_owned_by_caller = 1;
-	}
-	else {
-		cctx->ringbuf = de_lz77buffer_create(c, (cctx->is_deflate64 ? 65536 : 32768));
-	}
-
-	cctx->ringbuf->userdata = (void*)cctx;
-	cctx->ringbuf->writebyte_cb = lzh_lz77buf_writebytecb;
+	infl_init_sym_entries(ictx);
 
-	decompress_deflate_internal(cctx);
+	if(is_zlib) {
+		if(!infl_read_zlib_header(ictx)) goto done;
+		ictx->adler_crco = de_crcobj_create(c, DE_CRCOBJ_ADLER32);
+	}
 
-	cctx->ringbuf->userdata = NULL;
-	cctx->ringbuf->writebyte_cb = NULL;
+	while(1) {
+		if(!infl_do_block(ictx)) break;
+	}
+	infl_flush_output(ictx);
 
-	if(!cctx->err_flag && is_zlib) {
-		if(!lzh_read_zlib_trailer(c, cctx)) goto done;
+	if(ictx->ringbuf_to_use) {
+		infl_save_history(ictx, ictx->ringbuf_to_use);
 	}
 
-	if(cctx->err_flag) {
-		// A default error message
-		de_dfilter_set_errorf(c, dres, cctx->modname, "Deflate decoding error");
-		goto done;
+	if(!ictx->err_flag && !ictx->stop_flag && is_zlib) {
+		if(!infl_read_zlib_trailer(ictx)) goto done;
 	}
 
-	de_bitreader_skip_to_byte_boundary(&cctx->bitrd);
-	cctx->dres->bytes_consumed = cctx->bitrd.curpos - cctx->dcmpri->pos;
-	if(cctx->dres->bytes_consumed<0) {
-		cctx->dres->bytes_consumed = 0;
+	if(ictx->err_flag) goto done;
+
+	infl_skip_to_byte_boundary(ictx);
+	dres->bytes_consumed = infl_get_curpos(ictx, NULL) - dcmpri->pos;
+	if(dres->bytes_consumed<0) {
+		dres->bytes_consumed = 0;
 	}
-	cctx->dres->bytes_consumed_valid = 1;
+	dres->bytes_consumed_valid = 1;
 
 done:
-	destroy_lzh_ctx(cctx);
+	if(ictx->err_flag && !dres->errcode) {
+		de_dfilter_set_errorf(c, dres, ictx->modname, "Deflate decoding error");
+	}
+	de_crcobj_destroy(ictx->adler_crco);
+	de_pool_free(c, DE_OBJPOOL_INFLATE_OUTBUF, (i64)ictx->outbuf_size + 8, ictx->outbuf);
+	if(ictx->inbuf) {
+		de_pool_free(c, DE_OBJPOOL_INFLATE_INBUF, INFL_INBUF_SIZE, ictx->inbuf);
+	}
+	de_free(c, ictx);
 }
 
 // codec_private_params is type de_deflate_params. Cannot be NULL.
@@ -1265,24 +1687,8 @@ void fmtutil_deflate_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 		return;
 	}
 
-	if(c->deflate_decoder_id==0) {
-		const char *o;
-
-		o = de_get_ext_option(c, "deflatecodec");
-		if(o && !de_strcmp(o, "native")) {
-			c->deflate_decoder_id = 2;
-		}
-		else {
-			c->deflate_decoder_id = 1;
-		}
-	}
-
-	if(c->deflate_decoder_id==2) {
-		fmtutil_deflate_codectype1_native(c, dcmpri, dcmpro, dres, codec_private_params);
-	}
-	else {
-		fmtutil_deflate_codectype1_miniz(c, dcmpri, dcmpro, dres, codec_private_params);
-	}
+	fmtutil_select_codec_backend(c, "deflate")->codec_fn(c, dcmpri, dcmpro, dres,
+		codec_private_params);
 }
 
 void fmtutil_decompress_deflate_ex(deark *c, struct de_dfilter_in_params *dcmpri,
@@ -1335,6 +1741,20 @@ int fmtutil_decompress_deflate(dbuf *inf, i64 inputstart, i64 inputsize, dbuf *o
 
 ///////////////////// Implode (ZIP method #6)
 
+// Call record_a_code_length() for a range of codes, all the same length
+static int huffman_record_len_for_range(deark *c, struct fmtutil_huffman_decoder *ht,
+	fmtutil_huffman_valtype range_start, i64 count, UI codelen)
+{
+	i64 i;
+
+	for(i=0; i<count; i++) {
+		int ret = fmtutil_huffman_record_a_code_length(c, ht->builder,
+			range_start+(fmtutil_huffman_valtype)i, codelen);
+		if(!ret) return 0;
+	}
+	return 1;
+}
+
 // Note that trees are always constructed so that the minimum value stored
 // in them is 0. If that's not the desired minimum value, values must be de-biased
 // after reading them.
@@ -1434,7 +1854,7 @@ static void decompress_implode_internal(struct lzh_ctx *cctx)
 
 	cctx->ringbuf = de_lz77buffer_create(c, rb_size);
 	cctx->ringbuf->userdata = (void*)cctx;
-	cctx->ringbuf->writebyte_cb = lzh_lz77buf_writebytecb;
+	cctx->ringbuf->write_span_cb = lzh_lz77buf_writespancb;
 
 	if(!implode_read_trees(cctx)) {
 		cctx->err_flag = 1;
@@ -1631,7 +2051,7 @@ static void dclimplode_internal(struct lzh_ctx *cctx)
 	//  4096 if dist_code_extra_bits==6
 	cctx->ringbuf = de_lz77buffer_create(cctx->c, 4096);
 	cctx->ringbuf->userdata = (void*)cctx;
-	cctx->ringbuf->writebyte_cb = lzh_lz77buf_writebytecb_flagerrors;
+	cctx->ringbuf->write_span_cb = lzh_lz77buf_writespancb_flagerrors;
 
 	while(1) {
 		UI n;
@@ -2000,7 +2420,7 @@ void fmtutil_distilled_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 
 	cctx->ringbuf = de_lz77buffer_create(cctx->c, 8192);
 	cctx->ringbuf->userdata = (void*)cctx;
-	cctx->ringbuf->writebyte_cb = lzh_lz77buf_writebytecb;
+	cctx->ringbuf->write_span_cb = lzh_lz77buf_writespancb;
 	de_lz77buffer_clear(cctx->ringbuf, 0x20);
 
 	distilled_read_nodetable(c, cctx);
@@ -2168,7 +2588,7 @@ void fmtutil_lzstac_codectype1(deark *c, struct de_dfilter_in_params *dcmpri,
 
 	cctx->ringbuf = de_lz77buffer_create(cctx->c, 2048);
 	cctx->ringbuf->userdata = (void*)cctx;
-	cctx->ringbuf->writebyte_cb = lzh_lz77buf_writebytecb_flagerrors;
+	cctx->ringbuf->write_span_cb = lzh_lz77buf_writespancb_flagerrors;
 
 	while(1) {
 		if(block_count==0 && (dcmpri->len<=0) && !(flags & 0x1)) {
@@ -14,6 +14,7 @@
 #define DELZW_MAXMAXCODESIZE 16
 #define DELZW_NBITS_TO_MAXCODE(n) ((DELZW_CODE)((1<<(n))-1))
 #define DELZW_NBITS_TO_NCODES(n) ((DELZW_CODE)(1<<(n)))
+#define DELZW_OUTBUF_SIZE    65536
 
 struct delzwctx_struct;
 typedef struct delzwctx_struct delzwctx;
@@ -30,11 +31,18 @@ struct delzw_tableentry {
 #define DELZW_CODETYPE_SPECIAL     0x0f
 	u8 codetype;
 	u8 flags;
+	u8 firstbyte; // First byte of this code's string (valid if len>0)
+	// Length of this code's string, or 0 if it has to be decoded the slow way
+	u16 len;
 };
 
 struct delzw_tableentry2 {
 #define DELZW_NEXTPTR_NONE 0xffff // Note - This table is only used with 12-bit codes
 	DELZW_CODE_MINRANGE next;
+	// Shortcuts that let us avoid long searches. They don't affect which
+	// entries get used.
+	DELZW_CODE_MINRANGE tail_hint;
+	DELZW_CODE_MINRANGE nextfree_hint;
 };
 
 struct delzwctx_struct {
@@ -130,6 +138,16 @@ struct delzwctx_struct {
 	size_t valbuf_capacity;
 	u8 *valbuf;
 
+	// Decompressed bytes are collected here, and written in large spans.
+	size_t outbuf_capacity;
+	size_t outbuf_len;
+	u8 *outbuf;
+	// The most recently emitted code, if its full string is still in outbuf
+	// (prev_emit_len>0).
+	DELZW_CODE prev_emit_code;
+	size_t prev_emit_pos;
+	size_t prev_emit_len;
+
 	char errmsg[80];
 };
 
@@ -194,25 +212,44 @@ static void delzw_set_error(delzwctx *dc, int errcode, const char *msg)
 	de_strlcpy(dc->errmsg, msg, sizeof(dc->errmsg));
 }
 
-static void delzw_write(delzwctx *dc, const u8 *buf, size_t n1)
+static void delzw_flush_output(delzwctx *dc)
 {
-	i64 n;
+	if(dc->outbuf_len>0) {
+		dbuf_write(dc->dfctx->dcmpro->f, dc->outbuf, (i64)dc->outbuf_len);
+		dc->outbuf_len = 0;
+	}
+	dc->prev_emit_len = 0;
+}
 
-	if(dc->errcode) return;
-	n = (i64)n1;
+// Returns a pointer to the end of outbuf, where n bytes may be written.
+// n must not exceed ct_capacity.
+static u8 *delzw_outbuf_reserve(delzwctx *dc, size_t n)
+{
+	if(dc->outbuf_len + n > dc->outbuf_capacity) {
+		delzw_flush_output(dc);
+	}
+	return &dc->outbuf[dc->outbuf_len];
+}
 
+// Accept the n bytes (the string for 'code') that the caller put at the end
+// of outbuf, truncating them if we know the output length.
+static void delzw_outbuf_commit(delzwctx *dc, DELZW_CODE code, size_t n1)
+{
+	i64 n = (i64)n1;
+
+	dc->prev_emit_len = 0;
 	if(dc->output_len_known) {
 		if(dc->uncmpr_nbytes_written + n > dc->output_expected_len) {
 			n = dc->output_expected_len - dc->uncmpr_nbytes_written;
 		}
 	}
 	if(n<1) return;
-	if(n==1) {
-		dbuf_writebyte(dc->dfctx->dcmpro->f, buf[0]);
-	}
-	else {
-		dbuf_write(dc->dfctx->dcmpro->f, buf, n);
+	if(n==(i64)n1) {
+		dc->prev_emit_code = code;
+		dc->prev_emit_pos = dc->outbuf_len;
+		dc->prev_emit_len = n1;
 	}
+	dc->outbuf_len += (size_t)n;
 	dc->uncmpr_nbytes_written += n;
 }
 
@@ -253,12 +290,14 @@ static int delzw_code_is_in_table(delzwctx *dc, DELZW_CODE code)
 	return 0;
 }
 
-// Decode an LZW code to one or more values, and write the values.
-// Updates dc->last_value.
-static void delzw_emit_code(delzwctx *dc, DELZW_CODE code1)
+// Decode an LZW code by walking the tree, for codes whose length isn't known
+// in advance. Unlike delzw_emit_code(), this tolerates unused codes in the
+// chain (which can happen with zipshrink, and with corrupt data).
+static void delzw_emit_code_slow(delzwctx *dc, DELZW_CODE code1)
 {
 	DELZW_CODE code = code1;
 	size_t valbuf_pos = dc->valbuf_capacity; // = First entry that's used
+	size_t n;
 
 	while(1) {
 		if(code >= dc->ct_capacity) {
@@ -297,7 +336,56 @@ static void delzw_emit_code(delzwctx *dc, DELZW_CODE code1)
 	}
 
 	// Write out the collected values.
-	delzw_write(dc, &dc->valbuf[valbuf_pos], dc->valbuf_capacity - valbuf_pos);
+	n = dc->valbuf_capacity - valbuf_pos;
+	de_memcpy(delzw_outbuf_reserve(dc, n), &dc->valbuf[valbuf_pos], n);
+	delzw_outbuf_commit(dc, code1, n);
+	dc->prev_emit_len = 0;
+}
+
+// Decode an LZW code to one or more values, and write the values.
+// Updates dc->last_value.
+static void delzw_emit_code(delzwctx *dc, DELZW_CODE code)
+{
+	struct delzw_tableentry *e;
+	u8 *dst;
+	size_t len;
+
+	if(dc->errcode) return;
+	if(code < dc->ct_capacity) {
+		e = &dc->ct[code];
+	}
+	else {
+		e = NULL;
+	}
+	if(!e || e->len==0 ||
+		(e->codetype!=DELZW_CODETYPE_STATIC && e->codetype!=DELZW_CODETYPE_DYN_USED))
+	{
+		delzw_emit_code_slow(dc, code);
+		return;
+	}
+
+	len = (size_t)e->len;
+	dst = delzw_outbuf_reserve(dc, len);
+
+	if(len>1 && dc->prev_emit_len+1==len && e->parent==dc->prev_emit_code) {
+		// The string is the one we just wrote, plus one byte. This includes
+		// the KwKwK case.
+		de_memcpy(dst, &dc->outbuf[dc->prev_emit_pos], dc->prev_emit_len);
+		dst[len-1] = e->value;
+	}
+	else {
+		DELZW_CODE p = code;
+		size_t i;
+
+		// Fill in the string back to front, walking toward the root code.
+		for(i=len; i>0; i--) {
+			dst[i-1] = dc->ct[p].value;
+			p = dc->ct[p].parent;
+		}
+	}
+
+	dc->last_value = e->firstbyte;
+	delzw_outbuf_commit(dc, code, len);
 }
 
 static void delzw_find_first_free_entry(delzwctx *dc, DELZW_CODE *pentry)
@@ -381,12 +469,54 @@ static void delzw_increase_codesize(delzwctx *dc)
 	}
 }
 
+// Returns the last entry in the duplicates list that contains h.
+static DELZW_CODE delzw_hashed_find_list_end(delzwctx *dc, DELZW_CODE h1)
+{
+	DELZW_CODE h = h1;
+	DELZW_CODE tmp;
+
+	// tail_hint always points to a later entry in the same list, so we can
+	// skip over most of it.
+	while(dc->ct2[h].next != DELZW_NEXTPTR_NONE) {
+		h = dc->ct2[h].tail_hint;
+	}
+
+	// Path compression
+	while(h1 != h && dc->ct2[h1].next != DELZW_NEXTPTR_NONE) {
+		tmp = dc->ct2[h1].tail_hint;
+		dc->ct2[h1].tail_hint = (DELZW_CODE_MINRANGE)h;
+		h1 = tmp;
+	}
+	return h;
+}
+
+// Returns the first unused entry at or after h1, wrapping around.
+// There must be at least one unused entry.
+static DELZW_CODE delzw_hashed_find_free_entry(delzwctx *dc, DELZW_CODE h1)
+{
+	DELZW_CODE h = h1;
+	DELZW_CODE tmp;
+
+	// nextfree_hint points to an entry such that all the entries before it
+	// (starting with this one) are in use. This works because entries are
+	// never freed in this mode.
+	while(dc->ct[h].codetype != DELZW_CODETYPE_DYN_UNUSED) {
+		h = dc->ct2[h].nextfree_hint;
+	}
+
+	while(h1 != h) {
+		tmp = dc->ct2[h1].nextfree_hint;
+		dc->ct2[h1].nextfree_hint = (DELZW_CODE_MINRANGE)h;
+		h1 = tmp;
+	}
+	return h;
+}
+
 static DELZW_CODE delzw_get_hashed_code(delzwctx *dc, DELZW_CODE code,
 	u8 value)
 {
 	DELZW_CODE h;
 	DELZW_CODE saved_h;
-	u32 count;
 
 	h = ((code+(DELZW_CODE)value) | 0x0800) & 0xffff;
 	h = ((h*h) >> 6) % dc->ct_capacity;
@@ -395,41 +525,47 @@ static DELZW_CODE delzw_get_hashed_code(delzwctx *dc, DELZW_CODE code,
 		return h;
 	}
 
-	// Collision - First, walk to the end of the duplicates list
-	count = 0;
-	while(dc->ct2[h].next != DELZW_NEXTPTR_NONE) {
-		h = dc->ct2[h].next;
-
-		count++;
-		if(count > dc->ct_capacity) {
-			delzw_set_error(dc, DELZW_ERRCODE_GENERIC_ERROR, NULL);
-			return 0;
-		}
+	if(dc->ct_code_count >= dc->ct_capacity) {
+		delzw_set_error(dc, DELZW_ERRCODE_GENERIC_ERROR, NULL);
+		return 0;
 	}
 
-	saved_h = h;
+	// Collision - First, find the end of the duplicates list
+	saved_h = delzw_hashed_find_list_end(dc, h);
 
-	// Then search for an open slot
-	count = 0;
-	while(1) {
-		if(count==0)
-			h += 101;
-		else
-			h += 1;
-		h %= dc->ct_capacity;
+	// Then search for an open slot, starting 101 entries later
+	h = delzw_hashed_find_free_entry(dc, (saved_h + 101) % dc->ct_capacity);
 
-		if(dc->ct[h].codetype==DELZW_CODETYPE_DYN_UNUSED)
-			break;
+	dc->ct2[saved_h].next = (DELZW_CODE_MINRANGE)h;
+	dc->ct2[saved_h].tail_hint = (DELZW_CODE_MINRANGE)h;
+	return h;
+}
 
-		count++;
-		if(count > dc->ct_capacity) {
-			delzw_set_error(dc, DELZW_ERRCODE_GENERIC_ERROR, NULL);
-			return 0;
+// Set the new entry at idx to the given fields, and figure out the length
+// of its string, if possible.
+static void delzw_set_dyn_entry(delzwctx *dc, DELZW_CODE idx, DELZW_CODE parent, u8 value)
+{
+	struct delzw_tableentry *pe;
+	u16 len = 0;
+	u8 firstbyte = 0;
+
+	// (This has to be done before changing the entry at idx, in case it is
+	// the same as the parent.)
+	if(parent < dc->ct_capacity) {
+		pe = &dc->ct[parent];
+		if(pe->len>0 && pe->len<0xffff && (DELZW_CODE)pe->len<dc->ct_capacity &&
+			(pe->codetype==DELZW_CODETYPE_STATIC || pe->codetype==DELZW_CODETYPE_DYN_USED))
+		{
+			len = (u16)(pe->len + 1);
+			firstbyte = pe->firstbyte;
 		}
 	}
 
-	dc->ct2[saved_h].next = h;
-	return h;
+	dc->ct[idx].parent = (DELZW_CODE_MINRANGE)parent;
+	dc->ct[idx].value = value;
+	dc->ct[idx].codetype = DELZW_CODETYPE_DYN_USED;
+	dc->ct[idx].len = len;
+	dc->ct[idx].firstbyte = firstbyte;
 }
 
 static void delzw_hashed_add_code_to_dict(delzwctx *dc, DELZW_CODE code, u8 value)
@@ -443,9 +579,7 @@ static void delzw_hashed_add_code_to_dict(delzwctx *dc, DELZW_CODE code, u8 valu
 	idx = delzw_get_hashed_code(dc, code, value);
 	if(dc->errcode) return;
 
-	dc->ct[idx].parent = (DELZW_CODE_MINRANGE)dc->oldcode;
-	dc->ct[idx].value = value;
-	dc->ct[idx].codetype = DELZW_CODETYPE_DYN_USED;
+	delzw_set_dyn_entry(dc, idx, dc->oldcode, value);
 	dc->ct_code_count++;
 	dc->last_code_added = idx;
 }
@@ -489,9 +623,7 @@ static void delzw_add_to_dict(delzwctx *dc, DELZW_CODE parent, u8 value)
 		return;
 	}
 
-	dc->ct[newpos].parent = (DELZW_CODE_MINRANGE)parent;
-	dc->ct[newpos].value = value;
-	dc->ct[newpos].codetype = DELZW_CODETYPE_DYN_USED;
+	delzw_set_dyn_entry(dc, newpos, parent, value);
 	dc->ct_code_count++;
 	dc->last_code_added = newpos;
 	dc->free_code_search_start = newpos+1;
@@ -567,6 +699,7 @@ static void delzw_clear_one_dynamic_code(delzwctx *dc, DELZW_CODE code)
 	dc->ct[code].codetype = DELZW_CODETYPE_DYN_UNUSED;
 	dc->ct[code].parent = 0;
 	dc->ct[code].value = 0;
+	dc->ct[code].len = 0;
 }
 
 static void delzw_clear(delzwctx *dc)
@@ -589,6 +722,7 @@ static void delzw_clear(delzwctx *dc)
 	dc->oldcode = 0;
 	dc->last_code_added = 0;
 	dc->last_value = 0;
+	dc->prev_emit_len = 0;
 
 	delzw_debugmsg(dc, 2, "code size: %u", dc->curr_codesize);
 }
@@ -622,6 +756,7 @@ static void delzw_partial_clear(delzwctx *dc)
 	}
 
 	dc->free_code_search_start = dc->first_dynamic_code;
+	dc->prev_emit_len = 0;
 }
 
 static void delzw_process_code(delzwctx *dc, DELZW_CODE code)
@@ -831,13 +966,31 @@ static void delzw_on_codes_start(delzwctx *dc)
 
 	dc->curr_codesize = dc->min_codesize;
 
+	// These buffers come from the object pool, since we're often used for
+	// many small archive members in a row.
 	dc->ct_capacity = ((DELZW_CODE)1)<<dc->max_codesize;
-	dc->ct = de_mallocarray(dc->c, dc->ct_capacity, sizeof(struct delzw_tableentry));
+	dc->ct = de_pool_malloc(dc->c, DE_OBJPOOL_LZW_TABLE,
+		(i64)dc->ct_capacity * (i64)sizeof(struct delzw_tableentry), 0);
 	if(dc->is_hashed) {
-		dc->ct2 = de_mallocarray(dc->c, dc->ct_capacity, sizeof(struct delzw_tableentry2));
+		dc->ct2 = de_pool_malloc(dc->c, DE_OBJPOOL_LZW_TABLE2,
+			(i64)dc->ct_capacity * (i64)sizeof(struct delzw_tableentry2), 0);
 	}
 	dc->valbuf_capacity = dc->ct_capacity;
-	dc->valbuf = de_malloc(dc->c, dc->valbuf_capacity);
+	dc->outbuf_capacity = DELZW_OUTBUF_SIZE;
+	if(dc->output_len_known && dc->output_expected_len < (i64)dc->outbuf_capacity) {
+		// Avoid allocating a large buffer for, e.g., each strip of a TIFF image.
+		// Round up to a power of 2, so the buffer is more likely to be reusable.
+		dc->outbuf_capacity = 4096;
+		while((i64)dc->outbuf_capacity < dc->output_expected_len) {
+			dc->outbuf_capacity *= 2;
+		}
+	}
+	dc->outbuf_capacity += (size_t)dc->ct_capacity;
+	// valbuf and outbuf are scratch space, and don't need to be zeroed.
+	dc->valbuf = de_pool_malloc(dc->c, DE_OBJPOOL_LZW_BUF, (i64)dc->valbuf_capacity,
+		DE_POOLFLAG_NOZERO);
+	dc->outbuf = de_pool_malloc(dc->c, DE_OBJPOOL_LZW_BUF, (i64)dc->outbuf_capacity,
+		DE_POOLFLAG_NOZERO);
 
 	if(dc->basefmt==DELZW_BASEFMT_UNIXCOMPRESS) {
 		for(i=0; i<256; i++) {
@@ -902,6 +1055,8 @@ static void delzw_on_codes_start(delzwctx *dc)
 	if(dc->is_hashed) {
 		for(i=0; i<dc->ct_capacity; i++) {
 			dc->ct2[i].next = DELZW_NEXTPTR_NONE;
+			dc->ct2[i].tail_hint = (DELZW_CODE_MINRANGE)i;
+			dc->ct2[i].nextfree_hint = (DELZW_CODE_MINRANGE)((i+1) % dc->ct_capacity);
 		}
 	}
 
@@ -921,6 +1076,13 @@ static void delzw_on_codes_start(delzwctx *dc)
 		}
 	}
 
+	for(i=0; i<dc->ct_capacity; i++) {
+		if(dc->ct[i].codetype==DELZW_CODETYPE_STATIC) {
+			dc->ct[i].len = 1;
+			dc->ct[i].firstbyte = dc->ct[i].value;
+		}
+	}
+
 	dc->bbll.is_lsb = !dc->is_msb;
 	de_bitbuf_lowlevel_empty(&dc->bbll);
 done:
@@ -1013,6 +1175,7 @@ static void delzw_addbuf(delzwctx *dc, const u8 *buf, i64 buf_len)
 		delzw_process_byte(dc, buf[i]);
 		dc->total_nbytes_processed++;
 	}
+	delzw_flush_output(dc);
 }
 
 static void delzw_finish(delzwctx *dc)
@@ -1027,6 +1190,7 @@ static void delzw_finish(delzwctx *dc)
 	}
 
 	delzw_stop(dc, reason);
+	delzw_flush_output(dc);
 }
 
 static void setup_delzw_common(delzwctx *dc, struct de_lzw_params *delzwp)
@@ -1124,9 +1288,20 @@ static void my_lzw_codec_destroy(struct de_dfilter_ctx *dfctx)
 
 	if(!dc) return;
 
-	de_free(c, dc->ct);
-	if(dc->ct2) de_free(c, dc->ct2);
-	de_free(c, dc->valbuf);
+	if(dc->ct) {
+		de_pool_free(c, DE_OBJPOOL_LZW_TABLE,
+			(i64)dc->ct_capacity * (i64)sizeof(struct delzw_tableentry), dc->ct);
+	}
+	if(dc->ct2) {
+		de_pool_free(c, DE_OBJPOOL_LZW_TABLE2,
+			(i64)dc->ct_capacity * (i64)sizeof(struct delzw_tableentry2), dc->ct2);
+	}
+	if(dc->valbuf) {
+		de_pool_free(c, DE_OBJPOOL_LZW_BUF, (i64)dc->valbuf_capacity, dc->valbuf);
+	}
+	if(dc->outbuf) {
+		de_pool_free(c, DE_OBJPOOL_LZW_BUF, (i64)dc->outbuf_capacity, dc->outbuf);
+	}
 
 	de_free(c, dc);
 	dfctx->codec_private = NULL;
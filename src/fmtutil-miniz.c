@@ -126,6 +126,9 @@ void fmtutil_deflate_codectype1_miniz(deark *c, struct de_dfilter_in_params *dcm
 			nbytes_to_write = dcmpro->expected_len - nbytes_written_total;
 		}
 		dbuf_write(dcmpro->f, outbuf, nbytes_to_write);
+		if(deflparams->crco_for_output) {
+			de_crcobj_addbuf(deflparams->crco_for_output, outbuf, nbytes_to_write);
+		}
 		nbytes_written_total += nbytes_to_write;
 
 		if(ret==MZ_STREAM_END) {